@@ -0,0 +1,262 @@
+/*--------------------------------------------------------------------*/
+/* arena.c                                                            */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <assert.h>
+#include "arena.h"
+
+enum {
+    /* Every block size is rounded up to a multiple of this. */
+    ARENA_ALIGNMENT = 16,
+    /* Number of free lists. Blocks of up to
+    ARENA_ALIGNMENT * SIZE_CLASS_COUNT bytes come from slabs; larger
+    ones get their own allocation. */
+    SIZE_CLASS_COUNT = 32,
+    /* Payload size of the first slab. Each later slab is twice as
+    large as the one before, up to MAX_SLAB_SIZE. */
+    INITIAL_SLAB_SIZE = 4096,
+    MAX_SLAB_SIZE = 8 * 1024 * 1024
+};
+
+/* Largest block size served from a slab. */
+static const size_t MAX_SMALL_SIZE =
+    (size_t)ARENA_ALIGNMENT * SIZE_CLASS_COUNT;
+
+/* Each slab begins with an ArenaSlab header. Slabs are linked so that
+Arena_free can release them. */
+struct ArenaSlab
+{
+    /* The address of the next slab. */
+    struct ArenaSlab *psNextSlab;
+};
+
+/* Each block too large for a slab begins with an ArenaLarge header.
+Large blocks are doubly linked so that a single one can be unlinked
+and freed on release. */
+struct ArenaLarge
+{
+    /* The address of the previous large block. */
+    struct ArenaLarge *psPrevLarge;
+    /* The address of the next large block. */
+    struct ArenaLarge *psNextLarge;
+};
+
+/* A released small block holds an ArenaFreeBlock while it waits on
+its size class's free list. */
+struct ArenaFreeBlock
+{
+    /* The address of the next free block of the same size class. */
+    struct ArenaFreeBlock *psNextFree;
+};
+
+/* An Arena is a list of slabs, the unused tail of the newest slab,
+one free list per size class, and a list of large blocks. */
+struct Arena
+{
+    /* The address of the newest slab. */
+    struct ArenaSlab *psFirstSlab;
+    /* The first unused byte of the newest slab. */
+    char *pcNext;
+    /* One past the last byte of the newest slab. */
+    char *pcEnd;
+    /* Payload size of the next slab to allocate. */
+    size_t uNextSlabSize;
+    /* Free lists, indexed by size class. */
+    struct ArenaFreeBlock *apsFreeLists[SIZE_CLASS_COUNT];
+    /* The address of the first large block. */
+    struct ArenaLarge *psFirstLarge;
+};
+
+/* Return uSize rounded up to a multiple of ARENA_ALIGNMENT. Headers
+are padded the same way so the block after them stays aligned. */
+static size_t Arena_round(size_t uSize)
+{
+    if (uSize == 0)
+    {
+        uSize = 1;
+    }
+    return (uSize + ARENA_ALIGNMENT - 1)
+        & ~((size_t)ARENA_ALIGNMENT - 1);
+}
+
+/* Add a slab with room for at least uSize bytes to oArena. Return 1
+on success, 0 on failure (not enough memory). */
+static int Arena_addSlab(Arena_T oArena, size_t uSize)
+{
+    struct ArenaSlab *psSlab;
+    size_t uSlabSize;
+
+    assert(oArena != NULL);
+
+    uSlabSize = oArena->uNextSlabSize;
+    while (uSlabSize < uSize)
+    {
+        uSlabSize *= 2;
+    }
+
+    psSlab = (struct ArenaSlab*)malloc(
+        Arena_round(sizeof(struct ArenaSlab)) + uSlabSize);
+    if (psSlab == NULL)
+    {
+        return 0;
+    }
+
+    psSlab->psNextSlab = oArena->psFirstSlab;
+    oArena->psFirstSlab = psSlab;
+    oArena->pcNext = (char*)psSlab
+        + Arena_round(sizeof(struct ArenaSlab));
+    oArena->pcEnd = oArena->pcNext + uSlabSize;
+
+    if (oArena->uNextSlabSize < MAX_SLAB_SIZE)
+    {
+        oArena->uNextSlabSize *= 2;
+    }
+    return 1;
+}
+
+Arena_T Arena_new(void)
+{
+    Arena_T oArena;
+    size_t i;
+
+    oArena = (Arena_T)malloc(sizeof(struct Arena));
+    if (oArena == NULL)
+    {
+        return NULL;
+    }
+
+    oArena->psFirstSlab = NULL;
+    oArena->pcNext = NULL;
+    oArena->pcEnd = NULL;
+    oArena->uNextSlabSize = INITIAL_SLAB_SIZE;
+    for (i = 0; i < SIZE_CLASS_COUNT; i++)
+    {
+        oArena->apsFreeLists[i] = NULL;
+    }
+    oArena->psFirstLarge = NULL;
+
+    return oArena;
+}
+
+void Arena_free(Arena_T oArena)
+{
+    struct ArenaSlab *psCurrentSlab;
+    struct ArenaSlab *psNextSlab;
+    struct ArenaLarge *psCurrentLarge;
+    struct ArenaLarge *psNextLarge;
+
+    assert(oArena != NULL);
+
+    for (psCurrentSlab = oArena->psFirstSlab;
+        psCurrentSlab != NULL;
+        psCurrentSlab = psNextSlab)
+    {
+        psNextSlab = psCurrentSlab->psNextSlab;
+        free(psCurrentSlab);
+    }
+
+    for (psCurrentLarge = oArena->psFirstLarge;
+        psCurrentLarge != NULL;
+        psCurrentLarge = psNextLarge)
+    {
+        psNextLarge = psCurrentLarge->psNextLarge;
+        free(psCurrentLarge);
+    }
+
+    free(oArena);
+}
+
+void *Arena_alloc(Arena_T oArena, size_t uSize)
+{
+    struct ArenaLarge *psLarge;
+    struct ArenaFreeBlock *psFree;
+    size_t uRounded;
+    size_t uClass;
+    void *pvBlock;
+
+    assert(oArena != NULL);
+
+    if (uSize > MAX_SMALL_SIZE)
+    {
+        if (uSize > (size_t)-1
+            - Arena_round(sizeof(struct ArenaLarge)))
+        {
+            return NULL;
+        }
+        psLarge = (struct ArenaLarge*)malloc(
+            Arena_round(sizeof(struct ArenaLarge)) + uSize);
+        if (psLarge == NULL)
+        {
+            return NULL;
+        }
+        psLarge->psPrevLarge = NULL;
+        psLarge->psNextLarge = oArena->psFirstLarge;
+        if (oArena->psFirstLarge != NULL)
+        {
+            oArena->psFirstLarge->psPrevLarge = psLarge;
+        }
+        oArena->psFirstLarge = psLarge;
+        return (char*)psLarge
+            + Arena_round(sizeof(struct ArenaLarge));
+    }
+
+    uRounded = Arena_round(uSize);
+    uClass = uRounded / ARENA_ALIGNMENT - 1;
+    psFree = oArena->apsFreeLists[uClass];
+    if (psFree != NULL)
+    {
+        oArena->apsFreeLists[uClass] = psFree->psNextFree;
+        return psFree;
+    }
+
+    if (oArena->pcNext == NULL ||
+        (size_t)(oArena->pcEnd - oArena->pcNext) < uRounded)
+    {
+        if (!Arena_addSlab(oArena, uRounded))
+        {
+            return NULL;
+        }
+    }
+
+    pvBlock = oArena->pcNext;
+    oArena->pcNext += uRounded;
+    return pvBlock;
+}
+
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize)
+{
+    struct ArenaLarge *psLarge;
+    struct ArenaFreeBlock *psFree;
+    size_t uRounded;
+    size_t uClass;
+
+    assert(oArena != NULL);
+    assert(pvBlock != NULL);
+
+    if (uSize > MAX_SMALL_SIZE)
+    {
+        psLarge = (struct ArenaLarge*)((char*)pvBlock
+            - Arena_round(sizeof(struct ArenaLarge)));
+        if (psLarge->psPrevLarge != NULL)
+        {
+            psLarge->psPrevLarge->psNextLarge = psLarge->psNextLarge;
+        }
+        else
+        {
+            oArena->psFirstLarge = psLarge->psNextLarge;
+        }
+        if (psLarge->psNextLarge != NULL)
+        {
+            psLarge->psNextLarge->psPrevLarge = psLarge->psPrevLarge;
+        }
+        free(psLarge);
+        return;
+    }
+
+    uRounded = Arena_round(uSize);
+    uClass = uRounded / ARENA_ALIGNMENT - 1;
+    psFree = (struct ArenaFreeBlock*)pvBlock;
+    psFree->psNextFree = oArena->apsFreeLists[uClass];
+    oArena->apsFreeLists[uClass] = psFree;
+}
@@ -0,0 +1,38 @@
+/*--------------------------------------------------------------------*/
+/* arena.h                                                            */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+/* An Arena_T hands out blocks of memory carved from a few large
+slabs. Released blocks are kept on free lists for reuse, and every
+block is returned to the system at once when the arena is freed. */
+typedef struct Arena *Arena_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Arena_T object, or NULL if insufficient memory is
+available. */
+Arena_T Arena_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oArena and every block that was allocated from it. */
+void Arena_free(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a block of at least uSize bytes from oArena, suitably
+aligned for any node type, or NULL if insufficient memory is
+available. */
+void *Arena_alloc(Arena_T oArena, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* Return pvBlock, which was allocated from oArena with size uSize, to
+oArena for reuse. */
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize);
+
+#endif
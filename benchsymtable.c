@@ -0,0 +1,494 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not C99. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "symtable.h"
+
+/* Usage: benchsymtableX workload [bindings [operations]]
+
+Run one workload against the SymTable implementation this program is
+linked with, and write one line of space separated name=value pairs
+to stdout. Each workload runs in its own process so that its peak
+resident set size is its own. The workloads are:
+
+   hit       lookups of uniformly chosen keys, 90% of them present
+   miss      lookups of uniformly chosen keys, 10% of them present
+   zipf      lookups of Zipf distributed keys, 90% of them present
+   churn     alternating removes and puts at a steady size
+   longkeys  like hit, with 256-character keys sharing a prefix
+   small     lookups spread over many tables of 8 bindings each
+
+Latencies are measured per operation with a monotonic clock, so they
+include the clock's own overhead of a few tens of nanoseconds. */
+
+enum {
+    /* Default number of bindings. */
+    DEFAULT_BINDINGS = 100000,
+    /* Default number of timed operations. */
+    DEFAULT_OPERATIONS = 1000000,
+    /* Room for a key of the short workloads, which is the decimal form
+    of an unsigned long, with its terminator. */
+    SHORT_KEY_SIZE = 24,
+    /* Length of a key of the longkeys workload. */
+    LONG_KEY_LENGTH = 256,
+    /* Number of bindings per table in the small workload. */
+    SMALL_TABLE_BINDINGS = 8,
+    /* Percentage of lookups that hit in the hit-heavy workloads. */
+    HIT_HEAVY_PERCENT = 90,
+    /* Percentage of lookups that hit in the miss-heavy workload. */
+    MISS_HEAVY_PERCENT = 10
+};
+
+/* The keys of a workload, stored at a fixed stride in one block. The
+first uCount keys are bound at the start of a run; the remaining
+uCount keys are never bound at the start, so they serve as misses
+and as fresh keys for churn. */
+struct Keys
+{
+    /* The key characters. */
+    char *pcChars;
+    /* Bytes from the start of one key to the start of the next. */
+    size_t uStride;
+    /* Number of keys in each half. */
+    size_t uCount;
+};
+
+/* State of the xorshift64* random number generator. Fixed so that
+every backend sees the same sequence. */
+static unsigned long long ullRandomState = 0x9E3779B97F4A7C15ull;
+
+/* Return a pseudo-random number. */
+static unsigned long long randomNext(void)
+{
+    ullRandomState ^= ullRandomState >> 12;
+    ullRandomState ^= ullRandomState << 25;
+    ullRandomState ^= ullRandomState >> 27;
+    return ullRandomState * 0x2545F4914F6CDD1Dull;
+}
+
+/* Return a pseudo-random number between 0 and uRange-1. */
+static size_t randomBelow(size_t uRange)
+{
+    assert(uRange > 0);
+
+    return (size_t)(randomNext() % uRange);
+}
+
+/* Return a pseudo-random number between 0 and 1. */
+static double randomUnit(void)
+{
+    return (double)(randomNext() >> 11) / 9007199254740992.0;
+}
+
+/* Return the current time of the monotonic clock in nanoseconds. */
+static unsigned long long nowNs(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (unsigned long long)sTime.tv_sec * 1000000000ull
+        + (unsigned long long)sTime.tv_nsec;
+}
+
+/* Return the peak resident set size of this process, in kilobytes on
+Linux. */
+static long peakRssKb(void)
+{
+    struct rusage sUsage;
+
+    getrusage(RUSAGE_SELF, &sUsage);
+    return sUsage.ru_maxrss;
+}
+
+/* Return the address of key u of psKeys. */
+static const char *keyAt(const struct Keys *psKeys, size_t u)
+{
+    assert(psKeys != NULL);
+
+    return psKeys->pcChars + u * psKeys->uStride;
+}
+
+/* Fill psKeys with 2 * uCount distinct keys. If uLength is 0 each key
+is short; otherwise each key is uLength characters, a common prefix
+followed by the key's number. Return 1 on success, 0 on failure (not
+enough memory). */
+static int makeKeys(struct Keys *psKeys, size_t uCount, size_t uLength)
+{
+    char acNumber[SHORT_KEY_SIZE];
+    char *pcKey;
+    size_t uNumberLength;
+    size_t u;
+
+    assert(psKeys != NULL);
+
+    psKeys->uCount = uCount;
+    psKeys->uStride = uLength == 0 ? SHORT_KEY_SIZE : uLength + 1;
+    psKeys->pcChars = (char*)malloc(2 * uCount * psKeys->uStride);
+    if (psKeys->pcChars == NULL)
+    {
+        return 0;
+    }
+
+    for (u = 0; u < 2 * uCount; u++)
+    {
+        pcKey = psKeys->pcChars + u * psKeys->uStride;
+        sprintf(acNumber, "%lu", (unsigned long)u);
+        if (uLength == 0)
+        {
+            strcpy(pcKey, acNumber);
+            continue;
+        }
+        uNumberLength = strlen(acNumber);
+        memset(pcKey, 'k', uLength - uNumberLength);
+        strcpy(pcKey + uLength - uNumberLength, acNumber);
+    }
+    return 1;
+}
+
+/* Return a table of the cumulative probabilities of ranks 0 through
+uCount-1 under a Zipf distribution with exponent 1, or NULL if
+insufficient memory is available. */
+static double *makeZipf(size_t uCount)
+{
+    double *pdCumulative;
+    double dSum = 0.0;
+    size_t u;
+
+    pdCumulative = (double*)malloc(uCount * sizeof(double));
+    if (pdCumulative == NULL)
+    {
+        return NULL;
+    }
+    for (u = 0; u < uCount; u++)
+    {
+        dSum += 1.0 / (double)(u + 1);
+        pdCumulative[u] = dSum;
+    }
+    for (u = 0; u < uCount; u++)
+    {
+        pdCumulative[u] /= dSum;
+    }
+    return pdCumulative;
+}
+
+/* Return a rank drawn from the Zipf distribution whose cumulative
+probabilities are the uCount values at pdCumulative. */
+static size_t zipfNext(const double *pdCumulative, size_t uCount)
+{
+    double dUnit;
+    size_t uLow = 0;
+    size_t uHigh;
+    size_t uMiddle;
+
+    assert(pdCumulative != NULL);
+
+    dUnit = randomUnit();
+    uHigh = uCount - 1;
+    while (uLow < uHigh)
+    {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if (pdCumulative[uMiddle] < dUnit)
+            uLow = uMiddle + 1;
+        else
+            uHigh = uMiddle;
+    }
+    return uLow;
+}
+
+/* Compare the latencies at pv1 and pv2 for qsort. */
+static int compareSamples(const void *pv1, const void *pv2)
+{
+    unsigned long long ull1 = *(const unsigned long long*)pv1;
+    unsigned long long ull2 = *(const unsigned long long*)pv2;
+
+    return (ull1 > ull2) - (ull1 < ull2);
+}
+
+/* Return the sample at quantile dQuantile of the uCount sorted
+samples at pullSamples. */
+static unsigned long long quantile(
+    const unsigned long long *pullSamples, size_t uCount,
+    double dQuantile)
+{
+    size_t uIndex;
+
+    assert(pullSamples != NULL);
+    assert(uCount > 0);
+
+    uIndex = (size_t)(dQuantile * (double)uCount);
+    if (uIndex >= uCount)
+        uIndex = uCount - 1;
+    return pullSamples[uIndex];
+}
+
+/* Time uOperations lookups in the tables at poTables, storing each
+latency in pullSamples. Key u of psKeys is bound in table
+u / uPerTable. A lookup hits with probability iHitPercent / 100, and
+its key is drawn from pdZipf if that is not NULL, or uniformly
+otherwise. */
+static void runLookups(SymTable_T *poTables, size_t uPerTable,
+    const struct Keys *psKeys, const double *pdZipf, int iHitPercent,
+    unsigned long long *pullSamples, size_t uOperations)
+{
+    unsigned long long ullStart;
+    const char *pcKey;
+    size_t uKey;
+    size_t u;
+    void *pvValue;
+
+    assert(poTables != NULL);
+    assert(psKeys != NULL);
+    assert(pullSamples != NULL);
+
+    for (u = 0; u < uOperations; u++)
+    {
+        if (pdZipf != NULL)
+            uKey = zipfNext(pdZipf, psKeys->uCount);
+        else
+            uKey = randomBelow(psKeys->uCount);
+        /* A miss looks for the matching unbound key, in the table
+        that would hold it. */
+        if (randomBelow(100) >= (size_t)iHitPercent)
+            pcKey = keyAt(psKeys, uKey + psKeys->uCount);
+        else
+            pcKey = keyAt(psKeys, uKey);
+
+        ullStart = nowNs();
+        pvValue = SymTable_get(poTables[uKey / uPerTable], pcKey);
+        pullSamples[u] = nowNs() - ullStart;
+        (void)pvValue;
+    }
+}
+
+/* Time uOperations alternating removes and puts in oSymTable, which
+holds the first half of psKeys, storing each latency in
+pullSamples. Each remove takes out a random bound key and the put that
+follows binds a random unbound one, so the table keeps its size while
+its contents turn over. */
+static void runChurn(SymTable_T oSymTable, const struct Keys *psKeys,
+    unsigned long long *pullSamples, size_t uOperations)
+{
+    unsigned long long ullStart;
+    size_t *puOrder;
+    size_t uBound;
+    size_t uUnbound;
+    size_t uSwap;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(psKeys != NULL);
+    assert(pullSamples != NULL);
+
+    /* puOrder[0..uCount-1] are the bound keys, and the rest are the
+    unbound keys. */
+    puOrder = (size_t*)malloc(2 * psKeys->uCount * sizeof(size_t));
+    if (puOrder == NULL)
+    {
+        fprintf(stderr, "Insufficient memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (u = 0; u < 2 * psKeys->uCount; u++)
+        puOrder[u] = u;
+
+    for (u = 0; u + 1 < uOperations; u += 2)
+    {
+        uBound = randomBelow(psKeys->uCount);
+        uUnbound = psKeys->uCount + randomBelow(psKeys->uCount);
+
+        ullStart = nowNs();
+        (void)SymTable_remove(oSymTable,
+            keyAt(psKeys, puOrder[uBound]));
+        pullSamples[u] = nowNs() - ullStart;
+
+        ullStart = nowNs();
+        (void)SymTable_put(oSymTable, keyAt(psKeys, puOrder[uUnbound]),
+            NULL);
+        pullSamples[u + 1] = nowNs() - ullStart;
+
+        uSwap = puOrder[uBound];
+        puOrder[uBound] = puOrder[uUnbound];
+        puOrder[uUnbound] = uSwap;
+    }
+    free(puOrder);
+}
+
+/* Return the name of the backend, taken from the program name
+pcProgram by dropping any directory and the "benchsymtable"
+prefix. */
+static const char *backendName(const char *pcProgram)
+{
+    const char *pcSlash;
+    const char *pcName = pcProgram;
+
+    assert(pcProgram != NULL);
+
+    pcSlash = strrchr(pcProgram, '/');
+    if (pcSlash != NULL)
+        pcName = pcSlash + 1;
+    if (strncmp(pcName, "benchsymtable", 13) == 0 && pcName[13] != '\0')
+        pcName += 13;
+    return pcName;
+}
+
+/* Run the workload named by argv[1], as described at the top of this
+file. Return 0 on success, or EXIT_FAILURE if the arguments are
+invalid or insufficient memory is available. */
+int main(int argc, char *argv[])
+{
+    struct Keys sKeys;
+    SymTable_T *poTables;
+    double *pdZipf = NULL;
+    unsigned long long *pullSamples;
+    unsigned long long ullTotal = 0;
+    const char *pcWorkload;
+    size_t uBindings = DEFAULT_BINDINGS;
+    size_t uOperations = DEFAULT_OPERATIONS;
+    size_t uPerTable;
+    size_t uTables;
+    size_t u;
+    long lRssBefore;
+    long lRssAfter;
+    int iHitPercent = HIT_HEAVY_PERCENT;
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr,
+            "Usage: %s hit|miss|zipf|churn|longkeys|small "
+            "[bindings [operations]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    pcWorkload = argv[1];
+    if (argc > 2)
+        uBindings = (size_t)strtoul(argv[2], NULL, 10);
+    if (argc > 3)
+        uOperations = (size_t)strtoul(argv[3], NULL, 10);
+    if (uBindings == 0 || uOperations == 0)
+    {
+        fprintf(stderr, "%s: counts must be positive\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (strcmp(pcWorkload, "small") == 0)
+    {
+        uBindings = (uBindings + SMALL_TABLE_BINDINGS - 1)
+            / SMALL_TABLE_BINDINGS * SMALL_TABLE_BINDINGS;
+        uPerTable = SMALL_TABLE_BINDINGS;
+    }
+    else if (strcmp(pcWorkload, "churn") == 0)
+    {
+        /* Removes and puts come in pairs. */
+        uOperations -= uOperations % 2;
+        if (uOperations == 0)
+        {
+            fprintf(stderr, "%s: churn needs two operations\n",
+                argv[0]);
+            return EXIT_FAILURE;
+        }
+        uPerTable = uBindings;
+    }
+    else if (strcmp(pcWorkload, "hit") == 0 ||
+        strcmp(pcWorkload, "miss") == 0 ||
+        strcmp(pcWorkload, "zipf") == 0 ||
+        strcmp(pcWorkload, "longkeys") == 0)
+    {
+        uPerTable = uBindings;
+    }
+    else
+    {
+        fprintf(stderr, "%s: unknown workload %s\n", argv[0],
+            pcWorkload);
+        return EXIT_FAILURE;
+    }
+    uTables = uBindings / uPerTable;
+
+    /* Allocate and touch everything but the tables first, so that the
+    growth of the resident set while building is the tables' own. */
+    pullSamples = (unsigned long long*)
+        calloc(uOperations, sizeof(unsigned long long));
+    poTables = (SymTable_T*)calloc(uTables, sizeof(SymTable_T));
+    if (pullSamples == NULL || poTables == NULL ||
+        !makeKeys(&sKeys, uBindings,
+        strcmp(pcWorkload, "longkeys") == 0 ? LONG_KEY_LENGTH : 0))
+    {
+        fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (strcmp(pcWorkload, "zipf") == 0)
+    {
+        pdZipf = makeZipf(uBindings);
+        if (pdZipf == NULL)
+        {
+            fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    memset(pullSamples, 0, uOperations * sizeof(unsigned long long));
+
+    lRssBefore = peakRssKb();
+    for (u = 0; u < uTables; u++)
+    {
+        poTables[u] = SymTable_new();
+        if (poTables[u] == NULL)
+        {
+            fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    for (u = 0; u < uBindings; u++)
+    {
+        if (!SymTable_put(poTables[u / uPerTable], keyAt(&sKeys, u),
+            NULL))
+        {
+            fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    lRssAfter = peakRssKb();
+
+    if (strcmp(pcWorkload, "churn") == 0)
+    {
+        runChurn(poTables[0], &sKeys, pullSamples, uOperations);
+    }
+    else
+    {
+        if (strcmp(pcWorkload, "miss") == 0)
+            iHitPercent = MISS_HEAVY_PERCENT;
+        runLookups(poTables, uPerTable, &sKeys, pdZipf, iHitPercent,
+            pullSamples, uOperations);
+    }
+
+    for (u = 0; u < uOperations; u++)
+        ullTotal += pullSamples[u];
+    qsort(pullSamples, uOperations, sizeof(unsigned long long),
+        compareSamples);
+
+    printf("backend=%s workload=%s bindings=%lu operations=%lu "
+        "ns_per_op=%.1f p50_ns=%llu p99_ns=%llu p999_ns=%llu "
+        "peak_rss_kb=%ld bytes_per_binding=%.1f\n",
+        backendName(argv[0]), pcWorkload, (unsigned long)uBindings,
+        (unsigned long)uOperations,
+        (double)ullTotal / (double)uOperations,
+        quantile(pullSamples, uOperations, 0.50),
+        quantile(pullSamples, uOperations, 0.99),
+        quantile(pullSamples, uOperations, 0.999),
+        peakRssKb(),
+        (double)(lRssAfter - lRssBefore) * 1024.0 / (double)uBindings);
+
+    for (u = 0; u < uTables; u++)
+        SymTable_free(poTables[u]);
+    free(poTables);
+    free(pdZipf);
+    free(pullSamples);
+    free(sKeys.pcChars);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*--------------------------------------------------------------------*/
+/* concsymtable.c                                                     */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+
+/* posix_memalign is POSIX, not C99. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include "concsymtable.h"
+#include "symtable.h"
+#include "strhash.h"
+
+enum {
+    /* Number of shards when the caller does not choose. */
+    DEFAULT_SHARD_COUNT = 64,
+    /* Size of a cache line. Shards are aligned to a line and padded
+    to at least its size so that threads locking neighboring shards
+    do not contend for the same line. */
+    CACHE_LINE_SIZE = 64
+};
+
+/* A shard is a SymTable_T and the mutex that guards it. Every
+operation on a SymTable_T, lookups included, is a write: the chained
+backend moves buckets during lookups while it resizes. So a plain
+mutex serves as well as a reader-writer lock and is cheaper. */
+union ConcSymTableShard
+{
+    struct
+    {
+        /* Guards oSymTable. */
+        pthread_mutex_t sMutex;
+        /* The bindings whose keys map to this shard. */
+        SymTable_T oSymTable;
+    } sShard;
+    /* Padding up to a cache line. */
+    char acPad[CACHE_LINE_SIZE];
+};
+
+/* A ConcSymTable is an array of shards. */
+struct ConcSymTable
+{
+    /* Pointer to the array of shards. */
+    union ConcSymTableShard *puShards;
+    /* Number of shards. */
+    size_t uShardCount;
+};
+
+/* Return the shard of oConcSymTable that holds pcKey. Shards are
+chosen with StrHash_word, which is unrelated to the hash codes the
+shards themselves use, so every shard's buckets stay evenly
+filled. */
+static union ConcSymTableShard *ConcSymTable_shard(
+    ConcSymTable_T oConcSymTable, const char *pcKey)
+{
+    assert(oConcSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return &oConcSymTable->puShards[StrHash_reduce(
+        StrHash_word(pcKey, strlen(pcKey)),
+        oConcSymTable->uShardCount)];
+}
+
+/* Lock puShard. */
+static void ConcSymTable_lock(union ConcSymTableShard *puShard)
+{
+    int iResult;
+
+    assert(puShard != NULL);
+
+    iResult = pthread_mutex_lock(&puShard->sShard.sMutex);
+    assert(iResult == 0);
+    (void)iResult;
+}
+
+/* Unlock puShard. */
+static void ConcSymTable_unlock(union ConcSymTableShard *puShard)
+{
+    int iResult;
+
+    assert(puShard != NULL);
+
+    iResult = pthread_mutex_unlock(&puShard->sShard.sMutex);
+    assert(iResult == 0);
+    (void)iResult;
+}
+
+ConcSymTable_T ConcSymTable_new(size_t uShardCount)
+{
+    ConcSymTable_T oConcSymTable;
+    union ConcSymTableShard *puShard;
+    void *pvShards;
+    size_t i;
+
+    if (uShardCount == 0)
+    {
+        uShardCount = DEFAULT_SHARD_COUNT;
+    }
+
+    oConcSymTable = (ConcSymTable_T)malloc(sizeof(struct ConcSymTable));
+    if (oConcSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* calloc aligns only to 16 bytes, which would let neighboring
+    shards share a line. Every shard is initialized below. */
+    if (uShardCount > (size_t)-1 / sizeof(union ConcSymTableShard) ||
+        posix_memalign(&pvShards, CACHE_LINE_SIZE,
+            uShardCount * sizeof(union ConcSymTableShard)) != 0)
+    {
+        free(oConcSymTable);
+        return NULL;
+    }
+    oConcSymTable->puShards = (union ConcSymTableShard*)pvShards;
+
+    for (i = 0; i < uShardCount; i++)
+    {
+        puShard = &oConcSymTable->puShards[i];
+        puShard->sShard.oSymTable = SymTable_new();
+        if (puShard->sShard.oSymTable == NULL)
+        {
+            break;
+        }
+        if (pthread_mutex_init(&puShard->sShard.sMutex, NULL) != 0)
+        {
+            SymTable_free(puShard->sShard.oSymTable);
+            break;
+        }
+    }
+    oConcSymTable->uShardCount = i;
+
+    /* Undo a partial construction. */
+    if (i < uShardCount)
+    {
+        ConcSymTable_free(oConcSymTable);
+        return NULL;
+    }
+    return oConcSymTable;
+}
+
+void ConcSymTable_free(ConcSymTable_T oConcSymTable)
+{
+    union ConcSymTableShard *puShard;
+    size_t i;
+
+    assert(oConcSymTable != NULL);
+
+    for (i = 0; i < oConcSymTable->uShardCount; i++)
+    {
+        puShard = &oConcSymTable->puShards[i];
+        pthread_mutex_destroy(&puShard->sShard.sMutex);
+        SymTable_free(puShard->sShard.oSymTable);
+    }
+    free(oConcSymTable->puShards);
+    free(oConcSymTable);
+}
+
+size_t ConcSymTable_getLength(ConcSymTable_T oConcSymTable)
+{
+    union ConcSymTableShard *puShard;
+    size_t uLength = 0;
+    size_t i;
+
+    assert(oConcSymTable != NULL);
+
+    for (i = 0; i < oConcSymTable->uShardCount; i++)
+    {
+        puShard = &oConcSymTable->puShards[i];
+        ConcSymTable_lock(puShard);
+        uLength += SymTable_getLength(puShard->sShard.oSymTable);
+        ConcSymTable_unlock(puShard);
+    }
+    return uLength;
+}
+
+int ConcSymTable_put(ConcSymTable_T oConcSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    union ConcSymTableShard *puShard;
+    int iSuccessful;
+
+    puShard = ConcSymTable_shard(oConcSymTable, pcKey);
+    ConcSymTable_lock(puShard);
+    iSuccessful = SymTable_put(puShard->sShard.oSymTable, pcKey,
+        pvValue);
+    ConcSymTable_unlock(puShard);
+    return iSuccessful;
+}
+
+void *ConcSymTable_replace(ConcSymTable_T oConcSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    union ConcSymTableShard *puShard;
+    void *pvValueOld;
+
+    puShard = ConcSymTable_shard(oConcSymTable, pcKey);
+    ConcSymTable_lock(puShard);
+    pvValueOld = SymTable_replace(puShard->sShard.oSymTable, pcKey,
+        pvValue);
+    ConcSymTable_unlock(puShard);
+    return pvValueOld;
+}
+
+int ConcSymTable_contains(ConcSymTable_T oConcSymTable,
+    const char *pcKey)
+{
+    union ConcSymTableShard *puShard;
+    int iFound;
+
+    puShard = ConcSymTable_shard(oConcSymTable, pcKey);
+    ConcSymTable_lock(puShard);
+    iFound = SymTable_contains(puShard->sShard.oSymTable, pcKey);
+    ConcSymTable_unlock(puShard);
+    return iFound;
+}
+
+void *ConcSymTable_get(ConcSymTable_T oConcSymTable, const char *pcKey)
+{
+    union ConcSymTableShard *puShard;
+    void *pvValue;
+
+    puShard = ConcSymTable_shard(oConcSymTable, pcKey);
+    ConcSymTable_lock(puShard);
+    pvValue = SymTable_get(puShard->sShard.oSymTable, pcKey);
+    ConcSymTable_unlock(puShard);
+    return pvValue;
+}
+
+void *ConcSymTable_remove(ConcSymTable_T oConcSymTable,
+    const char *pcKey)
+{
+    union ConcSymTableShard *puShard;
+    void *pvRemovedValue;
+
+    puShard = ConcSymTable_shard(oConcSymTable, pcKey);
+    ConcSymTable_lock(puShard);
+    pvRemovedValue = SymTable_remove(puShard->sShard.oSymTable, pcKey);
+    ConcSymTable_unlock(puShard);
+    return pvRemovedValue;
+}
+
+void ConcSymTable_map(ConcSymTable_T oConcSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    union ConcSymTableShard *puShard;
+    size_t i;
+
+    assert(oConcSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oConcSymTable->uShardCount; i++)
+    {
+        puShard = &oConcSymTable->puShards[i];
+        ConcSymTable_lock(puShard);
+        SymTable_map(puShard->sShard.oSymTable, pfApply, pvExtra);
+        ConcSymTable_unlock(puShard);
+    }
+}
@@ -0,0 +1,62 @@
+/*--------------------------------------------------------------------*/
+/* concsymtable.h                                                     */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef CONCSYMTABLE_H
+#define CONCSYMTABLE_H
+#include <stddef.h>
+
+/* A ConcSymTable_T is a SymTable_T that many threads may use at once.
+Its keys are split among shards, each an independent SymTable_T with
+its own lock, so threads working on different shards never wait for
+one another and each shard grows on its own. The functions below
+behave like the SymTable functions of the same names. */
+typedef struct ConcSymTable *ConcSymTable_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new ConcSymTable_T object with uShardCount shards, or a
+default number of shards if uShardCount is 0. Return NULL if
+insufficient memory is available. A few shards per thread keep lock
+contention low. */
+ConcSymTable_T ConcSymTable_new(size_t uShardCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oConcSymTable. No other thread may be using it. */
+void ConcSymTable_free(ConcSymTable_T oConcSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings in oConcSymTable. While other threads
+are putting or removing bindings, the result is only approximate. */
+size_t ConcSymTable_getLength(ConcSymTable_T oConcSymTable);
+
+/*--------------------------------------------------------------------*/
+
+int ConcSymTable_put(ConcSymTable_T oConcSymTable,
+    const char *pcKey, const void *pvValue);
+
+void *ConcSymTable_replace(ConcSymTable_T oConcSymTable,
+    const char *pcKey, const void *pvValue);
+
+int ConcSymTable_contains(ConcSymTable_T oConcSymTable,
+    const char *pcKey);
+
+void *ConcSymTable_get(ConcSymTable_T oConcSymTable, const char *pcKey);
+
+void *ConcSymTable_remove(ConcSymTable_T oConcSymTable,
+    const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oConcSymTable, passing
+pvExtra as an extra parameter. Each shard is locked while its bindings
+are visited, so *pfApply must not call back into oConcSymTable.
+Bindings put or removed in other shards meanwhile may or may not be
+visited. */
+void ConcSymTable_map(ConcSymTable_T oConcSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+#endif
@@ -0,0 +1,176 @@
+/*--------------------------------------------------------------------*/
+/* parallel.c                                                         */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "parallel.h"
+
+/* Workers claim tasks with the GCC __atomic builtins, which C99
+lacks. */
+#if !defined(__GNUC__)
+#error "parallel.c requires the GCC __atomic builtins"
+#endif
+
+enum {
+    /* Size of a cache line. Shares are padded to at least this size
+    so that workers claiming tasks from different shares do not
+    contend for the same line. */
+    CACHE_LINE_SIZE = 64
+};
+
+/* A share is the range of tasks a worker starts on. Any worker may
+claim the next task of any share. */
+union ParallelShare
+{
+    struct
+    {
+        /* The next unclaimed task. May run past uEnd, which means
+        the share is used up. */
+        size_t uNext;
+        /* One past the last task of the share. */
+        size_t uEnd;
+    } sShare;
+    /* Padding up to a cache line. */
+    char acPad[CACHE_LINE_SIZE];
+};
+
+/* The state of one parallel run. */
+struct ParallelRun
+{
+    /* The shares of the tasks, one per worker. */
+    union ParallelShare *puShares;
+    /* Number of workers and shares. */
+    size_t uWorkerCount;
+    /* The function that performs a task. */
+    Parallel_Task pfTask;
+    /* The context passed to pfTask. */
+    void *pvContext;
+};
+
+/* What a worker thread is told: its run and its number. */
+struct ParallelWorker
+{
+    /* The run the worker belongs to. */
+    struct ParallelRun *psRun;
+    /* The worker's number. */
+    size_t uWorker;
+};
+
+/* Perform tasks of the run psRun as worker uWorker until no share has
+tasks left: first the worker's own share, then the others in turn. */
+static void Parallel_work(struct ParallelRun *psRun, size_t uWorker)
+{
+    union ParallelShare *puShare;
+    size_t uTask;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    for (i = 0; i < psRun->uWorkerCount; i++)
+    {
+        puShare = &psRun->puShares[(uWorker + i) % psRun->uWorkerCount];
+        for (;;)
+        {
+            uTask = __atomic_fetch_add(&puShare->sShare.uNext, 1,
+                __ATOMIC_RELAXED);
+            if (uTask >= puShare->sShare.uEnd)
+            {
+                break;
+            }
+            (*psRun->pfTask)(psRun->pvContext, uTask, uWorker);
+        }
+    }
+}
+
+/* Run the worker described by pvWorker, a struct ParallelWorker.
+Return NULL. */
+static void *Parallel_thread(void *pvWorker)
+{
+    struct ParallelWorker *psWorker = (struct ParallelWorker*)pvWorker;
+
+    assert(psWorker != NULL);
+
+    Parallel_work(psWorker->psRun, psWorker->uWorker);
+    return NULL;
+}
+
+void Parallel_run(size_t uTaskCount, size_t uWorkerCount,
+    Parallel_Task pfTask, void *pvContext)
+{
+    struct ParallelRun sRun;
+    struct ParallelWorker *psWorkers;
+    pthread_t *psThreads;
+    int *piStarted;
+    size_t i;
+
+    assert(uWorkerCount > 0);
+    assert(pfTask != NULL);
+
+    if (uWorkerCount > uTaskCount)
+    {
+        uWorkerCount = uTaskCount;
+    }
+    if (uWorkerCount <= 1)
+    {
+        for (i = 0; i < uTaskCount; i++)
+        {
+            (*pfTask)(pvContext, i, 0);
+        }
+        return;
+    }
+
+    sRun.puShares = (union ParallelShare*)
+        calloc(uWorkerCount, sizeof(union ParallelShare));
+    psWorkers = (struct ParallelWorker*)
+        calloc(uWorkerCount, sizeof(struct ParallelWorker));
+    psThreads = (pthread_t*)calloc(uWorkerCount, sizeof(pthread_t));
+    piStarted = (int*)calloc(uWorkerCount, sizeof(int));
+    if (sRun.puShares == NULL || psWorkers == NULL ||
+        psThreads == NULL || piStarted == NULL)
+    {
+        /* Without room to run in parallel, run serially. */
+        free(sRun.puShares);
+        free(psWorkers);
+        free(psThreads);
+        free(piStarted);
+        for (i = 0; i < uTaskCount; i++)
+        {
+            (*pfTask)(pvContext, i, 0);
+        }
+        return;
+    }
+
+    sRun.uWorkerCount = uWorkerCount;
+    sRun.pfTask = pfTask;
+    sRun.pvContext = pvContext;
+    for (i = 0; i < uWorkerCount; i++)
+    {
+        sRun.puShares[i].sShare.uNext = uTaskCount / uWorkerCount * i;
+        sRun.puShares[i].sShare.uEnd =
+            uTaskCount / uWorkerCount * (i + 1);
+    }
+    sRun.puShares[uWorkerCount - 1].sShare.uEnd = uTaskCount;
+
+    for (i = 1; i < uWorkerCount; i++)
+    {
+        psWorkers[i].psRun = &sRun;
+        psWorkers[i].uWorker = i;
+        piStarted[i] = pthread_create(&psThreads[i], NULL,
+            Parallel_thread, &psWorkers[i]) == 0;
+    }
+    Parallel_work(&sRun, 0);
+    for (i = 1; i < uWorkerCount; i++)
+    {
+        if (piStarted[i])
+        {
+            pthread_join(psThreads[i], NULL);
+        }
+    }
+
+    free(sRun.puShares);
+    free(psWorkers);
+    free(psThreads);
+    free(piStarted);
+}
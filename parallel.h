@@ -0,0 +1,27 @@
+/*--------------------------------------------------------------------*/
+/* parallel.h                                                         */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <stddef.h>
+
+/* A Parallel_Task performs task uTask of a parallel run on behalf of
+worker uWorker, given the run's context pvContext. */
+typedef void (*Parallel_Task)(void *pvContext, size_t uTask,
+    size_t uWorker);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfTask)(pvContext, uTask, uWorker) exactly once for each
+uTask from 0 to uTaskCount-1, spread over uWorkerCount workers
+numbered from 0, and return when every task is done. The calling
+thread is worker 0 and the rest are new threads. Each worker starts
+on its own contiguous share of the tasks and, once that runs out,
+steals tasks from the shares of the others, so uneven tasks still
+keep every worker busy. If a thread cannot be started, the other
+workers do its share. */
+void Parallel_run(size_t uTaskCount, size_t uWorkerCount,
+    Parallel_Task pfTask, void *pvContext);
+
+#endif
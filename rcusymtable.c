@@ -0,0 +1,750 @@
+/*--------------------------------------------------------------------*/
+/* rcusymtable.c                                                      */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+
+/* posix_memalign is POSIX, not C99. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include "rcusymtable.h"
+#include "strhash.h"
+
+/* Lookups share memory with writers through the GCC __atomic
+builtins, which C99 lacks. */
+#if !defined(__GNUC__)
+#error "rcusymtable.c requires the GCC __atomic builtins"
+#endif
+
+/* Number of buckets in a new RcuSymTable. */
+static const size_t INITIAL_BUCKET_COUNT = 509;
+
+enum {
+    /* Size of a cache line. Readers are aligned to a line and padded
+    to at least its size so that lookups on different threads never
+    write to the same line. */
+    CACHE_LINE_SIZE = 64
+};
+
+/* Each binding is stored in an RcuSymTableNode, laid out like the
+nodes of symtablehash.c. A node is never changed after it is
+published, except for its value and its link to the next node. */
+struct RcuSymTableNode
+{
+    /* The full hash code of acKey. */
+    size_t uHash;
+    /* The value of the binding. */
+    const void *pvValue;
+    /* The address of the next binding in the bucket. */
+    struct RcuSymTableNode *psNextNode;
+    /* The number of characters in the key, not counting the null
+    terminator. */
+    size_t uKeyLength;
+    /* The key of the binding. */
+    char acKey[];
+};
+
+/* A bucket array and its size, published together through a single
+pointer so that a lookup always sees a matching pair. */
+struct RcuSymTableBuckets
+{
+    /* Number of buckets. */
+    size_t uBucketCount;
+    /* The first binding of each bucket. */
+    struct RcuSymTableNode *apsBuckets[];
+};
+
+/* A block that a writer has unlinked but that a lookup may still be
+reading. */
+struct RcuSymTableRetired
+{
+    /* The node or bucket array. */
+    void *pvBlock;
+    /* 1 (TRUE) if pvBlock is a bucket array whose nodes are retired
+    with it, or 0 (FALSE) if it is a node. */
+    int iIsBuckets;
+    /* The table's epoch when pvBlock was unlinked. */
+    size_t uEpoch;
+    /* The address of the next retired block. */
+    struct RcuSymTableRetired *psNextRetired;
+};
+
+/* A reader records the epoch at which its current lookup began, so
+that writers know which retired blocks it might still be reading. */
+union RcuSymTableReaderPad
+{
+    struct RcuSymTableReader
+    {
+        /* The table's epoch when the current lookup began, or 0 if
+        no lookup is in progress. Written only by the reader's
+        thread. */
+        size_t uEpoch;
+        /* The table the reader belongs to. */
+        RcuSymTable_T oRcuSymTable;
+        /* 1 (TRUE) if a thread holds the reader, or 0 (FALSE) if it
+        may be handed out again. */
+        int iInUse;
+        /* The address of the table's next reader. */
+        struct RcuSymTableReader *psNextReader;
+    } sReader;
+    /* Padding up to a cache line. */
+    char acPad[CACHE_LINE_SIZE];
+};
+
+/* An RcuSymTable is a published bucket array, a lock that writers
+share, the readers, and the blocks waiting for readers to move on. */
+struct RcuSymTable
+{
+    /* The current bucket array. */
+    struct RcuSymTableBuckets *psBuckets;
+    /* Number of bindings in the table. */
+    size_t uLength;
+    /* The current epoch, which starts at 1 and is advanced by a
+    writer each time it retires blocks. */
+    size_t uEpoch;
+    /* Serializes writers. */
+    pthread_mutex_t sMutex;
+    /* The address of the first reader. */
+    struct RcuSymTableReader *psFirstReader;
+    /* The address of the most recently retired block. */
+    struct RcuSymTableRetired *psFirstRetired;
+};
+
+/* Return the bucket, among uBucketCount buckets, for full hash code
+uHash. */
+static size_t RcuSymTable_bucket(size_t uHash, size_t uBucketCount)
+{
+    return StrHash_reduce(uHash, uBucketCount);
+}
+
+/* Return a new bucket array of uBucketCount empty buckets, or NULL
+if insufficient memory is available. */
+static struct RcuSymTableBuckets *RcuSymTable_newBuckets(
+    size_t uBucketCount)
+{
+    struct RcuSymTableBuckets *psBuckets;
+
+    if (uBucketCount > ((size_t)-1 - sizeof(struct RcuSymTableBuckets))
+        / sizeof(struct RcuSymTableNode*))
+    {
+        return NULL;
+    }
+    psBuckets = (struct RcuSymTableBuckets*)calloc(1,
+        sizeof(struct RcuSymTableBuckets)
+        + uBucketCount * sizeof(struct RcuSymTableNode*));
+    if (psBuckets == NULL)
+    {
+        return NULL;
+    }
+    psBuckets->uBucketCount = uBucketCount;
+    return psBuckets;
+}
+
+/* Free psBuckets and every node chained in it. */
+static void RcuSymTable_freeBuckets(
+    struct RcuSymTableBuckets *psBuckets)
+{
+    struct RcuSymTableNode *psCurrentNode;
+    struct RcuSymTableNode *psNextNode;
+    size_t i;
+
+    assert(psBuckets != NULL);
+
+    for (i = 0; i < psBuckets->uBucketCount; i++)
+    {
+        for (psCurrentNode = psBuckets->apsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->psNextNode;
+            free(psCurrentNode);
+        }
+    }
+    free(psBuckets);
+}
+
+/* Free the block of psRetired, but not psRetired itself. */
+static void RcuSymTable_freeRetired(
+    struct RcuSymTableRetired *psRetired)
+{
+    assert(psRetired != NULL);
+
+    if (psRetired->iIsBuckets)
+        RcuSymTable_freeBuckets(
+            (struct RcuSymTableBuckets*)psRetired->pvBlock);
+    else
+        free(psRetired->pvBlock);
+}
+
+/* Return a new node holding a copy of the uLength characters at
+pcKey, with full hash code uHash and value pvValue, or NULL if
+insufficient memory is available. */
+static struct RcuSymTableNode *RcuSymTable_newNode(const char *pcKey,
+    size_t uLength, size_t uHash, const void *pvValue)
+{
+    struct RcuSymTableNode *psNode;
+
+    assert(pcKey != NULL);
+
+    /* +1 at the end marks the null terminator character. */
+    psNode = (struct RcuSymTableNode*)malloc(
+        offsetof(struct RcuSymTableNode, acKey) + uLength + 1);
+    if (psNode == NULL)
+    {
+        return NULL;
+    }
+    psNode->uHash = uHash;
+    psNode->pvValue = pvValue;
+    psNode->psNextNode = NULL;
+    psNode->uKeyLength = uLength;
+    memcpy(psNode->acKey, pcKey, uLength);
+    psNode->acKey[uLength] = '\0';
+    return psNode;
+}
+
+/* Return the smallest epoch at which a lookup of oRcuSymTable that is
+still in progress began, or the current epoch if there is none. */
+static size_t RcuSymTable_oldestEpoch(RcuSymTable_T oRcuSymTable)
+{
+    struct RcuSymTableReader *psReader;
+    size_t uOldest;
+    size_t uEpoch;
+
+    assert(oRcuSymTable != NULL);
+
+    uOldest = oRcuSymTable->uEpoch;
+    for (psReader = oRcuSymTable->psFirstReader;
+        psReader != NULL;
+        psReader = psReader->psNextReader)
+    {
+        uEpoch = __atomic_load_n(&psReader->uEpoch, __ATOMIC_SEQ_CST);
+        if (uEpoch != 0 && uEpoch < uOldest)
+        {
+            uOldest = uEpoch;
+        }
+    }
+    return uOldest;
+}
+
+/* Advance the epoch of oRcuSymTable, then free every retired block
+that no lookup in progress can still be reading: those retired before
+the oldest lookup began. The caller must hold the writers' lock. */
+static void RcuSymTable_reclaim(RcuSymTable_T oRcuSymTable)
+{
+    struct RcuSymTableRetired **ppsLink;
+    struct RcuSymTableRetired *psRetired;
+    size_t uOldest;
+
+    assert(oRcuSymTable != NULL);
+
+    /* Lookups that begin after this store see every unlink that came
+    before it, so they cannot reach a block retired earlier. */
+    __atomic_store_n(&oRcuSymTable->uEpoch, oRcuSymTable->uEpoch + 1,
+        __ATOMIC_SEQ_CST);
+    uOldest = RcuSymTable_oldestEpoch(oRcuSymTable);
+
+    ppsLink = &oRcuSymTable->psFirstRetired;
+    while (*ppsLink != NULL)
+    {
+        psRetired = *ppsLink;
+        if (psRetired->uEpoch < uOldest)
+        {
+            *ppsLink = psRetired->psNextRetired;
+            RcuSymTable_freeRetired(psRetired);
+            free(psRetired);
+        }
+        else
+        {
+            ppsLink = &psRetired->psNextRetired;
+        }
+    }
+}
+
+/* Free pvBlock, a node (iIsBuckets is 0) or a bucket array with its
+nodes (iIsBuckets is 1) that the caller has just unlinked from
+oRcuSymTable, once no lookup can be reading it. The caller must hold
+the writers' lock. */
+static void RcuSymTable_retire(RcuSymTable_T oRcuSymTable,
+    void *pvBlock, int iIsBuckets)
+{
+    struct RcuSymTableRetired *psRetired;
+    struct RcuSymTableRetired sRetired;
+    size_t uEpoch;
+
+    assert(oRcuSymTable != NULL);
+    assert(pvBlock != NULL);
+
+    /* Order the unlink before the loads of the readers' epochs, as
+    each lookup orders its epoch store before its loads of links. */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uEpoch = oRcuSymTable->uEpoch;
+
+    psRetired = (struct RcuSymTableRetired*)
+        malloc(sizeof(struct RcuSymTableRetired));
+    if (psRetired == NULL)
+    {
+        /* With nowhere to record the block, wait until every lookup
+        that might see it has finished, then free it at once. */
+        __atomic_store_n(&oRcuSymTable->uEpoch, uEpoch + 1,
+            __ATOMIC_SEQ_CST);
+        while (RcuSymTable_oldestEpoch(oRcuSymTable) <= uEpoch)
+        {
+        }
+        sRetired.pvBlock = pvBlock;
+        sRetired.iIsBuckets = iIsBuckets;
+        RcuSymTable_freeRetired(&sRetired);
+        return;
+    }
+
+    psRetired->pvBlock = pvBlock;
+    psRetired->iIsBuckets = iIsBuckets;
+    psRetired->uEpoch = uEpoch;
+    psRetired->psNextRetired = oRcuSymTable->psFirstRetired;
+    oRcuSymTable->psFirstRetired = psRetired;
+
+    RcuSymTable_reclaim(oRcuSymTable);
+}
+
+/* Replace the bucket array of oRcuSymTable with one of twice as many
+buckets holding copies of every node. Lookups may be walking the old
+chains, so their links are left alone; the old array and its nodes
+are retired together. Return 1 on success, 0 on failure (not enough
+memory). The caller must hold the writers' lock. */
+static int RcuSymTable_expand(RcuSymTable_T oRcuSymTable)
+{
+    struct RcuSymTableBuckets *psOld;
+    struct RcuSymTableBuckets *psNew;
+    struct RcuSymTableNode *psCurrentNode;
+    struct RcuSymTableNode *psCopy;
+    size_t uIndex;
+    size_t i;
+
+    assert(oRcuSymTable != NULL);
+
+    psOld = oRcuSymTable->psBuckets;
+    if (psOld->uBucketCount > (size_t)-1 / 2)
+    {
+        return 0;
+    }
+    psNew = RcuSymTable_newBuckets(psOld->uBucketCount * 2);
+    if (psNew == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < psOld->uBucketCount; i++)
+    {
+        for (psCurrentNode = psOld->apsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+        {
+            psCopy = RcuSymTable_newNode(psCurrentNode->acKey,
+                psCurrentNode->uKeyLength, psCurrentNode->uHash,
+                psCurrentNode->pvValue);
+            if (psCopy == NULL)
+            {
+                RcuSymTable_freeBuckets(psNew);
+                return 0;
+            }
+            uIndex = RcuSymTable_bucket(psCopy->uHash,
+                psNew->uBucketCount);
+            psCopy->psNextNode = psNew->apsBuckets[uIndex];
+            psNew->apsBuckets[uIndex] = psCopy;
+        }
+    }
+
+    __atomic_store_n(&oRcuSymTable->psBuckets, psNew,
+        __ATOMIC_RELEASE);
+    RcuSymTable_retire(oRcuSymTable, psOld, 1);
+    return 1;
+}
+
+/* Return the address of the link that points to the binding in
+oRcuSymTable whose key is the uLength characters at pcKey, with full
+hash code uHash, or NULL if no such binding exists. The caller must
+hold the writers' lock. */
+static struct RcuSymTableNode **RcuSymTable_findLink(
+    RcuSymTable_T oRcuSymTable, const char *pcKey, size_t uLength,
+    size_t uHash)
+{
+    struct RcuSymTableBuckets *psBuckets;
+    struct RcuSymTableNode **ppsLink;
+
+    assert(oRcuSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psBuckets = oRcuSymTable->psBuckets;
+    for (ppsLink = &psBuckets->apsBuckets[RcuSymTable_bucket(uHash,
+        psBuckets->uBucketCount)];
+        *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNextNode)
+    {
+        if ((*ppsLink)->uHash == uHash &&
+            (*ppsLink)->uKeyLength == uLength &&
+            memcmp((*ppsLink)->acKey, pcKey, uLength) == 0)
+        {
+            return ppsLink;
+        }
+    }
+    return NULL;
+}
+
+/* Lock the writers' lock of oRcuSymTable. */
+static void RcuSymTable_lock(RcuSymTable_T oRcuSymTable)
+{
+    int iResult;
+
+    assert(oRcuSymTable != NULL);
+
+    iResult = pthread_mutex_lock(&oRcuSymTable->sMutex);
+    assert(iResult == 0);
+    (void)iResult;
+}
+
+/* Unlock the writers' lock of oRcuSymTable. */
+static void RcuSymTable_unlock(RcuSymTable_T oRcuSymTable)
+{
+    int iResult;
+
+    assert(oRcuSymTable != NULL);
+
+    iResult = pthread_mutex_unlock(&oRcuSymTable->sMutex);
+    assert(iResult == 0);
+    (void)iResult;
+}
+
+RcuSymTable_T RcuSymTable_new(void)
+{
+    RcuSymTable_T oRcuSymTable;
+
+    oRcuSymTable = (RcuSymTable_T)malloc(sizeof(struct RcuSymTable));
+    if (oRcuSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oRcuSymTable->psBuckets =
+        RcuSymTable_newBuckets(INITIAL_BUCKET_COUNT);
+    if (oRcuSymTable->psBuckets == NULL)
+    {
+        free(oRcuSymTable);
+        return NULL;
+    }
+    if (pthread_mutex_init(&oRcuSymTable->sMutex, NULL) != 0)
+    {
+        free(oRcuSymTable->psBuckets);
+        free(oRcuSymTable);
+        return NULL;
+    }
+
+    oRcuSymTable->uLength = 0;
+    oRcuSymTable->uEpoch = 1;
+    oRcuSymTable->psFirstReader = NULL;
+    oRcuSymTable->psFirstRetired = NULL;
+
+    return oRcuSymTable;
+}
+
+void RcuSymTable_free(RcuSymTable_T oRcuSymTable)
+{
+    struct RcuSymTableReader *psReader;
+    struct RcuSymTableReader *psNextReader;
+    struct RcuSymTableRetired *psRetired;
+    struct RcuSymTableRetired *psNextRetired;
+
+    assert(oRcuSymTable != NULL);
+
+    for (psRetired = oRcuSymTable->psFirstRetired;
+        psRetired != NULL;
+        psRetired = psNextRetired)
+    {
+        psNextRetired = psRetired->psNextRetired;
+        RcuSymTable_freeRetired(psRetired);
+        free(psRetired);
+    }
+
+    for (psReader = oRcuSymTable->psFirstReader;
+        psReader != NULL;
+        psReader = psNextReader)
+    {
+        psNextReader = psReader->psNextReader;
+        free(psReader);
+    }
+
+    RcuSymTable_freeBuckets(oRcuSymTable->psBuckets);
+    pthread_mutex_destroy(&oRcuSymTable->sMutex);
+    free(oRcuSymTable);
+}
+
+RcuSymTableReader_T RcuSymTable_newReader(RcuSymTable_T oRcuSymTable)
+{
+    struct RcuSymTableReader *psReader;
+    void *pvReader;
+
+    assert(oRcuSymTable != NULL);
+
+    RcuSymTable_lock(oRcuSymTable);
+
+    /* Hand out a reader that was given back, if there is one. */
+    for (psReader = oRcuSymTable->psFirstReader;
+        psReader != NULL;
+        psReader = psReader->psNextReader)
+    {
+        if (!psReader->iInUse)
+        {
+            psReader->iInUse = 1;
+            RcuSymTable_unlock(oRcuSymTable);
+            return psReader;
+        }
+    }
+
+    /* malloc aligns only to 16 bytes, which would let two readers
+    share a line. */
+    psReader = NULL;
+    if (posix_memalign(&pvReader, CACHE_LINE_SIZE,
+        sizeof(union RcuSymTableReaderPad)) == 0)
+    {
+        psReader = (struct RcuSymTableReader*)pvReader;
+        psReader->uEpoch = 0;
+        psReader->oRcuSymTable = oRcuSymTable;
+        psReader->iInUse = 1;
+        psReader->psNextReader = oRcuSymTable->psFirstReader;
+        oRcuSymTable->psFirstReader = psReader;
+    }
+
+    RcuSymTable_unlock(oRcuSymTable);
+    return psReader;
+}
+
+void RcuSymTable_freeReader(RcuSymTableReader_T oReader)
+{
+    RcuSymTable_T oRcuSymTable;
+
+    assert(oReader != NULL);
+    assert(oReader->uEpoch == 0);
+
+    oRcuSymTable = oReader->oRcuSymTable;
+    RcuSymTable_lock(oRcuSymTable);
+    oReader->iInUse = 0;
+    RcuSymTable_unlock(oRcuSymTable);
+}
+
+size_t RcuSymTable_getLength(RcuSymTable_T oRcuSymTable)
+{
+    assert(oRcuSymTable != NULL);
+
+    return __atomic_load_n(&oRcuSymTable->uLength, __ATOMIC_RELAXED);
+}
+
+int RcuSymTable_put(RcuSymTable_T oRcuSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct RcuSymTableBuckets *psBuckets;
+    struct RcuSymTableNode *psNewNode;
+    size_t uLength;
+    size_t uHash;
+    size_t uIndex;
+
+    assert(oRcuSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = StrHash_word(pcKey, uLength);
+
+    RcuSymTable_lock(oRcuSymTable);
+
+    if (RcuSymTable_findLink(oRcuSymTable, pcKey, uLength, uHash)
+        != NULL)
+    {
+        RcuSymTable_unlock(oRcuSymTable);
+        return 0;
+    }
+
+    /* Expand once there is a binding per bucket. If expansion fails
+    the table keeps working with longer chains. */
+    if (oRcuSymTable->uLength >= oRcuSymTable->psBuckets->uBucketCount)
+    {
+        (void)RcuSymTable_expand(oRcuSymTable);
+    }
+
+    psNewNode = RcuSymTable_newNode(pcKey, uLength, uHash, pvValue);
+    if (psNewNode == NULL)
+    {
+        RcuSymTable_unlock(oRcuSymTable);
+        return 0;
+    }
+
+    /* The node is complete before the release store publishes it. */
+    psBuckets = oRcuSymTable->psBuckets;
+    uIndex = RcuSymTable_bucket(uHash, psBuckets->uBucketCount);
+    psNewNode->psNextNode = psBuckets->apsBuckets[uIndex];
+    __atomic_store_n(&psBuckets->apsBuckets[uIndex], psNewNode,
+        __ATOMIC_RELEASE);
+    __atomic_store_n(&oRcuSymTable->uLength, oRcuSymTable->uLength + 1,
+        __ATOMIC_RELAXED);
+
+    RcuSymTable_unlock(oRcuSymTable);
+    return 1;
+}
+
+void *RcuSymTable_replace(RcuSymTable_T oRcuSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct RcuSymTableNode **ppsLink;
+    const void *pvValueOld = NULL;
+    size_t uLength;
+
+    assert(oRcuSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+
+    RcuSymTable_lock(oRcuSymTable);
+    ppsLink = RcuSymTable_findLink(oRcuSymTable, pcKey, uLength,
+        StrHash_word(pcKey, uLength));
+    if (ppsLink != NULL)
+    {
+        pvValueOld = (*ppsLink)->pvValue;
+        __atomic_store_n(&(*ppsLink)->pvValue, pvValue,
+            __ATOMIC_RELEASE);
+    }
+    RcuSymTable_unlock(oRcuSymTable);
+
+    return (void*)pvValueOld;
+}
+
+void *RcuSymTable_remove(RcuSymTable_T oRcuSymTable,
+    const char *pcKey)
+{
+    struct RcuSymTableNode **ppsLink;
+    struct RcuSymTableNode *psNodeToRemove;
+    const void *pvRemovedValue;
+    size_t uLength;
+
+    assert(oRcuSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+
+    RcuSymTable_lock(oRcuSymTable);
+    ppsLink = RcuSymTable_findLink(oRcuSymTable, pcKey, uLength,
+        StrHash_word(pcKey, uLength));
+    if (ppsLink == NULL)
+    {
+        RcuSymTable_unlock(oRcuSymTable);
+        return NULL;
+    }
+
+    /* Lookups standing on the node can still follow its link, so the
+    node is unlinked but left intact until they finish. */
+    psNodeToRemove = *ppsLink;
+    pvRemovedValue = psNodeToRemove->pvValue;
+    __atomic_store_n(ppsLink, psNodeToRemove->psNextNode,
+        __ATOMIC_RELEASE);
+    __atomic_store_n(&oRcuSymTable->uLength, oRcuSymTable->uLength - 1,
+        __ATOMIC_RELAXED);
+    RcuSymTable_retire(oRcuSymTable, psNodeToRemove, 0);
+
+    RcuSymTable_unlock(oRcuSymTable);
+    return (void*)pvRemovedValue;
+}
+
+void RcuSymTable_map(RcuSymTable_T oRcuSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct RcuSymTableBuckets *psBuckets;
+    struct RcuSymTableNode *psCurrentNode;
+    size_t i;
+
+    assert(oRcuSymTable != NULL);
+    assert(pfApply != NULL);
+
+    RcuSymTable_lock(oRcuSymTable);
+    psBuckets = oRcuSymTable->psBuckets;
+    for (i = 0; i < psBuckets->uBucketCount; i++)
+    {
+        for (psCurrentNode = psBuckets->apsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+        {
+            (*pfApply) ((void*)psCurrentNode->acKey,
+            (void*)psCurrentNode->pvValue, ((void*)pvExtra));
+        }
+    }
+    RcuSymTable_unlock(oRcuSymTable);
+}
+
+/* If the table of oReader contains pcKey, store the value of its
+binding in *ppvValue and return 1 (TRUE); otherwise return 0 (FALSE).
+Take no lock: announce the lookup's epoch so that no writer frees
+what the lookup may see, and read every shared field with an acquire
+load. */
+static int RcuSymTable_lookup(RcuSymTableReader_T oReader,
+    const char *pcKey, void **ppvValue)
+{
+    RcuSymTable_T oRcuSymTable;
+    struct RcuSymTableBuckets *psBuckets;
+    struct RcuSymTableNode *psNode;
+    size_t uLength;
+    size_t uHash;
+    int iFound = 0;
+
+    assert(oReader != NULL);
+    assert(oReader->uEpoch == 0);
+    assert(pcKey != NULL);
+
+    oRcuSymTable = oReader->oRcuSymTable;
+    uLength = strlen(pcKey);
+    uHash = StrHash_word(pcKey, uLength);
+
+    /* The fence orders the epoch store before the loads of links, as
+    each writer orders its unlinks before its loads of the readers'
+    epochs, so a writer either sees this lookup or this lookup sees
+    the writer's unlink. A plain store and a fence; no
+    read-modify-write. */
+    __atomic_store_n(&oReader->uEpoch,
+        __atomic_load_n(&oRcuSymTable->uEpoch, __ATOMIC_ACQUIRE),
+        __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    psBuckets = __atomic_load_n(&oRcuSymTable->psBuckets,
+        __ATOMIC_ACQUIRE);
+    for (psNode = __atomic_load_n(&psBuckets->apsBuckets[
+        RcuSymTable_bucket(uHash, psBuckets->uBucketCount)],
+        __ATOMIC_ACQUIRE);
+        psNode != NULL;
+        psNode = __atomic_load_n(&psNode->psNextNode, __ATOMIC_ACQUIRE))
+    {
+        if (psNode->uHash == uHash && psNode->uKeyLength == uLength &&
+            memcmp(psNode->acKey, pcKey, uLength) == 0)
+        {
+            *ppvValue = (void*)__atomic_load_n(&psNode->pvValue,
+                __ATOMIC_ACQUIRE);
+            iFound = 1;
+            break;
+        }
+    }
+
+    __atomic_store_n(&oReader->uEpoch, 0, __ATOMIC_RELEASE);
+    return iFound;
+}
+
+int RcuSymTable_contains(RcuSymTableReader_T oReader,
+    const char *pcKey)
+{
+    void *pvValue;
+
+    return RcuSymTable_lookup(oReader, pcKey, &pvValue);
+}
+
+void *RcuSymTable_get(RcuSymTableReader_T oReader, const char *pcKey)
+{
+    void *pvValue = NULL;
+
+    (void)RcuSymTable_lookup(oReader, pcKey, &pvValue);
+    return pvValue;
+}
@@ -0,0 +1,82 @@
+/*--------------------------------------------------------------------*/
+/* rcusymtable.h                                                      */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef RCUSYMTABLE_H
+#define RCUSYMTABLE_H
+#include <stddef.h>
+
+/* An RcuSymTable_T is a SymTable_T for tables that are read far more
+often than they are written. Any number of threads may look up keys
+at once without taking a lock or doing an atomic read-modify-write;
+writers take turns under a single lock. Memory that a writer unlinks
+is freed only after every lookup that might still see it has
+finished. */
+typedef struct RcuSymTable *RcuSymTable_T;
+
+/* An RcuSymTableReader_T is one thread's handle for looking up keys
+in an RcuSymTable_T. Each thread that looks up keys needs its own
+reader, and a reader must not be used by two threads at once. */
+typedef struct RcuSymTableReader *RcuSymTableReader_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new RcuSymTable_T object, or NULL if insufficient memory
+is available. */
+RcuSymTable_T RcuSymTable_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oRcuSymTable and all of its readers. No other thread may be
+using it. */
+void RcuSymTable_free(RcuSymTable_T oRcuSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new reader of oRcuSymTable, or NULL if insufficient memory
+is available. Readers are meant to be made once per thread, not once
+per lookup; this function takes the writers' lock. */
+RcuSymTableReader_T RcuSymTable_newReader(RcuSymTable_T oRcuSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Give oReader back to its table, which may hand it out again. */
+void RcuSymTable_freeReader(RcuSymTableReader_T oReader);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings in oRcuSymTable. While other threads
+are putting or removing bindings, the result is only approximate. */
+size_t RcuSymTable_getLength(RcuSymTable_T oRcuSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the SymTable functions of the same
+names. They take the writers' lock, so they wait for one another but
+never for lookups. */
+
+int RcuSymTable_put(RcuSymTable_T oRcuSymTable,
+    const char *pcKey, const void *pvValue);
+
+void *RcuSymTable_replace(RcuSymTable_T oRcuSymTable,
+    const char *pcKey, const void *pvValue);
+
+void *RcuSymTable_remove(RcuSymTable_T oRcuSymTable,
+    const char *pcKey);
+
+void RcuSymTable_map(RcuSymTable_T oRcuSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the SymTable functions of the same
+names, looking up keys in the table of oReader. They take no lock, so
+they run alongside writers and one another. */
+
+int RcuSymTable_contains(RcuSymTableReader_T oReader,
+    const char *pcKey);
+
+void *RcuSymTable_get(RcuSymTableReader_T oReader, const char *pcKey);
+
+#endif
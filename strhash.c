@@ -0,0 +1,143 @@
+/*--------------------------------------------------------------------*/
+/* strhash.c                                                          */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "strhash.h"
+
+/* Odd 64-bit constants with well spread bits, used to mix words. */
+static const uint64_t WORD_PRIME0 = 0xa0761d6478bd642fu;
+static const uint64_t WORD_PRIME1 = 0xe7037ed1a0b428dbu;
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 StrHash_Uint128;
+#endif
+
+/* Store the low and high 64 bits of the 128-bit product of uA and uB
+in *puLow and *puHigh. */
+static void StrHash_multiply128(uint64_t uA, uint64_t uB,
+    uint64_t *puLow, uint64_t *puHigh)
+{
+#ifdef __SIZEOF_INT128__
+    StrHash_Uint128 uProduct;
+
+    assert(puLow != NULL);
+    assert(puHigh != NULL);
+
+    uProduct = (StrHash_Uint128)uA * uB;
+    *puLow = (uint64_t)uProduct;
+    *puHigh = (uint64_t)(uProduct >> 64);
+#else
+    uint64_t uALow = uA & 0xffffffffu;
+    uint64_t uAHigh = uA >> 32;
+    uint64_t uBLow = uB & 0xffffffffu;
+    uint64_t uBHigh = uB >> 32;
+    uint64_t uLowLow = uALow * uBLow;
+    uint64_t uMiddle1;
+    uint64_t uMiddle2;
+
+    assert(puLow != NULL);
+    assert(puHigh != NULL);
+
+    /* Neither partial sum can overflow 64 bits. */
+    uMiddle1 = uAHigh * uBLow + (uLowLow >> 32);
+    uMiddle2 = uALow * uBHigh + (uMiddle1 & 0xffffffffu);
+    *puLow = uA * uB;
+    *puHigh = uAHigh * uBHigh + (uMiddle1 >> 32) + (uMiddle2 >> 32);
+#endif
+}
+
+/* Return the exclusive or of the two halves of the 128-bit product of
+uA and uB. */
+static uint64_t StrHash_mix(uint64_t uA, uint64_t uB)
+{
+    uint64_t uLow;
+    uint64_t uHigh;
+
+    StrHash_multiply128(uA, uB, &uLow, &uHigh);
+    return uLow ^ uHigh;
+}
+
+/* Return the uLength (at most 8) bytes at pcBytes as a word, padded
+with zero bytes. */
+static uint64_t StrHash_read(const char *pcBytes, size_t uLength)
+{
+    uint64_t uWord = 0;
+
+    assert(pcBytes != NULL || uLength == 0);
+    assert(uLength <= sizeof(uint64_t));
+
+    if (uLength > 0)
+    {
+        memcpy(&uWord, pcBytes, uLength);
+    }
+    return uWord;
+}
+
+size_t StrHash_multiply(const char *pcKey, size_t uLength)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; u < uLength; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+size_t StrHash_word(const char *pcKey, size_t uLength)
+{
+    uint64_t uHash;
+    uint64_t uA;
+    uint64_t uB;
+    size_t uRemaining = uLength;
+
+    assert(pcKey != NULL);
+
+    uHash = StrHash_mix(WORD_PRIME0 ^ (uint64_t)uLength, WORD_PRIME1);
+
+    /* Consume the key sixteen bytes at a time. */
+    while (uRemaining > 16)
+    {
+        uA = StrHash_read(pcKey, 8);
+        uB = StrHash_read(pcKey + 8, 8);
+        uHash = StrHash_mix(uA ^ WORD_PRIME1, uB ^ uHash);
+        pcKey += 16;
+        uRemaining -= 16;
+    }
+
+    /* Fold in the last one to sixteen bytes. */
+    if (uRemaining > 8)
+    {
+        uA = StrHash_read(pcKey, 8);
+        uB = StrHash_read(pcKey + 8, uRemaining - 8);
+    }
+    else
+    {
+        uA = StrHash_read(pcKey, uRemaining);
+        uB = 0;
+    }
+    uHash = StrHash_mix(uA ^ WORD_PRIME1, uB ^ uHash);
+
+    return (size_t)StrHash_mix(uHash ^ WORD_PRIME0,
+        (uint64_t)uLength ^ WORD_PRIME1);
+}
+
+size_t StrHash_reduce(size_t uHash, size_t uRange)
+{
+#if SIZE_MAX > 0xffffffffu
+    uint64_t uLow;
+    uint64_t uHigh;
+
+    StrHash_multiply128((uint64_t)uHash, (uint64_t)uRange,
+        &uLow, &uHigh);
+    return (size_t)uHigh;
+#else
+    return (size_t)(((uint64_t)uHash * uRange) >> 32);
+#endif
+}
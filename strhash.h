@@ -0,0 +1,29 @@
+/*--------------------------------------------------------------------*/
+/* strhash.h                                                          */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef STRHASH_H
+#define STRHASH_H
+#include <stddef.h>
+
+/* Return a hash code for the uLength characters at pcKey, computed
+one character at a time with multiplier 65599. This is the hash
+function from the assignment specification. */
+size_t StrHash_multiply(const char *pcKey, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for the uLength characters at pcKey, computed
+eight bytes at a time with folded 64-bit multiplies. Every bit of the
+result depends on every byte of the key, so the result may be reduced
+with StrHash_reduce or a power of two mask. */
+size_t StrHash_word(const char *pcKey, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a value between 0 and uRange-1, inclusive, taken from the
+high bits of uHash * uRange. This maps a well mixed hash code onto
+any range without a division. */
+size_t StrHash_reduce(size_t uHash, size_t uRange);
+
+#endif
@@ -12,6 +12,75 @@ identifies its binding; a value is data that is somehow pertinent
 to its key. */
 typedef struct SymTable *SymTable_T;
 
+/* A SymTable_HashFunction returns a hash code for the uLength
+characters at pcKey. The code must depend only on those characters.
+The functions declared in strhash.h are suitable. */
+typedef size_t (*SymTable_HashFunction)(const char *pcKey,
+    size_t uLength);
+
+/* Number of entries in the chain length histogram of a
+SymTableStats. */
+enum {SYMTABLE_HISTOGRAM_SIZE = 16};
+
+/* How a table reorders its chains of bindings as they are looked
+up. */
+enum SymTableOrder
+{
+    /* Never move a binding. */
+    SYMTABLE_ORDER_FIXED,
+    /* Move each binding found to the front of its chain. */
+    SYMTABLE_ORDER_MOVE_TO_FRONT,
+    /* Swap each binding found with the one before it. */
+    SYMTABLE_ORDER_TRANSPOSE
+};
+
+/* A SymTableStats describes the layout of a SymTable_T and counts the
+work done on it. Implementations without buckets report the whole
+table as a single chain (a list) or as no buckets at all (a tree). */
+struct SymTableStats
+{
+    /* The number of bindings. */
+    size_t uLength;
+    /* The number of buckets (or slots, for open addressing). */
+    size_t uBucketCount;
+    /* uLength / uBucketCount, or 0 if there are no buckets. */
+    double dLoadFactor;
+    /* auChainLengths[i] is the number of buckets holding i bindings,
+    except that the last entry counts every bucket holding at least
+    SYMTABLE_HISTOGRAM_SIZE - 1 bindings. With open addressing a
+    bucket holds the bindings whose home is its slot. */
+    size_t auChainLengths[SYMTABLE_HISTOGRAM_SIZE];
+    /* The number of bindings in the fullest bucket. */
+    size_t uMaxChainLength;
+    /* Bytes allocated for nodes, not counting their keys; for keys;
+    and for bucket arrays. */
+    size_t uNodeBytes;
+    size_t uKeyBytes;
+    size_t uBucketBytes;
+
+    /* The members below count operations since the table was created.
+    They are kept only if the implementation was compiled with
+    SYMTABLE_STATS defined, and are 0 otherwise. */
+
+    /* Calls that tried to put a binding. */
+    size_t uPuts;
+    /* Lookups by the get, contains, and replace functions, and how
+    many of them found their key. */
+    size_t uGets;
+    size_t uHits;
+    size_t uMisses;
+    /* Times the table grew its buckets or, for a tree, its height. */
+    size_t uExpansions;
+    /* Bindings (or tree nodes) examined per key search, counting the
+    searches made by puts and removes as well as by lookups. */
+    double dProbesPerLookup;
+};
+
+/* A SymTableIter_T walks the bindings of a SymTable_T a few at a
+time. It remembers only the last binding it returned, so the table may
+change between steps of the walk. */
+typedef struct SymTableIter *SymTableIter_T;
+
 /*--------------------------------------------------------------------*/
 
 /* Return a new SymTable_T object, or NULL if insuficient memory is
@@ -20,6 +89,22 @@ SymTable_T SymTable_new(void);
 
 /*--------------------------------------------------------------------*/
 
+/* Return a new SymTable_T object whose bindings are carved from large
+slabs of memory, or NULL if insufficient memory is available. Memory
+of removed bindings is reused by later puts, and SymTable_free
+releases all of it at once instead of binding by binding. */
+SymTable_T SymTable_newArena(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable_T object that hashes keys with *pfHash, or
+NULL if insufficient memory is available. SymTable_new uses
+StrHash_multiply; StrHash_word is much faster on long keys.
+Implementations that do not hash keys ignore pfHash. */
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash);
+
+/*--------------------------------------------------------------------*/
+
 /* Free oSymTable. */
 void SymTable_free(SymTable_T oSymTable);
 
@@ -30,6 +115,13 @@ size_t SymTable_getLength(SymTable_T oSymTable);
 
 /*--------------------------------------------------------------------*/
 
+/* Fill *psStats with a description of oSymTable. This walks every
+binding, so it takes time proportional to the size of the table. */
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats);
+
+/*--------------------------------------------------------------------*/
+
 /* Put binding of pcKey and pvValue into oSymTable. Return 1 (True) if
 successful, or 0 (FALSE) if insufficient memory is available. */
 int SymTable_put(SymTable_T oSymTable, 
@@ -73,4 +165,243 @@ void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra);
 
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the functions above without the
+"Len" suffix, except that the key is the uLength characters at pcKey
+rather than a null-terminated string. pcKey need not be
+null-terminated, so keys can be looked up directly inside a larger
+buffer. A binding put with a length is the same binding as one put
+with the equivalent string, and SymTable_map passes its key as a
+null-terminated copy. */
+
+int SymTable_putLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue);
+
+void *SymTable_replaceLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue);
+
+int SymTable_containsLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength);
+
+void *SymTable_getLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength);
+
+void *SymTable_removeLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code of pcKey in oSymTable. The code does not
+depend on the table's size, so it stays valid as the table grows, and
+it may be passed to the "Hashed" functions of any table that uses the
+same hash function. Implementations that do not hash keys return
+0. */
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the functions above without the
+"Hashed" suffix, except that they use uHash as the hash code of pcKey
+instead of computing it. uHash must be the value SymTable_hashKey
+returns for pcKey; a different value gives undefined results.
+Implementations that do not hash keys ignore uHash. */
+
+int SymTable_putHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue);
+
+void *SymTable_replaceHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue);
+
+int SymTable_containsHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash);
+
+void *SymTable_getHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash);
+
+/*--------------------------------------------------------------------*/
+
+/* Look up each of the uCount keys in ppcKeys in oSymTable, and store
+in ppvValues[i] the value of the binding whose key is ppcKeys[i], or
+NULL if no such binding exists. The result is the same as calling
+SymTable_get on each key in turn, but hashing implementations work
+on a batch of keys at once so that their memory accesses overlap. */
+void SymTable_getMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that contains no bindings and has room
+for uCapacity bindings before it needs to expand, or NULL if
+insufficient memory is available. Implementations that never expand
+ignore uCapacity. */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSymTable for a total of uCapacity bindings, so that
+putting bindings until it holds that many does not expand it. Return 1
+(TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available; oSymTable is unchanged but still usable in that case. */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Put a binding of ppcKeys[i] and ppvValues[i] into oSymTable for
+each i less than uCount, sizing oSymTable once for all of them. Keys
+that are already present, including keys repeated earlier in
+ppcKeys, are skipped as SymTable_put would skip them. Return the
+number of bindings added, which is less than uCount if keys were
+skipped or insufficient memory is available. */
+size_t SymTable_putMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues,
+    size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oSymTable, as
+SymTable_map does, using uWorkerCount threads at once. Worker i passes
+ppvExtras[i] as the extra parameter, so each worker can accumulate
+into its own slot without locking and the caller can combine the
+slots afterward. Bindings are visited in no particular order, so
+*pfApply must be safe to call from several threads at once, and
+oSymTable must not change during the call. */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *const *ppvExtras, size_t uWorkerCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new iterator over the bindings of oSymTable, positioned
+before the first one, or NULL if insufficient memory is available. */
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Advance oIter to the next binding of its table. If there is one,
+store its key in *ppcKey and its value in *ppvValue and return 1
+(TRUE). Return 0 (FALSE) if no bindings are left or insufficient
+memory is available. Bindings may be put or removed between calls,
+even if that resizes the table: a binding that is present from
+SymTable_iterBegin until the end of the walk is returned exactly once,
+and one that is put or removed along the way may or may not be. *ppcKey
+remains valid until its binding is removed. A step takes no longer than
+a lookup, and constant time for a list, so a walk can be spread over
+many short chunks. */
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oIter. Its table is unaffected, but must not have been freed
+first. */
+void SymTable_iterEnd(SymTableIter_T oIter);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oSymTable whose key is
+at least pcLow and less than pcHigh, in increasing order of key,
+passing pvExtra as the extra parameter as SymTable_map does. Keys are
+compared character by character as unsigned chars, and a key comes
+after its own prefixes, as strcmp orders strings. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available, in
+which case *pfApply is not called. An ordered implementation finds
+the bindings directly; the others sort the bindings they select. */
+int SymTable_range(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oSymTable whose key
+begins with pcPrefix, in increasing order of key, as SymTable_range
+does. The empty prefix selects every binding. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available, in
+which case *pfApply is not called. */
+int SymTable_prefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return oSymTable's own copy of pcKey: a pointer that is the same
+for every call with an equal string, and that does not move as
+oSymTable grows or shrinks. If oSymTable has no binding with key
+pcKey, put one with a NULL value first. Return NULL if insufficient
+memory is available. The pointer stays valid until the binding is
+removed or oSymTable is freed. */
+const char *SymTable_intern(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the functions above without the
+"Interned" suffix, except that pcKey must be a pointer returned by
+SymTable_intern for oSymTable whose binding is still present. The
+binding is found from the pointer itself, so hashing implementations
+neither hash nor compare the key; an implementation that orders its
+keys still compares them, but recognizes its own copy of the key
+wherever it meets it. */
+
+void *SymTable_getInterned(SymTable_T oSymTable, const char *pcKey);
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue);
+
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Make oSymTable reorder its chains by eOrder from now on. A binding
+that SymTable_get, SymTable_contains, or SymTable_replace (or their
+"Len" and "Hashed" variants) finds is moved forward in its chain, so
+that frequently used keys are found after few comparisons. Lookups
+then modify the table: they must not run concurrently with each other,
+nor from a function that SymTable_map is applying to oSymTable. New
+tables use SYMTABLE_ORDER_FIXED. Implementations that do not chain
+bindings ignore eOrder. A list is not reordered while an iterator is
+walking it, so that the walk neither skips nor repeats bindings. */
+void SymTable_setOrder(SymTable_T oSymTable,
+    enum SymTableOrder eOrder);
+
+/*--------------------------------------------------------------------*/
+
+/* Bind pcKey to pvValue in oSymTable whether or not pcKey is already
+bound, searching for pcKey only once. If ppvOldValue is not NULL, set
+*ppvOldValue to the value pcKey was bound to, or to NULL if it was not
+bound. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+memory is available, in which case the bindings of oSymTable are
+unchanged. */
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address at which oSymTable holds the value of the
+binding with key pcKey, first putting a binding of pcKey and pvValue
+if there is none, and searching for pcKey only once. Return NULL if
+insufficient memory is available. The value may be read and written
+through the address until a binding is next added to or removed from
+oSymTable. */
+void **SymTable_getOrInsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove from oSymTable every binding for which
+(*pfPredicate)(pcKey, pvValue, pvExtra) returns nonzero, in a single
+sweep over the table, and return the number of bindings removed. If
+pfRemoved is not NULL, call (*pfRemoved)(pcKey, pvValue, pvExtra) for
+each binding removed, before its key is freed. pfPredicate is called
+once for each binding. Neither function may change oSymTable. */
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
 #endif
@@ -2,368 +2,2265 @@
 /* symtablehash.c                                                     */
 /* Author: Ryan Donoghue                                              */
 /*--------------------------------------------------------------------*/
+#include <stddef.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include "symtable.h"
+#include "arena.h"
+#include "strhash.h"
+#include "parallel.h"
+#include "symtabletrace.h"
 
-/* Bucket count progression for expansion. */
-static const size_t auBucketCounts[] = {
-    509, 1021, 2039, 4093, 8191, 16381, 32749, 65521
-}; 
+/* Number of buckets a SymTable allocates when it outgrows its small
+layout. */
+static const size_t INITIAL_BUCKET_COUNT = 509;
 
-/* Length of auBucketCounts[]. */
-static const size_t numBucketCounts = sizeof(auBucketCounts)
-/sizeof(auBucketCounts[0]);
+/* A new SymTable holds up to this many bindings in a single chain
+whose head is part of the SymTable itself, so that small tables
+allocate no bucket array at all. */
+static const size_t SMALL_TABLE_LIMIT = 8;
 
-/* Each binding is stored in a SymTableNode. SymTableNodes are 
+/* Number of non-empty old buckets moved into the new bucket array by
+each operation while a resize is in progress. */
+static const size_t REHASH_STEP_BUCKETS = 4;
+
+/* Maximum number of empty old buckets skipped per non-empty bucket
+moved, so that a sparse old array cannot stall a single operation. */
+static const size_t REHASH_EMPTY_VISITS = 10;
+
+/* A table with more than INITIAL_BUCKET_COUNT buckets shrinks once it
+has more than SHRINK_LOAD_DENOMINATOR buckets per binding. It shrinks
+to about two buckets per binding, so a table must double or halve
+again before it resizes again. */
+static const size_t SHRINK_LOAD_DENOMINATOR = 8;
+
+/* Each binding is stored in a SymTableNode. SymTableNodes are
 linked to form a list within each bucket of the Hash Table. */
-struct SymTableNode 
+struct SymTableNode
 {
-    /* The key of the binding. */
-    char *pcKey;
+    /* The full hash code of pcKey, kept so that expansion never
+    rehashes a key and chain walks can skip most string
+    comparisons. */
+    size_t uHash;
     /* The value of the binding. */
     const void *pvValue;
-    /* The address of the next binding in the bucket. Allows each 
+    /* The address of the next binding in the bucket. Allows each
     bucket to operate as individual linked lists. */
     struct SymTableNode *psNextNode;
+    /* The number of characters in the key, not counting the null
+    terminator. */
+    size_t uKeyLength;
+    /* The key of the binding, stored inline so that each binding is
+    a single allocation. */
+    char acKey[];
+};
+
+#ifdef SYMTABLE_STATS
+/* Counts of the operations done on a SymTable, as reported by
+SymTable_getStats. */
+struct SymTableCounters
+{
+    /* Calls that tried to put a binding. */
+    size_t uPuts;
+    /* Lookups by get, contains, and replace, and how many found their
+    key. */
+    size_t uGets;
+    size_t uHits;
+    /* Key searches of any kind, and nodes they examined. */
+    size_t uSearches;
+    size_t uProbes;
+    /* Resizes that added buckets. */
+    size_t uExpansions;
 };
+#endif
 
-/* A SymTable in the Hash Table implementation is an array of 
-BUCKET_COUNT linked lists (Buckets) where bindings are stored in
-nodes depending on their hash code. */
-struct SymTable 
+/* A SymTable in the Hash Table implementation is an array of
+linked lists (Buckets) where bindings are stored in nodes depending
+on their hash code. While the table is resizing it also holds the
+previous bucket array, whose bindings are moved over a few buckets at
+a time. */
+struct SymTable
 {
     /* Pointer to array of bucket pointers. */
     struct SymTableNode **ppsHashTable;
     /* Current number of buckets. */
-    size_t uBucketCount; 
-    /* Index for auBucketCounts array. */
-    size_t uBucketIndex; 
+    size_t uBucketCount;
+    /* Pointer to the bucket array being drained into ppsHashTable,
+    or NULL if no resize is in progress. */
+    struct SymTableNode **ppsOldHashTable;
+    /* Number of buckets in ppsOldHashTable. */
+    size_t uOldBucketCount;
+    /* Index of the next bucket of ppsOldHashTable to move. Buckets
+    below this index are already empty. */
+    size_t uRehashIndex;
     /* Number of bindings in the symbol table. */
-    size_t uLength; 
+    size_t uLength;
+    /* The arena that nodes are carved from, or NULL if each node is
+    allocated with malloc. */
+    Arena_T oArena;
+    /* The function that computes the full hash code of a key. */
+    SymTable_HashFunction pfHash;
+    /* How lookups reorder the chains. */
+    enum SymTableOrder eOrder;
+    /* The only bucket of a small table: ppsHashTable points here
+    until the table first expands. */
+    struct SymTableNode *psSmallBucket;
+#ifdef SYMTABLE_STATS
+    /* Operation counts for SymTable_getStats. */
+    struct SymTableCounters sCounters;
+#endif
+#ifdef SYMTABLE_TRACE
+    /* The operation being traced. */
+    struct SymTableTrace sTrace;
+#endif
 };
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+/* Add uAmount to the counter uField of oSymTable if operations are
+being counted, and otherwise do nothing at all. */
+#ifdef SYMTABLE_STATS
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) \
+    ((oSymTable)->sCounters.uField += (size_t)(uAmount))
+#else
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) ((void)0)
+#endif
+
+/* Number of buckets each task of SymTable_mapParallel visits. */
+static const size_t MAP_TASK_BUCKETS = 1024;
+
+/* Number of keys SymTable_getMany resolves side by side. */
+enum {GET_MANY_BATCH = 16};
+
+/* Hint that the memory at pv will be read soon. Does nothing on
+compilers without a prefetch builtin. */
+static void SymTable_prefetch(const void *pv)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(pv);
+#else
+    (void)pv;
+#endif
+}
+
+/* Return the full hash code in oSymTable of the key that is the
+uLength characters at pcKey. Reduce it with SymTable_bucket to get a
+bucket index. */
+static size_t SymTable_hash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Return the position in iteration order of bindings whose full hash
+code is uHash. Multiplying by an odd constant scrambles the code
+without merging any two codes, and moves the influence of every
+character of the key into the high bits. */
+static size_t SymTable_order(size_t uHash)
 {
-   const size_t HASH_MULTIPLIER = 65599;
-   size_t u;
-   size_t uHash = 0;
+    const size_t FIBONACCI_MULTIPLIER = (size_t)0x9E3779B97F4A7C15u;
 
-   assert(pcKey != NULL);
+    return uHash * FIBONACCI_MULTIPLIER;
+}
 
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+/* Return the index of the bucket, among uBucketCount buckets of
+oSymTable, that holds bindings whose full hash code is uHash. Each
+bucket holds one range of positions in iteration order, and the ranges
+are in bucket order whatever the number of buckets, which keeps an
+iterator's place valid across resizes. */
+static size_t SymTable_bucket(SymTable_T oSymTable, size_t uHash,
+    size_t uBucketCount)
+{
+    assert(oSymTable != NULL);
+    (void)oSymTable;
 
-   return uHash % uBucketCount;
+    return StrHash_reduce(SymTable_order(uHash), uBucketCount);
 }
 
-/* Expand oSymTable to the next bucket count. Return 1 on success,
-0 on faliure (not enough memory). */
-static int SymTable_expand(SymTable_T oSymTable) 
+/* Return the number of bytes occupied by a node whose key is
+uKeyLength characters long. */
+static size_t SymTable_nodeSize(size_t uKeyLength)
 {
-    struct SymTableNode **ppsNewBuckets;
-    struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNextNode;
-    size_t uNewBucketCount;
-    size_t uNewHash;
-    size_t i;
+    /* +1 at the end marks the null terminator character. */
+    return offsetof(struct SymTableNode, acKey) + uKeyLength + 1;
+}
 
+/* Return a new node of oSymTable with room for a key of uKeyLength
+characters, or NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable,
+    size_t uKeyLength)
+{
     assert(oSymTable != NULL);
 
-    /* Check if further expansion is possible. */
-    if (oSymTable->uLength >= auBucketCounts[numBucketCounts])
-        {
-        return 1;
-        }
-    /* Get new bucket count */
-    uNewBucketCount = auBucketCounts[oSymTable->uBucketIndex + 1];
-    
-    ppsNewBuckets = (struct SymTableNode**)
-        calloc(uNewBucketCount, sizeof(struct SymTableNode*));
-    if (ppsNewBuckets == NULL)
+    if (oSymTable->oArena != NULL)
     {
-        return 0;
+        return (struct SymTableNode*)Arena_alloc(oSymTable->oArena,
+            SymTable_nodeSize(uKeyLength));
     }
+    return (struct SymTableNode*)malloc(SymTable_nodeSize(uKeyLength));
+}
 
-    /* Rehash all existing bindings into new buckets */
-    for (i = 0; i < oSymTable->uBucketCount; i++)
+/* Free psNode, which belongs to oSymTable. */
+static void SymTable_freeNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode)
+{
+    assert(oSymTable != NULL);
+    assert(psNode != NULL);
+
+    if (oSymTable->oArena != NULL)
     {
-        for (psCurrentNode = oSymTable->ppsHashTable[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psNextNode)
-        {
-            psNextNode = psCurrentNode->psNextNode;
+        Arena_release(oSymTable->oArena, psNode,
+            SymTable_nodeSize(psNode->uKeyLength));
+        return;
+    }
+    free(psNode);
+}
+
+/* Remove from the chain that begins at *ppsHead every binding of
+oSymTable for which (*pfPredicate)(pcKey, pvValue, pvExtra) returns
+nonzero, passing each to *pfRemoved, if pfRemoved is not NULL, before
+freeing it. Return the number of bindings removed. */
+static size_t SymTable_removeFromChain(SymTable_T oSymTable,
+    struct SymTableNode **ppsHead,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    size_t uRemoved = 0;
 
-            uNewHash = SymTable_hash(psCurrentNode->pcKey, 
-                uNewBucketCount);
+    assert(oSymTable != NULL);
+    assert(ppsHead != NULL);
+    assert(pfPredicate != NULL);
 
-            psCurrentNode->psNextNode = ppsNewBuckets[uNewHash];
-            ppsNewBuckets[uNewHash] = psCurrentNode;
+    ppsLink = ppsHead;
+    while (*ppsLink != NULL)
+    {
+        psNode = *ppsLink;
+        if (!(*pfPredicate)(psNode->acKey, (void*)psNode->pvValue,
+            (void*)pvExtra))
+        {
+            ppsLink = &psNode->psNextNode;
+            continue;
         }
+        *ppsLink = psNode->psNextNode;
+        if (pfRemoved != NULL)
+        {
+            (*pfRemoved)(psNode->acKey, (void*)psNode->pvValue,
+                (void*)pvExtra);
+        }
+        SymTable_freeNode(oSymTable, psNode);
+        oSymTable->uLength--;
+        uRemoved++;
     }
-    free(oSymTable->ppsHashTable);
+    return uRemoved;
+}
 
-    oSymTable->ppsHashTable = ppsNewBuckets;
-    oSymTable->uBucketCount = uNewBucketCount;
-    oSymTable->uBucketIndex++;
+/* Return 1 (TRUE) if u is prime, or 0 (FALSE) otherwise. */
+static int SymTable_isPrime(size_t u)
+{
+    size_t uDivisor;
 
+    if (u < 2)
+    {
+        return 0;
+    }
+    for (uDivisor = 2; uDivisor <= u / uDivisor; uDivisor++)
+    {
+        if (u % uDivisor == 0)
+        {
+            return 0;
+        }
+    }
     return 1;
 }
 
-SymTable_T SymTable_new(void) 
+/* Return the bucket count to expand to from uBucketCount: the
+smallest prime greater than twice uBucketCount. Return 0 if that
+count cannot be represented. */
+static size_t SymTable_nextBucketCount(size_t uBucketCount)
 {
-    SymTable_T oSymTable;
+    size_t uCount;
 
-    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
-    if (oSymTable == NULL)
+    if (uBucketCount > ((size_t)-1 / sizeof(struct SymTableNode*)) / 2)
+    {
+        return 0;
+    }
+    for (uCount = uBucketCount * 2 + 1; !SymTable_isPrime(uCount);
+        uCount++)
     {
-        return NULL;
     }
+    return uCount;
+}
+
+/* Return the bucket count needed to hold uCapacity bindings without
+expanding: INITIAL_BUCKET_COUNT, or the smallest prime at least
+uCapacity if that is larger. Return 0 if that count cannot be
+represented. */
+static size_t SymTable_bucketCountFor(size_t uCapacity)
+{
+    size_t uCount;
 
-    oSymTable->ppsHashTable = (struct SymTableNode**) 
-        calloc(auBucketCounts[0], sizeof(struct SymTableNode*));
-    if (oSymTable->ppsHashTable == NULL) 
+    if (uCapacity <= INITIAL_BUCKET_COUNT)
+    {
+        return INITIAL_BUCKET_COUNT;
+    }
+    if (uCapacity > (size_t)-1 / sizeof(struct SymTableNode*) / 2)
+    {
+        return 0;
+    }
+    for (uCount = uCapacity; !SymTable_isPrime(uCount); uCount++)
     {
-        free(oSymTable);
-        return NULL; 
     }
+    return uCount;
+}
 
-    oSymTable->uBucketCount = auBucketCounts[0];
-    oSymTable->uBucketIndex = 0;
-    oSymTable->uLength = 0;
+/* Return 1 (TRUE) if oSymTable still has its small layout, or 0
+(FALSE) otherwise. */
+static int SymTable_isSmall(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    return oSymTable->ppsHashTable == &oSymTable->psSmallBucket;
+}
+
+/* Return the number of bindings oSymTable can hold before its next
+put expands it. */
+static size_t SymTable_capacity(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (SymTable_isSmall(oSymTable))
+    {
+        return SMALL_TABLE_LIMIT;
+    }
+    return oSymTable->uBucketCount;
+}
+
+/* Free ppsBuckets, a bucket array of oSymTable, unless it is the
+small bucket within oSymTable itself. */
+static void SymTable_freeBuckets(SymTable_T oSymTable,
+    struct SymTableNode **ppsBuckets)
+{
+    assert(oSymTable != NULL);
 
-    return oSymTable; 
+    if (ppsBuckets != &oSymTable->psSmallBucket)
+    {
+        free(ppsBuckets);
+    }
 }
 
-void SymTable_free(SymTable_T oSymTable) 
+/* Move up to uBuckets non-empty buckets of oSymTable's old bucket
+array into the current one, and release the old array once it is
+drained. Do nothing if no resize is in progress. */
+static void SymTable_rehashStep(SymTable_T oSymTable, size_t uBuckets)
 {
     struct SymTableNode *psCurrentNode;
     struct SymTableNode *psNextNode;
-    size_t i; 
+    size_t uEmptyVisits;
+    size_t uNewHash;
 
-    assert(oSymTable != NULL); 
+    assert(oSymTable != NULL);
 
-    for (i = 0; i < oSymTable->uBucketCount; i++)
+    if (oSymTable->ppsOldHashTable == NULL)
+    {
+        return;
+    }
+    SYMTABLE_TRACE_CAUSE(oSymTable, SYMTABLE_TRACE_REHASH);
+
+    if (uBuckets > (size_t)-1 / REHASH_EMPTY_VISITS)
+        uEmptyVisits = (size_t)-1;
+    else
+        uEmptyVisits = uBuckets * REHASH_EMPTY_VISITS;
+
+    while (uBuckets > 0 &&
+        oSymTable->uRehashIndex < oSymTable->uOldBucketCount)
     {
-        if (oSymTable->ppsHashTable[i] != NULL) 
+        psCurrentNode =
+            oSymTable->ppsOldHashTable[oSymTable->uRehashIndex];
+        if (psCurrentNode == NULL)
         {
-            for (psCurrentNode = oSymTable->ppsHashTable[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psNextNode)
+            oSymTable->uRehashIndex++;
+            if (--uEmptyVisits == 0)
             {
-                psNextNode = psCurrentNode->psNextNode;
-                free(psCurrentNode->pcKey);
-                free(psCurrentNode);
-                oSymTable->uLength--; 
+                break;
             }
-        } 
+            continue;
+        }
+
+        for (; psCurrentNode != NULL; psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->psNextNode;
+
+            uNewHash = SymTable_bucket(oSymTable, psCurrentNode->uHash,
+                oSymTable->uBucketCount);
+
+            psCurrentNode->psNextNode =
+                oSymTable->ppsHashTable[uNewHash];
+            oSymTable->ppsHashTable[uNewHash] = psCurrentNode;
+        }
+        oSymTable->ppsOldHashTable[oSymTable->uRehashIndex] = NULL;
+        oSymTable->uRehashIndex++;
+        uBuckets--;
     }
-    free(oSymTable->ppsHashTable); 
-    free(oSymTable);
-}
 
-size_t SymTable_getLength(SymTable_T oSymTable) 
-{
-    return oSymTable->uLength; 
+    if (oSymTable->uRehashIndex == oSymTable->uOldBucketCount)
+    {
+        SymTable_freeBuckets(oSymTable, oSymTable->ppsOldHashTable);
+        oSymTable->ppsOldHashTable = NULL;
+        oSymTable->uOldBucketCount = 0;
+        oSymTable->uRehashIndex = 0;
+    }
 }
 
-int SymTable_put(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue) 
+/* Start resizing oSymTable to uNewBucketCount buckets, which may be
+more or fewer than it has now. The bindings
+are moved incrementally by later calls to SymTable_rehashStep. Return
+1 on success, 0 on faliure (not enough memory). */
+static int SymTable_resizeTo(SymTable_T oSymTable,
+    size_t uNewBucketCount)
 {
-struct SymTableNode *psNewNode; 
-struct SymTableNode *psCurrentNode;
-size_t hash_code;
+    struct SymTableNode **ppsNewBuckets;
 
-assert(oSymTable != NULL); 
-assert(pcKey != NULL);
+    assert(oSymTable != NULL);
 
-/* Prompt expansion if # of bindings is as least 
-the amount of current buckets. */
-if(oSymTable->uLength >= oSymTable->uBucketCount)
-{
-    SymTable_expand(oSymTable); 
-}
+    /* Finish any earlier resize so at most two arrays exist. */
+    SymTable_rehashStep(oSymTable, (size_t)-1);
+
+    ppsNewBuckets = (struct SymTableNode**)
+        calloc(uNewBucketCount, sizeof(struct SymTableNode*));
+    if (ppsNewBuckets == NULL)
+    {
+        return 0;
+    }
+    SYMTABLE_COUNT(oSymTable, uExpansions,
+        uNewBucketCount > oSymTable->uBucketCount);
+    SYMTABLE_TRACE_CAUSE(oSymTable,
+        uNewBucketCount > oSymTable->uBucketCount ?
+        SYMTABLE_TRACE_EXPAND : SYMTABLE_TRACE_SHRINK);
+
+    oSymTable->ppsOldHashTable = oSymTable->ppsHashTable;
+    oSymTable->uOldBucketCount = oSymTable->uBucketCount;
+    oSymTable->uRehashIndex = 0;
+    oSymTable->ppsHashTable = ppsNewBuckets;
+    oSymTable->uBucketCount = uNewBucketCount;
 
-hash_code = SymTable_hash(pcKey, oSymTable->uBucketCount);
+    return 1;
+}
 
-for (psCurrentNode = oSymTable->ppsHashTable[hash_code];
-     psCurrentNode != NULL; 
-     psCurrentNode = psCurrentNode->psNextNode)
+/* Start expanding oSymTable to the next bucket count. Return 1 on
+success, 0 on faliure (not enough memory). */
+static int SymTable_expand(SymTable_T oSymTable)
 {
-    if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+    size_t uNewBucketCount;
+
+    assert(oSymTable != NULL);
+
+    /* Get new bucket count */
+    if (SymTable_isSmall(oSymTable))
+    {
+        return SymTable_resizeTo(oSymTable, INITIAL_BUCKET_COUNT);
+    }
+    uNewBucketCount = SymTable_nextBucketCount(oSymTable->uBucketCount);
+    if (uNewBucketCount == 0)
     {
         return 0;
     }
+    return SymTable_resizeTo(oSymTable, uNewBucketCount);
 }
 
-psNewNode = (struct SymTableNode*)malloc(sizeof(struct 
-    SymTableNode)); 
-if (psNewNode == NULL) 
+/* Start shrinking oSymTable if it has far more buckets than bindings
+and is not already resizing. A failed shrink is harmless: the table
+keeps its current buckets. */
+static void SymTable_shrink(SymTable_T oSymTable)
 {
-    return 0;
+    size_t uNewBucketCount;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->ppsOldHashTable != NULL ||
+        oSymTable->uBucketCount <= INITIAL_BUCKET_COUNT ||
+        oSymTable->uLength >
+        oSymTable->uBucketCount / SHRINK_LOAD_DENOMINATOR)
+    {
+        return;
+    }
+
+    uNewBucketCount = SymTable_bucketCountFor(oSymTable->uLength * 2);
+    if (uNewBucketCount == 0 ||
+        uNewBucketCount >= oSymTable->uBucketCount)
+    {
+        return;
+    }
+    (void)SymTable_resizeTo(oSymTable, uNewBucketCount);
 }
-/* +1 at the end marks the null terminator character. */
-psNewNode->pcKey = (char*)malloc(strlen(pcKey) + 1); 
-if (psNewNode->pcKey == NULL)
+
+/* Return 1 (TRUE) if psNode's key is the uLength characters at pcKey,
+whose full hash code is uHash, or 0 (FALSE) otherwise. The cached hash
+code and the length are compared first, so most mismatches never
+touch the key bytes. */
+static int SymTable_nodeMatches(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uLength, size_t uHash)
 {
-    free(psNewNode);
-    return 0; 
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    return psNode->uHash == uHash && psNode->uKeyLength == uLength &&
+        memcmp(psNode->acKey, pcKey, uLength) == 0;
 }
 
-strcpy(psNewNode->pcKey, pcKey); 
+/* Move the binding that *ppsLink points to forward in the chain that
+begins at *ppsHead, in which *ppsPrevLink points to the binding before
+it (ppsPrevLink is NULL if it is first), as eOrder says. Return the
+address of the link that then points to it. */
+static struct SymTableNode **SymTable_promote(
+    enum SymTableOrder eOrder, struct SymTableNode **ppsHead,
+    struct SymTableNode **ppsPrevLink, struct SymTableNode **ppsLink)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psPrevNode;
 
-psNewNode->pvValue = pvValue; 
-psNewNode->psNextNode = oSymTable->ppsHashTable[hash_code]; 
-oSymTable->ppsHashTable[hash_code] = psNewNode; 
-oSymTable->uLength++; 
-return 1; 
+    assert(ppsHead != NULL);
+    assert(ppsLink != NULL);
 
+    if (ppsPrevLink == NULL || eOrder == SYMTABLE_ORDER_FIXED)
+    {
+        return ppsLink;
+    }
+    psNode = *ppsLink;
+    if (eOrder == SYMTABLE_ORDER_MOVE_TO_FRONT)
+    {
+        *ppsLink = psNode->psNextNode;
+        psNode->psNextNode = *ppsHead;
+        *ppsHead = psNode;
+        return ppsHead;
+    }
+    /* Transpose: *ppsLink is the psNextNode field of the binding
+    before. */
+    psPrevNode = *ppsPrevLink;
+    psPrevNode->psNextNode = psNode->psNextNode;
+    psNode->psNextNode = psPrevNode;
+    *ppsPrevLink = psNode;
+    return ppsPrevLink;
 }
 
-void *SymTable_replace(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue) 
+/* Return the address of the link in the chain that begins at *ppsHead
+that points to the binding whose key is the uLength characters at
+pcKey and whose full hash code is uHash, or NULL if the chain has no
+such binding. If iPromote is 1 (TRUE), first move the binding forward
+as the order of oSymTable says. */
+static struct SymTableNode **SymTable_findInChain(SymTable_T oSymTable,
+    struct SymTableNode **ppsHead, const char *pcKey, size_t uLength,
+    size_t uHash, int iPromote)
 {
-    struct SymTableNode *psCurrentNode;
-    const void *pvValueOld; 
-    size_t hash_code; 
-    
-    assert(oSymTable != NULL); 
+    struct SymTableNode **ppsLink;
+    struct SymTableNode **ppsPrevLink = NULL;
+
+    assert(oSymTable != NULL);
+    assert(ppsHead != NULL);
     assert(pcKey != NULL);
 
-    hash_code = SymTable_hash(pcKey, oSymTable->uBucketCount);
-    
-    for (psCurrentNode = oSymTable->ppsHashTable[hash_code];
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
+    for (ppsLink = ppsHead;
+        *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNextNode)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
+        SYMTABLE_COUNT(oSymTable, uProbes, 1);
+        SYMTABLE_TRACE_PROBES(oSymTable, 1);
+        if (SymTable_nodeMatches(*ppsLink, pcKey, uLength, uHash))
         {
-            pvValueOld = psCurrentNode->pvValue;
-            psCurrentNode->pvValue = pvValue;
-            return (void*)pvValueOld; 
+            if (iPromote)
+            {
+                return SymTable_promote(oSymTable->eOrder, ppsHead,
+                    ppsPrevLink, ppsLink);
+            }
+            return ppsLink;
         }
+        ppsPrevLink = ppsLink;
     }
-    return NULL; 
+    return NULL;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+/* Return the address of the link (a bucket head or a psNextNode
+field) that points to the binding in oSymTable whose key is the
+uLength characters at pcKey and whose full hash code is uHash, or NULL
+if no such binding exists. If iPromote is 1 (TRUE), first move the
+binding forward in its bucket as the order of oSymTable says. */
+static struct SymTableNode **SymTable_findLink(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, int iPromote)
 {
-    struct SymTableNode *psCurrentNode;
-    size_t hash_code; 
+    struct SymTableNode **ppsLink;
+    size_t hash_code;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL); 
+    assert(pcKey != NULL);
 
-    hash_code = SymTable_hash(pcKey, oSymTable->uBucketCount);
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
 
-    for (psCurrentNode = oSymTable->ppsHashTable[hash_code];
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
+    /* An old bucket that has not been moved yet may still hold the
+    binding. */
+    if (oSymTable->ppsOldHashTable != NULL)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
+        hash_code = SymTable_bucket(oSymTable, uHash,
+            oSymTable->uOldBucketCount);
+        if (hash_code >= oSymTable->uRehashIndex)
         {
-            return 1;
+            ppsLink = SymTable_findInChain(oSymTable,
+                &oSymTable->ppsOldHashTable[hash_code], pcKey, uLength,
+                uHash, iPromote);
+            if (ppsLink != NULL)
+            {
+                return ppsLink;
+            }
         }
     }
-    return 0; 
+
+    hash_code = SymTable_bucket(oSymTable, uHash,
+        oSymTable->uBucketCount);
+    return SymTable_findInChain(oSymTable,
+        &oSymTable->ppsHashTable[hash_code], pcKey, uLength, uHash,
+        iPromote);
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey) 
+/* Free every node in the chain that begins with psFirstNode. The
+nodes must have been allocated with malloc. */
+static void SymTable_freeChain(struct SymTableNode *psFirstNode)
 {
     struct SymTableNode *psCurrentNode;
-    const void *pvTargetValue; 
-    size_t hash_code; 
-    
-    assert(oSymTable != NULL); 
-    assert(pcKey != NULL); 
-
-    hash_code = SymTable_hash(pcKey, oSymTable->uBucketCount);
+    struct SymTableNode *psNextNode;
 
-    for (psCurrentNode = oSymTable->ppsHashTable[hash_code];
+    for (psCurrentNode = psFirstNode;
         psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
+        psCurrentNode = psNextNode)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
-        {
-            pvTargetValue = psCurrentNode->pvValue;
-            return (void*)pvTargetValue; 
-        }
+        psNextNode = psCurrentNode->psNextNode;
+        free(psCurrentNode);
     }
-    return NULL; 
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) 
+/* Apply function *pfApply to each binding in the chain that begins
+with psFirstNode, passing pvExtra as an extra parameter. */
+static void SymTable_mapChain(struct SymTableNode *psFirstNode,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
 {
     struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNodeToRemove; 
-    struct SymTableNode *psFirstNode; 
-    const void *pvRemovedValue; 
-    size_t hash_code; 
-
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL); 
 
-    hash_code = SymTable_hash(pcKey, oSymTable->uBucketCount);
-    psFirstNode = oSymTable->ppsHashTable[hash_code]; 
-    
-    /* Handle if the binding to be removed is first in the 
-    list. */
-    if (psFirstNode != NULL && 
-        strcmp(psFirstNode->pcKey, pcKey) == 0) 
-        {
-            pvRemovedValue = psFirstNode->pvValue;
-            oSymTable->ppsHashTable[hash_code] = 
-            psFirstNode->psNextNode;
-            free(psFirstNode->pcKey);
-            free(psFirstNode);
-            oSymTable->uLength--; 
-            return (void*)pvRemovedValue; 
-        }
+    assert(pfApply != NULL);
 
-    /* Handle all other cases */
     for (psCurrentNode = psFirstNode;
-        psCurrentNode != NULL; 
+        psCurrentNode != NULL;
         psCurrentNode = psCurrentNode->psNextNode)
     {
-        if (psCurrentNode->psNextNode != NULL && 
-            strcmp(psCurrentNode->psNextNode->pcKey, pcKey) == 0)
+        (*pfApply) ((void*)psCurrentNode->acKey,
+        (void*)psCurrentNode->pvValue, ((void*)pvExtra));
+    }
+}
+
+/* The state of one call of SymTable_mapParallel. Its tasks cover
+the unmoved part of the old bucket array, if any, and then the
+current bucket array, MAP_TASK_BUCKETS buckets at a time. */
+struct SymTableMapRun
+{
+    /* The table being mapped. */
+    SymTable_T oSymTable;
+    /* The function to apply to each binding. */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* The extra parameter of each worker. */
+    void *const *ppvExtras;
+    /* Number of tasks that cover the old bucket array. */
+    size_t uOldTaskCount;
+};
+
+/* Return the number of tasks needed to cover uBuckets buckets. */
+static size_t SymTable_mapTaskCount(size_t uBuckets)
+{
+    return uBuckets / MAP_TASK_BUCKETS
+        + (uBuckets % MAP_TASK_BUCKETS != 0);
+}
+
+/* Apply the function of pvRun, a struct SymTableMapRun, to the
+bindings in the buckets of task uTask, passing the extra parameter of
+worker uWorker. */
+static void SymTable_mapTask(void *pvRun, size_t uTask, size_t uWorker)
+{
+    struct SymTableMapRun *psRun = (struct SymTableMapRun*)pvRun;
+    SymTable_T oSymTable;
+    struct SymTableNode **ppsBuckets;
+    size_t uFirst;
+    size_t uLast;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    oSymTable = psRun->oSymTable;
+    if (uTask < psRun->uOldTaskCount)
+    {
+        ppsBuckets = oSymTable->ppsOldHashTable;
+        uFirst = oSymTable->uRehashIndex + uTask * MAP_TASK_BUCKETS;
+        uLast = oSymTable->uOldBucketCount;
+    }
+    else
+    {
+        ppsBuckets = oSymTable->ppsHashTable;
+        uFirst = (uTask - psRun->uOldTaskCount) * MAP_TASK_BUCKETS;
+        uLast = oSymTable->uBucketCount;
+    }
+    if (uLast - uFirst > MAP_TASK_BUCKETS)
+    {
+        uLast = uFirst + MAP_TASK_BUCKETS;
+    }
+
+    for (i = uFirst; i < uLast; i++)
+    {
+        SymTable_mapChain(ppsBuckets[i], psRun->pfApply,
+            psRun->ppvExtras[uWorker]);
+    }
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uBucketCount;
+
+    uBucketCount = SymTable_bucketCountFor(uCapacity);
+    if (uBucketCount == 0)
+    {
+        return NULL;
+    }
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oSymTable->psSmallBucket = NULL;
+    if (uCapacity <= SMALL_TABLE_LIMIT)
+    {
+        oSymTable->ppsHashTable = &oSymTable->psSmallBucket;
+        uBucketCount = 1;
+    }
+    else
+    {
+        oSymTable->ppsHashTable = (struct SymTableNode**)
+            calloc(uBucketCount, sizeof(struct SymTableNode*));
+        if (oSymTable->ppsHashTable == NULL)
         {
-            psNodeToRemove = psCurrentNode->psNextNode; 
-            pvRemovedValue = psNodeToRemove->pvValue; 
-            psCurrentNode->psNextNode = psNodeToRemove->psNextNode;  
-            free(psNodeToRemove->pcKey);
-            free(psNodeToRemove);
-            oSymTable->uLength--; 
-            return (void*)pvRemovedValue;
+            free(oSymTable);
+            return NULL;
         }
     }
-    return NULL; 
+
+    oSymTable->uBucketCount = uBucketCount;
+    oSymTable->ppsOldHashTable = NULL;
+    oSymTable->uOldBucketCount = 0;
+    oSymTable->uRehashIndex = 0;
+    oSymTable->uLength = 0;
+    oSymTable->oArena = NULL;
+    oSymTable->pfHash = StrHash_multiply;
+    oSymTable->eOrder = SYMTABLE_ORDER_FIXED;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+#endif
+#ifdef SYMTABLE_TRACE
+    memset(&oSymTable->sTrace, 0, sizeof(oSymTable->sTrace));
+#endif
+
+    return oSymTable;
 }
 
-void SymTable_map(SymTable_T oSymTable,
-    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
-    const void *pvExtra) 
+SymTable_T SymTable_new(void)
 {
-        struct SymTableNode *psCurrentNode;
-        size_t i; 
-        
-        assert(oSymTable != NULL);
-        assert(pfApply != NULL);
-    
-     for (i = 0; i < oSymTable->uBucketCount; i++)
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newArena(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
     {
-        if (oSymTable->ppsHashTable[i] != NULL) 
-        {
-            for (psCurrentNode = oSymTable->ppsHashTable[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psCurrentNode->psNextNode)
-            {
-                (*pfApply) ((void*)psCurrentNode->pcKey, 
-                (void*)psCurrentNode->pvValue, ((void*)pvExtra)); 
-            }
-        }  
+        return NULL;
+    }
+
+    oSymTable->oArena = Arena_new();
+    if (oSymTable->oArena == NULL)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
     }
-}
\ No newline at end of file
+
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash)
+{
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oSymTable->pfHash = pfHash;
+
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_FREE(oSymTable);
+    /* Arena nodes are released together with their slabs, so the
+    buckets need not be walked at all. */
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_free(oSymTable->oArena);
+        if (oSymTable->ppsOldHashTable != NULL)
+        {
+            SymTable_freeBuckets(oSymTable,
+                oSymTable->ppsOldHashTable);
+        }
+        SymTable_freeBuckets(oSymTable, oSymTable->ppsHashTable);
+        free(oSymTable);
+        return;
+    }
+
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        for (i = oSymTable->uRehashIndex;
+            i < oSymTable->uOldBucketCount; i++)
+        {
+            SymTable_freeChain(oSymTable->ppsOldHashTable[i]);
+        }
+        SymTable_freeBuckets(oSymTable, oSymTable->ppsOldHashTable);
+    }
+
+    for (i = 0; i < oSymTable->uBucketCount; i++)
+    {
+        SymTable_freeChain(oSymTable->ppsHashTable[i]);
+    }
+    SymTable_freeBuckets(oSymTable, oSymTable->ppsHashTable);
+    free(oSymTable);
+}
+
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_hash(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Do the work of SymTable_reserve, which traces it. */
+static int SymTable_reserveUntraced(SymTable_T oSymTable,
+    size_t uCapacity)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    uBucketCount = SymTable_bucketCountFor(uCapacity);
+    if (uBucketCount == 0)
+    {
+        return 0;
+    }
+    if (uCapacity <= SymTable_capacity(oSymTable))
+    {
+        return 1;
+    }
+
+    /* Move every binding now rather than a few buckets at a time, so
+    that the puts that follow run at full speed. */
+    if (!SymTable_resizeTo(oSymTable, uBucketCount))
+    {
+        return 0;
+    }
+    SymTable_rehashStep(oSymTable, (size_t)-1);
+    return 1;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_reserveUntraced(oSymTable, uCapacity);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RESERVE, NULL);
+    return iSuccessful;
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    return oSymTable->uLength;
+}
+
+/* Return the node of the binding in oSymTable whose key is the
+uLength characters at pcKey, whose full hash code is uHash, first
+putting a binding of that key and pvValue if there is none. Set
+*piAdded to 1 (TRUE) if a binding was put, or 0 (FALSE) otherwise.
+Return NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_findOrAdd(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue, int *piAdded)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNewNode;
+    size_t hash_code;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piAdded != NULL);
+
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+    SYMTABLE_COUNT(oSymTable, uPuts, 1);
+    *piAdded = 0;
+
+    /* Prompt expansion if # of bindings is as least the amount of
+    current buckets. If expansion fails the table keeps working with
+    longer chains. */
+    if (oSymTable->uLength >= SymTable_capacity(oSymTable))
+    {
+        (void)SymTable_expand(oSymTable);
+    }
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash, 0);
+    if (ppsLink != NULL)
+    {
+        return *ppsLink;
+    }
+
+    psNewNode = SymTable_allocNode(oSymTable, uLength);
+    if (psNewNode == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(psNewNode->acKey, pcKey, uLength);
+    psNewNode->acKey[uLength] = '\0';
+    psNewNode->uKeyLength = uLength;
+
+    /* New bindings always go into the current bucket array. */
+    hash_code = SymTable_bucket(oSymTable, uHash,
+        oSymTable->uBucketCount);
+
+    psNewNode->uHash = uHash;
+    psNewNode->pvValue = pvValue;
+    psNewNode->psNextNode = oSymTable->ppsHashTable[hash_code];
+    oSymTable->ppsHashTable[hash_code] = psNewNode;
+    oSymTable->uLength++;
+    *piAdded = 1;
+    return psNewNode;
+}
+
+/* Put a binding of the uLength characters at pcKey, whose full hash
+code is uHash, and pvValue into oSymTable. Return 1 (TRUE) if
+successful, or 0 (FALSE) if the key is already present or
+insufficient memory is available. */
+static int SymTable_putWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue)
+{
+    int iAdded;
+
+    return SymTable_findOrAdd(oSymTable, pcKey, uLength, uHash,
+        pvValue, &iAdded) != NULL && iAdded;
+}
+
+int SymTable_putLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash, pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uLength;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+size_t SymTable_putMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues,
+    size_t uCount)
+{
+    size_t uAdded = 0;
+    size_t uLength;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Size the table once, so that no put below expands it. If that
+    fails, the puts still expand the table as they go. */
+    if (uCount <= (size_t)-1 - oSymTable->uLength)
+    {
+        (void)SymTable_reserveUntraced(oSymTable,
+            oSymTable->uLength + uCount);
+    }
+
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        uLength = strlen(ppcKeys[i]);
+        if (SymTable_putWithHash(oSymTable, ppcKeys[i], uLength,
+            SymTable_hash(oSymTable, ppcKeys[i], uLength),
+            ppvValues[i]))
+        {
+            uAdded++;
+        }
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT_MANY, NULL);
+    return uAdded;
+}
+
+/* If oSymTable contains a binding whose key is the uLength characters
+at pcKey, with full hash code uHash, then replace the binding's value
+with pvValue and return the old value. Otherwise return NULL. */
+static void *SymTable_replaceWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue)
+{
+    struct SymTableNode **ppsLink;
+    const void *pvValueOld;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash, 1);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, ppsLink != NULL);
+    if (ppsLink == NULL)
+    {
+        return NULL;
+    }
+
+    pvValueOld = (*ppsLink)->pvValue;
+    (*ppsLink)->pvValue = pvValue;
+    return (void*)pvValueOld;
+}
+
+void *SymTable_replaceLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replaceHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash, pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uLength;
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+/* Return 1 (TRUE) if oSymTable contains the key that is the uLength
+characters at pcKey, with full hash code uHash, or 0 (FALSE)
+otherwise. */
+static int SymTable_containsWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    iFound =
+        SymTable_findLink(oSymTable, pcKey, uLength, uHash, 1) != NULL;
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, iFound);
+    return iFound;
+}
+
+int SymTable_containsLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsWithHash(oSymTable, pcKey, strlen(pcKey),
+        uHash);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    iFound = SymTable_containsWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+/* Return the value of the binding within oSymTable whose key is the
+uLength characters at pcKey, with full hash code uHash, or NULL if no
+such binding exists. */
+static void *SymTable_getWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    struct SymTableNode **ppsLink;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash, 1);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, ppsLink != NULL);
+    if (ppsLink == NULL)
+    {
+        return NULL;
+    }
+    return (void*)(*ppsLink)->pvValue;
+}
+
+void *SymTable_getLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, strlen(pcKey),
+        uHash);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+/* Look up the uCount (at most GET_MANY_BATCH) keys in ppcKeys and
+store their values, or NULL, in ppvValues. All keys are hashed and
+their buckets prefetched first; the chains are then walked one node
+per key per round, so the cache misses of different keys overlap
+instead of being taken one after another. */
+static void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues)
+{
+    struct SymTableNode **appsHeads[GET_MANY_BATCH];
+    struct SymTableNode *apsNodes[GET_MANY_BATCH];
+    struct SymTableNode *apsOldHeads[GET_MANY_BATCH];
+    size_t auLengths[GET_MANY_BATCH];
+    size_t auHashes[GET_MANY_BATCH];
+    size_t uActive;
+    size_t uOld;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(uCount <= GET_MANY_BATCH);
+
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        auLengths[i] = strlen(ppcKeys[i]);
+        auHashes[i] = SymTable_hash(oSymTable, ppcKeys[i],
+            auLengths[i]);
+        appsHeads[i] = &oSymTable->ppsHashTable[SymTable_bucket(
+            oSymTable, auHashes[i], oSymTable->uBucketCount)];
+        SymTable_prefetch(appsHeads[i]);
+    }
+
+    /* An old bucket that has not been moved yet is walked after the
+    current one. */
+    for (i = 0; i < uCount; i++)
+    {
+        apsOldHeads[i] = NULL;
+        if (oSymTable->ppsOldHashTable != NULL)
+        {
+            uOld = SymTable_bucket(oSymTable, auHashes[i],
+                oSymTable->uOldBucketCount);
+            if (uOld >= oSymTable->uRehashIndex)
+            {
+                apsOldHeads[i] = oSymTable->ppsOldHashTable[uOld];
+            }
+        }
+        apsNodes[i] = *appsHeads[i];
+        if (apsNodes[i] != NULL)
+        {
+            SymTable_prefetch(apsNodes[i]);
+        }
+        ppvValues[i] = NULL;
+    }
+
+    SYMTABLE_COUNT(oSymTable, uGets, uCount);
+    SYMTABLE_COUNT(oSymTable, uSearches, uCount);
+    uActive = uCount;
+    while (uActive > 0)
+    {
+        uActive = 0;
+        for (i = 0; i < uCount; i++)
+        {
+            if (apsNodes[i] == NULL)
+            {
+                if (apsOldHeads[i] == NULL)
+                {
+                    continue;
+                }
+                apsNodes[i] = apsOldHeads[i];
+                apsOldHeads[i] = NULL;
+            }
+            else if (SymTable_nodeMatches(apsNodes[i], ppcKeys[i],
+                auLengths[i], auHashes[i]))
+            {
+                SYMTABLE_COUNT(oSymTable, uProbes, 1);
+                SYMTABLE_TRACE_PROBES(oSymTable, 1);
+                SYMTABLE_COUNT(oSymTable, uHits, 1);
+                ppvValues[i] = (void*)apsNodes[i]->pvValue;
+                apsNodes[i] = NULL;
+                apsOldHeads[i] = NULL;
+                continue;
+            }
+            else
+            {
+                SYMTABLE_COUNT(oSymTable, uProbes, 1);
+                SYMTABLE_TRACE_PROBES(oSymTable, 1);
+                apsNodes[i] = apsNodes[i]->psNextNode;
+            }
+
+            if (apsNodes[i] != NULL)
+            {
+                SymTable_prefetch(apsNodes[i]);
+            }
+            if (apsNodes[i] != NULL || apsOldHeads[i] != NULL)
+            {
+                uActive++;
+            }
+        }
+    }
+}
+
+void SymTable_getMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues)
+{
+    size_t uBatch;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    while (uCount > 0)
+    {
+        uBatch = uCount < GET_MANY_BATCH ? uCount : GET_MANY_BATCH;
+        SymTable_getBatch(oSymTable, ppcKeys, uBatch, ppvValues);
+        ppcKeys += uBatch;
+        ppvValues += uBatch;
+        uCount -= uBatch;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_MANY, NULL);
+}
+
+/* If oSymTable contains a binding whose key is the uLength characters
+at pcKey, with full hash code uHash, remove that binding from
+oSymTable and return the binding's value. Otherwise return NULL. */
+static void *SymTable_removeWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNodeToRemove;
+    const void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash, 0);
+    if (ppsLink == NULL)
+    {
+        return NULL;
+    }
+
+    psNodeToRemove = *ppsLink;
+    pvRemovedValue = psNodeToRemove->pvValue;
+    *ppsLink = psNodeToRemove->psNextNode;
+    SymTable_freeNode(oSymTable, psNodeToRemove);
+    oSymTable->uLength--;
+
+    SymTable_shrink(oSymTable);
+    return (void*)pvRemovedValue;
+}
+
+void *SymTable_removeLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+        size_t i;
+
+        assert(oSymTable != NULL);
+        assert(pfApply != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        for (i = oSymTable->uRehashIndex;
+            i < oSymTable->uOldBucketCount; i++)
+        {
+            SymTable_mapChain(oSymTable->ppsOldHashTable[i],
+                pfApply, pvExtra);
+        }
+    }
+
+     for (i = 0; i < oSymTable->uBucketCount; i++)
+    {
+        SymTable_mapChain(oSymTable->ppsHashTable[i],
+            pfApply, pvExtra);
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP, NULL);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *const *ppvExtras, size_t uWorkerCount)
+{
+    struct SymTableMapRun sRun;
+    size_t uTaskCount;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(ppvExtras != NULL);
+    assert(uWorkerCount > 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    sRun.oSymTable = oSymTable;
+    sRun.pfApply = pfApply;
+    sRun.ppvExtras = ppvExtras;
+    sRun.uOldTaskCount = 0;
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        sRun.uOldTaskCount = SymTable_mapTaskCount(
+            oSymTable->uOldBucketCount - oSymTable->uRehashIndex);
+    }
+    uTaskCount = sRun.uOldTaskCount
+        + SymTable_mapTaskCount(oSymTable->uBucketCount);
+
+    Parallel_run(uTaskCount, uWorkerCount, SymTable_mapTask, &sRun);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL, NULL);
+}
+
+/* A SymTableIter walks the bindings of its table in iteration order:
+by position (see SymTable_order), then by key length, then by key
+bytes. That order is total and does not depend on the bucket count,
+so remembering the last binding returned is enough to resume. */
+struct SymTableIter
+{
+    /* The table being walked. */
+    SymTable_T oSymTable;
+    /* 1 (TRUE) once a binding has been returned, 0 (FALSE) before. */
+    int iStarted;
+    /* The position of the last binding returned. */
+    size_t uLastOrder;
+    /* A copy of the key of the last binding returned, not null
+    terminated, or NULL if none has been returned. */
+    char *pcLastKey;
+    /* The number of characters in pcLastKey. */
+    size_t uLastLength;
+    /* The number of bytes allocated for pcLastKey. */
+    size_t uKeyCapacity;
+};
+
+/* Return a negative number, 0, or a positive number as the binding at
+position uOrder1 whose key is the uLength1 characters at pcKey1 comes
+before, is the same as, or comes after the binding at position uOrder2
+whose key is the uLength2 characters at pcKey2 in iteration order. */
+static int SymTable_compareOrder(size_t uOrder1, const char *pcKey1,
+    size_t uLength1, size_t uOrder2, const char *pcKey2,
+    size_t uLength2)
+{
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    if (uOrder1 != uOrder2)
+    {
+        return uOrder1 < uOrder2 ? -1 : 1;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return memcmp(pcKey1, pcKey2, uLength1);
+}
+
+/* Return 1 (TRUE) if psNode comes after the last binding oIter
+returned, or if oIter has returned none yet; 0 (FALSE) otherwise. */
+static int SymTable_iterAfter(SymTableIter_T oIter,
+    const struct SymTableNode *psNode)
+{
+    assert(oIter != NULL);
+    assert(psNode != NULL);
+
+    return !oIter->iStarted
+        || SymTable_compareOrder(SymTable_order(psNode->uHash),
+            psNode->acKey, psNode->uKeyLength, oIter->uLastOrder,
+            oIter->pcLastKey, oIter->uLastLength) > 0;
+}
+
+/* Return whichever of psNode1 and psNode2 comes first in iteration
+order. Either may be NULL, in which case the other is returned. */
+static struct SymTableNode *SymTable_iterFirst(
+    struct SymTableNode *psNode1, struct SymTableNode *psNode2)
+{
+    if (psNode1 == NULL)
+        return psNode2;
+    if (psNode2 == NULL)
+        return psNode1;
+    if (SymTable_compareOrder(SymTable_order(psNode2->uHash),
+        psNode2->acKey, psNode2->uKeyLength,
+        SymTable_order(psNode1->uHash), psNode1->acKey,
+        psNode1->uKeyLength) < 0)
+    {
+        return psNode2;
+    }
+    return psNode1;
+}
+
+/* Return the first node, in iteration order, that comes after the
+last binding oIter returned, looking only in buckets uFirst onward of
+the uBucketCount buckets at ppsBuckets. Return NULL if there is none.
+Since buckets hold consecutive ranges of positions, the first bucket
+with such a node holds the answer. */
+static struct SymTableNode *SymTable_iterSearch(SymTableIter_T oIter,
+    struct SymTableNode **ppsBuckets, size_t uBucketCount,
+    size_t uFirst)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psBest;
+    size_t i;
+
+    assert(oIter != NULL);
+    assert(ppsBuckets != NULL);
+
+    for (i = uFirst; i < uBucketCount; i++)
+    {
+        psBest = NULL;
+        for (psCurrentNode = ppsBuckets[i]; psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+        {
+            if (SymTable_iterAfter(oIter, psCurrentNode))
+            {
+                psBest = SymTable_iterFirst(psBest, psCurrentNode);
+            }
+        }
+        if (psBest != NULL)
+        {
+            return psBest;
+        }
+    }
+    return NULL;
+}
+
+/* Record psNode as the last binding oIter returned. Return 1 (TRUE)
+if successful, or 0 (FALSE) if insufficient memory is available to
+copy its key. */
+static int SymTable_iterRemember(SymTableIter_T oIter,
+    const struct SymTableNode *psNode)
+{
+    char *pcNewKey;
+
+    assert(oIter != NULL);
+    assert(psNode != NULL);
+
+    /* +1 so that even an empty key gets a buffer. */
+    if (psNode->uKeyLength + 1 > oIter->uKeyCapacity)
+    {
+        pcNewKey = (char*)realloc(oIter->pcLastKey,
+            psNode->uKeyLength + 1);
+        if (pcNewKey == NULL)
+        {
+            return 0;
+        }
+        oIter->pcLastKey = pcNewKey;
+        oIter->uKeyCapacity = psNode->uKeyLength + 1;
+    }
+    memcpy(oIter->pcLastKey, psNode->acKey, psNode->uKeyLength);
+    oIter->uLastLength = psNode->uKeyLength;
+    oIter->uLastOrder = SymTable_order(psNode->uHash);
+    oIter->iStarted = 1;
+    return 1;
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    oIter = (SymTableIter_T)malloc(sizeof(struct SymTableIter));
+    if (oIter != NULL)
+    {
+        oIter->oSymTable = oSymTable;
+        oIter->iStarted = 0;
+        oIter->uLastOrder = 0;
+        oIter->pcLastKey = NULL;
+        oIter->uLastLength = 0;
+        oIter->uKeyCapacity = 0;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_BEGIN, NULL);
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    SymTable_T oSymTable;
+    struct SymTableNode *psBest;
+    size_t uFirst;
+    int iFound = 0;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    oSymTable = oIter->oSymTable;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Bindings that come after the last one returned are at or after
+    its position, so buckets before the one it maps to are skipped. */
+    psBest = SymTable_iterSearch(oIter, oSymTable->ppsHashTable,
+        oSymTable->uBucketCount,
+        StrHash_reduce(oIter->uLastOrder, oSymTable->uBucketCount));
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        uFirst = StrHash_reduce(oIter->uLastOrder,
+            oSymTable->uOldBucketCount);
+        if (uFirst < oSymTable->uRehashIndex)
+        {
+            uFirst = oSymTable->uRehashIndex;
+        }
+        psBest = SymTable_iterFirst(psBest,
+            SymTable_iterSearch(oIter, oSymTable->ppsOldHashTable,
+                oSymTable->uOldBucketCount, uFirst));
+    }
+
+    if (psBest != NULL && SymTable_iterRemember(oIter, psBest))
+    {
+        *ppcKey = psBest->acKey;
+        *ppvValue = (void*)psBest->pvValue;
+        iFound = 1;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_NEXT, NULL);
+    return iFound;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    assert(oIter != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oIter->oSymTable);
+    free(oIter->pcLastKey);
+    SYMTABLE_TRACE_END(oIter->oSymTable, SYMTABLE_TRACE_ITER_END, NULL);
+    free(oIter);
+}
+
+/* The bounds of a SymTable_range or SymTable_prefix query. */
+struct SymTableBounds
+{
+    /* Every selected key is at least the uLowLength characters at
+    pcLow. */
+    const char *pcLow;
+    size_t uLowLength;
+    /* Every selected key is less than the uHighLength characters at
+    pcHigh, or, if pcHigh is NULL, begins with the characters at
+    pcLow. */
+    const char *pcHigh;
+    size_t uHighLength;
+};
+
+/* Return a negative number, 0, or a positive number as the uLength1
+characters at pcKey1 come before, are the same as, or come after the
+uLength2 characters at pcKey2. Keys are compared character by
+character as unsigned chars, and a key comes after its own
+prefixes. */
+static int SymTable_compareKeys(const char *pcKey1, size_t uLength1,
+    const char *pcKey2, size_t uLength2)
+{
+    int iResult;
+
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    iResult = memcmp(pcKey1, pcKey2,
+        uLength1 < uLength2 ? uLength1 : uLength2);
+    if (iResult != 0)
+    {
+        return iResult;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Return 1 (TRUE) if the uLength characters at pcKey are within
+psBounds, or 0 (FALSE) otherwise. */
+static int SymTable_inBounds(const struct SymTableBounds *psBounds,
+    const char *pcKey, size_t uLength)
+{
+    assert(psBounds != NULL);
+    assert(pcKey != NULL);
+
+    if (psBounds->pcHigh == NULL)
+    {
+        return uLength >= psBounds->uLowLength &&
+            memcmp(pcKey, psBounds->pcLow, psBounds->uLowLength) == 0;
+    }
+    return SymTable_compareKeys(pcKey, uLength, psBounds->pcLow,
+            psBounds->uLowLength) >= 0
+        && SymTable_compareKeys(pcKey, uLength, psBounds->pcHigh,
+            psBounds->uHighLength) < 0;
+}
+
+/* Compare the keys of the nodes that pv1 and pv2 point to, as
+SymTable_compareKeys does. Suitable for qsort. */
+static int SymTable_compareNodes(const void *pv1, const void *pv2)
+{
+    const struct SymTableNode *psNode1 =
+        *(struct SymTableNode *const *)pv1;
+    const struct SymTableNode *psNode2 =
+        *(struct SymTableNode *const *)pv2;
+
+    return SymTable_compareKeys(psNode1->acKey, psNode1->uKeyLength,
+        psNode2->acKey, psNode2->uKeyLength);
+}
+
+/* Count the nodes within psBounds in buckets uFirst onward of the
+uBucketCount buckets at ppsBuckets, storing them from ppsSelected on
+unless ppsSelected is NULL. Return the count. */
+static size_t SymTable_gather(struct SymTableNode **ppsBuckets,
+    size_t uFirst, size_t uBucketCount,
+    const struct SymTableBounds *psBounds,
+    struct SymTableNode **ppsSelected)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t uCount = 0;
+    size_t i;
+
+    assert(ppsBuckets != NULL);
+    assert(psBounds != NULL);
+
+    for (i = uFirst; i < uBucketCount; i++)
+    {
+        for (psCurrentNode = ppsBuckets[i]; psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+        {
+            if (!SymTable_inBounds(psBounds, psCurrentNode->acKey,
+                psCurrentNode->uKeyLength))
+            {
+                continue;
+            }
+            if (ppsSelected != NULL)
+            {
+                ppsSelected[uCount] = psCurrentNode;
+            }
+            uCount++;
+        }
+    }
+    return uCount;
+}
+
+/* Apply *pfApply, passing pvExtra, to each binding of oSymTable within
+psBounds, in increasing order of key. Buckets keep no order, so the
+bindings are gathered and sorted first. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available. */
+static int SymTable_applyRange(SymTable_T oSymTable,
+    const struct SymTableBounds *psBounds,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode **ppsSelected;
+    size_t uCount;
+    size_t uOldCount = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psBounds != NULL);
+    assert(pfApply != NULL);
+
+    uCount = SymTable_gather(oSymTable->ppsHashTable, 0,
+        oSymTable->uBucketCount, psBounds, NULL);
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        uOldCount = SymTable_gather(oSymTable->ppsOldHashTable,
+            oSymTable->uRehashIndex, oSymTable->uOldBucketCount,
+            psBounds, NULL);
+    }
+    if (uCount + uOldCount == 0)
+    {
+        return 1;
+    }
+
+    ppsSelected = (struct SymTableNode**)
+        malloc((uCount + uOldCount) * sizeof(struct SymTableNode*));
+    if (ppsSelected == NULL)
+    {
+        return 0;
+    }
+    (void)SymTable_gather(oSymTable->ppsHashTable, 0,
+        oSymTable->uBucketCount, psBounds, ppsSelected);
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        (void)SymTable_gather(oSymTable->ppsOldHashTable,
+            oSymTable->uRehashIndex, oSymTable->uOldBucketCount,
+            psBounds, ppsSelected + uCount);
+    }
+    uCount += uOldCount;
+    qsort(ppsSelected, uCount, sizeof(struct SymTableNode*),
+        SymTable_compareNodes);
+
+    for (i = 0; i < uCount; i++)
+    {
+        (*pfApply) (ppsSelected[i]->acKey,
+            (void*)ppsSelected[i]->pvValue, (void*)pvExtra);
+    }
+    free(ppsSelected);
+    return 1;
+}
+
+int SymTable_range(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcLow != NULL);
+    assert(pcHigh != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcLow;
+    sBounds.uLowLength = strlen(pcLow);
+    sBounds.pcHigh = pcHigh;
+    sBounds.uHighLength = strlen(pcHigh);
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RANGE, pcLow);
+    return iSuccessful;
+}
+
+int SymTable_prefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcPrefix;
+    sBounds.uLowLength = strlen(pcPrefix);
+    sBounds.pcHigh = NULL;
+    sBounds.uHighLength = 0;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PREFIX, pcPrefix);
+    return iSuccessful;
+}
+
+/* Return the node of a SymTable whose key is at pcKey, a pointer that
+SymTable_intern returned. Nodes never move, even when the table
+resizes, so the address of the key is enough. */
+static struct SymTableNode *SymTable_internedNode(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return (struct SymTableNode*)(void*)
+        (pcKey - offsetof(struct SymTableNode, acKey));
+}
+
+/* Return the address of the link (a bucket head or a psNextNode
+field) in oSymTable that points to psNode, one of its nodes. The
+cached hash code of psNode gives its bucket, and the chain is searched
+by address, so no key is hashed or compared. */
+static struct SymTableNode **SymTable_findNodeLink(SymTable_T oSymTable,
+    const struct SymTableNode *psNode)
+{
+    struct SymTableNode **ppsLink;
+    size_t hash_code;
+
+    assert(oSymTable != NULL);
+    assert(psNode != NULL);
+
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        hash_code = SymTable_bucket(oSymTable, psNode->uHash,
+            oSymTable->uOldBucketCount);
+        if (hash_code >= oSymTable->uRehashIndex)
+        {
+            for (ppsLink = &oSymTable->ppsOldHashTable[hash_code];
+                *ppsLink != NULL;
+                ppsLink = &(*ppsLink)->psNextNode)
+            {
+                if (*ppsLink == psNode)
+                {
+                    return ppsLink;
+                }
+            }
+        }
+    }
+
+    hash_code = SymTable_bucket(oSymTable, psNode->uHash,
+        oSymTable->uBucketCount);
+    for (ppsLink = &oSymTable->ppsHashTable[hash_code];
+        *ppsLink != psNode;
+        ppsLink = &(*ppsLink)->psNextNode)
+    {
+        assert(*ppsLink != NULL);
+    }
+    return ppsLink;
+}
+
+const char *SymTable_intern(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), NULL, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_INTERN, pcKey);
+    if (psNode == NULL)
+    {
+        return NULL;
+    }
+    return psNode->acKey;
+}
+
+void *SymTable_getInterned(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, 1);
+    pvValue = (void*)SymTable_internedNode(pcKey)->pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableNode *psNode;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psNode = SymTable_internedNode(pcKey);
+    pvOldValue = psNode->pvValue;
+    psNode->pvValue = pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return (void*)pvOldValue;
+}
+
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    const char *pcKey)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    const void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SymTable_rehashStep(oSymTable, REHASH_STEP_BUCKETS);
+
+    psNode = SymTable_internedNode(pcKey);
+    ppsLink = SymTable_findNodeLink(oSymTable, psNode);
+    pvRemovedValue = psNode->pvValue;
+    *ppsLink = psNode->psNextNode;
+    SymTable_freeNode(oSymTable, psNode);
+    oSymTable->uLength--;
+
+    SymTable_shrink(oSymTable);
+    /* The key went with the node. */
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, NULL);
+    return (void*)pvRemovedValue;
+}
+
+/* Add the layout of the uBucketCount buckets at ppsBuckets, from
+bucket uFirst on, to *psStats. */
+static void SymTable_addBuckets(struct SymTableNode **ppsBuckets,
+    size_t uFirst, size_t uBucketCount, struct SymTableStats *psStats)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t uChainLength;
+    size_t i;
+
+    assert(ppsBuckets != NULL);
+    assert(psStats != NULL);
+
+    psStats->uBucketBytes +=
+        uBucketCount * sizeof(struct SymTableNode*);
+    for (i = uFirst; i < uBucketCount; i++)
+    {
+        uChainLength = 0;
+        for (psCurrentNode = ppsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+        {
+            uChainLength++;
+            psStats->uNodeBytes += offsetof(struct SymTableNode, acKey);
+            psStats->uKeyBytes += psCurrentNode->uKeyLength + 1;
+        }
+        if (uChainLength > psStats->uMaxChainLength)
+        {
+            psStats->uMaxChainLength = uChainLength;
+        }
+        if (uChainLength >= SYMTABLE_HISTOGRAM_SIZE)
+        {
+            uChainLength = SYMTABLE_HISTOGRAM_SIZE - 1;
+        }
+        psStats->auChainLengths[uChainLength]++;
+    }
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    struct SymTableStats sOld;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uLength = oSymTable->uLength;
+    psStats->uBucketCount = oSymTable->uBucketCount;
+    psStats->dLoadFactor =
+        (double)oSymTable->uLength / (double)oSymTable->uBucketCount;
+
+    SymTable_addBuckets(oSymTable->ppsHashTable, 0,
+        oSymTable->uBucketCount, psStats);
+    /* The small layout's one bucket is part of the table itself, not
+    an allocated bucket array. */
+    if (SymTable_isSmall(oSymTable))
+    {
+        psStats->uBucketBytes = 0;
+    }
+    /* While a resize is in progress, the bindings not yet moved are
+    counted too; their buckets are not part of the histogram. */
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        memset(&sOld, 0, sizeof(sOld));
+        SymTable_addBuckets(oSymTable->ppsOldHashTable,
+            oSymTable->uRehashIndex, oSymTable->uOldBucketCount, &sOld);
+        psStats->uNodeBytes += sOld.uNodeBytes;
+        psStats->uKeyBytes += sOld.uKeyBytes;
+        psStats->uBucketBytes += sOld.uBucketBytes;
+    }
+
+#ifdef SYMTABLE_STATS
+    psStats->uPuts = oSymTable->sCounters.uPuts;
+    psStats->uGets = oSymTable->sCounters.uGets;
+    psStats->uHits = oSymTable->sCounters.uHits;
+    psStats->uMisses =
+        oSymTable->sCounters.uGets - oSymTable->sCounters.uHits;
+    psStats->uExpansions = oSymTable->sCounters.uExpansions;
+    if (oSymTable->sCounters.uSearches > 0)
+    {
+        psStats->dProbesPerLookup =
+            (double)oSymTable->sCounters.uProbes /
+            (double)oSymTable->sCounters.uSearches;
+    }
+#endif
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_STATS, NULL);
+}
+
+void SymTable_setOrder(SymTable_T oSymTable,
+    enum SymTableOrder eOrder)
+{
+    assert(oSymTable != NULL);
+
+    oSymTable->eOrder = eOrder;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue)
+{
+    struct SymTableNode *psNode;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue, &iAdded);
+    if (psNode != NULL)
+    {
+        if (ppvOldValue != NULL)
+        {
+            *ppvOldValue = iAdded ? NULL : (void*)psNode->pvValue;
+        }
+        psNode->pvValue = pvValue;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_UPSERT, pcKey);
+    return psNode != NULL;
+}
+
+void **SymTable_getOrInsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue)
+{
+    struct SymTableNode *psNode;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_OR_INSERT,
+        pcKey);
+    return psNode == NULL ? NULL : (void**)&psNode->pvValue;
+}
+
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t uRemoved = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfPredicate != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Bindings not yet moved by a resize in progress are swept where
+    they are. */
+    if (oSymTable->ppsOldHashTable != NULL)
+    {
+        for (i = oSymTable->uRehashIndex;
+            i < oSymTable->uOldBucketCount; i++)
+        {
+            uRemoved += SymTable_removeFromChain(oSymTable,
+                &oSymTable->ppsOldHashTable[i], pfPredicate, pfRemoved,
+                pvExtra);
+        }
+    }
+    for (i = 0; i < oSymTable->uBucketCount; i++)
+    {
+        uRemoved += SymTable_removeFromChain(oSymTable,
+            &oSymTable->ppsHashTable[i], pfPredicate, pfRemoved,
+            pvExtra);
+    }
+
+    SymTable_shrink(oSymTable);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE_IF, NULL);
+    return uRemoved;
+}
@@ -0,0 +1,572 @@
+/*--------------------------------------------------------------------*/
+/* symtableimage.c                                                    */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+
+/* mmap and the calls around it are POSIX, not C99. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "symtableimage.h"
+#include "symtable.h"
+#include "strhash.h"
+
+/* An image file is laid out as follows, every field a uint64_t in the
+byte order of the machine that wrote it:
+
+   a SymTableImageHeader;
+   uBucketCount + 1 bucket starts: bucket i holds the entries from
+      bucket start i up to, but not including, bucket start i + 1;
+   uLength SymTableImageEntry structures, in increasing order of hash
+      code, so that each bucket's entries are contiguous;
+   the keys, each followed by a null character, and the values.
+
+Keys are hashed with StrHash_word, whatever the hash function of the
+saved table, and the bucket of a hash code is chosen with
+StrHash_reduce, which preserves order. Entries refer to keys and
+values by their offset from the start of the file. */
+
+/* Identifies an image file. */
+static const char acMagic[8] = "SYMTIMG";
+
+/* Written as a uint64_t, so that an image is recognized only on a
+machine of the same byte order. */
+static const uint64_t BYTE_ORDER_MARK = 0x0102030405060708;
+
+/* The uValueSize of an entry whose value is NULL. */
+static const uint64_t NULL_VALUE_SIZE = UINT64_MAX;
+
+enum {
+    /* Values are placed at file offsets that are multiples of this,
+    and so are aligned for any type once the file is mapped. */
+    VALUE_ALIGNMENT = 16
+};
+
+/* The first bytes of an image file. */
+struct SymTableImageHeader
+{
+    /* acMagic. */
+    char acMagic[8];
+    /* BYTE_ORDER_MARK. */
+    uint64_t uByteOrder;
+    /* sizeof(size_t) on the machine that wrote the image, since the
+    hash codes depend on it. */
+    uint64_t uWordSize;
+    /* The number of bindings. */
+    uint64_t uLength;
+    /* The number of buckets. */
+    uint64_t uBucketCount;
+};
+
+/* A binding, as written in an image file. */
+struct SymTableImageEntry
+{
+    /* The StrHash_word hash code of the key. */
+    uint64_t uHash;
+    /* The offset of the key. */
+    uint64_t uKeyOffset;
+    /* The number of characters in the key, not counting the null
+    terminator. */
+    uint64_t uKeyLength;
+    /* The offset of the value. */
+    uint64_t uValueOffset;
+    /* The number of bytes in the value, or NULL_VALUE_SIZE. */
+    uint64_t uValueSize;
+};
+
+/* A SymTableImage is a mapped image file. */
+struct SymTableImage
+{
+    /* The first byte of the mapping. */
+    const char *pcBase;
+    /* The number of bytes mapped: the size of the file. */
+    size_t uSize;
+    /* The header, at pcBase. */
+    const struct SymTableImageHeader *psHeader;
+    /* The bucket starts, right after the header. */
+    const uint64_t *puBuckets;
+    /* The entries, right after the bucket starts. */
+    const struct SymTableImageEntry *psEntries;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A binding of the table being saved, with its place in the file. */
+struct SymTableImageItem
+{
+    /* The entry to be written for the binding. */
+    struct SymTableImageEntry sEntry;
+    /* The key of the binding. */
+    const char *pcKey;
+    /* The value of the binding. */
+    const void *pvValue;
+};
+
+/* The state of SymTableImage_gather. */
+struct SymTableImageGather
+{
+    /* The items gathered so far. */
+    struct SymTableImageItem *psItems;
+    /* The number of items gathered so far. */
+    size_t uCount;
+    /* The function that sizes values, and its extra argument. */
+    SymTableImage_ValueSize pfValueSize;
+    void *pvExtra;
+};
+
+/* Add the binding of pcKey and pvValue to the items of pvGather, a
+struct SymTableImageGather. Suitable for SymTable_map. */
+static void SymTableImage_gather(const char *pcKey, void *pvValue,
+    void *pvGather)
+{
+    struct SymTableImageGather *psGather =
+        (struct SymTableImageGather*)pvGather;
+    struct SymTableImageItem *psItem;
+    size_t uLength;
+
+    assert(pcKey != NULL);
+    assert(psGather != NULL);
+
+    uLength = strlen(pcKey);
+    psItem = &psGather->psItems[psGather->uCount++];
+    psItem->pcKey = pcKey;
+    psItem->pvValue = pvValue;
+    psItem->sEntry.uHash = (uint64_t)StrHash_word(pcKey, uLength);
+    psItem->sEntry.uKeyLength = (uint64_t)uLength;
+    if (pvValue == NULL)
+        psItem->sEntry.uValueSize = NULL_VALUE_SIZE;
+    else
+        psItem->sEntry.uValueSize = (uint64_t)(*psGather->pfValueSize)
+            (pcKey, pvValue, psGather->pvExtra);
+}
+
+/* Compare the hash codes of the items at pv1 and pv2. Suitable for
+qsort. */
+static int SymTableImage_compareItems(const void *pv1, const void *pv2)
+{
+    uint64_t uHash1 =
+        ((const struct SymTableImageItem*)pv1)->sEntry.uHash;
+    uint64_t uHash2 =
+        ((const struct SymTableImageItem*)pv2)->sEntry.uHash;
+
+    if (uHash1 != uHash2)
+    {
+        return uHash1 < uHash2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Return uOffset rounded up to a multiple of VALUE_ALIGNMENT. */
+static uint64_t SymTableImage_align(uint64_t uOffset)
+{
+    return (uOffset + VALUE_ALIGNMENT - 1) &
+        ~(uint64_t)(VALUE_ALIGNMENT - 1);
+}
+
+/* Write the image of the uCount items at psItems, which are in
+increasing order of hash code and whose offsets are set, to psFile.
+Return 1 (TRUE) if successful, or 0 (FALSE) if a write failed. */
+static int SymTableImage_write(FILE *psFile,
+    const struct SymTableImageItem *psItems, size_t uCount,
+    uint64_t uBucketCount)
+{
+    static const char acPadding[VALUE_ALIGNMENT];
+    struct SymTableImageHeader sHeader;
+    uint64_t uBucketStart = 0;
+    uint64_t uOffset;
+    uint64_t uBucket;
+    size_t i;
+
+    assert(psFile != NULL);
+
+    memset(&sHeader, 0, sizeof(sHeader));
+    memcpy(sHeader.acMagic, acMagic, sizeof(acMagic));
+    sHeader.uByteOrder = BYTE_ORDER_MARK;
+    sHeader.uWordSize = (uint64_t)sizeof(size_t);
+    sHeader.uLength = (uint64_t)uCount;
+    sHeader.uBucketCount = uBucketCount;
+    if (fwrite(&sHeader, sizeof(sHeader), 1, psFile) != 1)
+    {
+        return 0;
+    }
+
+    /* The items are in order of hash code, and so of bucket. */
+    i = 0;
+    for (uBucket = 0; uBucket <= uBucketCount; uBucket++)
+    {
+        while (i < uCount && StrHash_reduce(
+            (size_t)psItems[i].sEntry.uHash, (size_t)uBucketCount)
+            < uBucket)
+        {
+            i++;
+        }
+        uBucketStart = (uint64_t)i;
+        if (fwrite(&uBucketStart, sizeof(uBucketStart), 1, psFile) != 1)
+        {
+            return 0;
+        }
+    }
+
+    for (i = 0; i < uCount; i++)
+    {
+        if (fwrite(&psItems[i].sEntry,
+            sizeof(struct SymTableImageEntry), 1, psFile) != 1)
+        {
+            return 0;
+        }
+    }
+
+    uOffset = sizeof(sHeader) + (uBucketCount + 1) * sizeof(uint64_t) +
+        uCount * sizeof(struct SymTableImageEntry);
+    for (i = 0; i < uCount; i++)
+    {
+        assert(psItems[i].sEntry.uKeyOffset == uOffset);
+        if (fwrite(psItems[i].pcKey,
+            (size_t)psItems[i].sEntry.uKeyLength + 1, 1, psFile) != 1)
+        {
+            return 0;
+        }
+        uOffset += psItems[i].sEntry.uKeyLength + 1;
+        if (psItems[i].pvValue == NULL)
+        {
+            continue;
+        }
+        if (fwrite(acPadding, 1,
+            (size_t)(psItems[i].sEntry.uValueOffset - uOffset), psFile)
+            != (size_t)(psItems[i].sEntry.uValueOffset - uOffset))
+        {
+            return 0;
+        }
+        uOffset = psItems[i].sEntry.uValueOffset;
+        if (psItems[i].sEntry.uValueSize > 0 &&
+            fwrite(psItems[i].pvValue,
+            (size_t)psItems[i].sEntry.uValueSize, 1, psFile) != 1)
+        {
+            return 0;
+        }
+        uOffset += psItems[i].sEntry.uValueSize;
+    }
+    return 1;
+}
+
+int SymTableImage_save(SymTable_T oSymTable, const char *pcPath,
+    SymTableImage_ValueSize pfValueSize, const void *pvExtra)
+{
+    struct SymTableImageGather sGather;
+    uint64_t uBucketCount;
+    uint64_t uOffset;
+    FILE *psFile;
+    int iSuccessful;
+    size_t uLength;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+    assert(pfValueSize != NULL);
+
+    uLength = SymTable_getLength(oSymTable);
+    if (uLength > (size_t)-1 / sizeof(struct SymTableImageItem))
+    {
+        return 0;
+    }
+    /* +1 so that an empty table does not ask malloc for 0 bytes. */
+    sGather.psItems = (struct SymTableImageItem*)
+        malloc((uLength + 1) * sizeof(struct SymTableImageItem));
+    if (sGather.psItems == NULL)
+    {
+        return 0;
+    }
+    sGather.uCount = 0;
+    sGather.pfValueSize = pfValueSize;
+    sGather.pvExtra = (void*)pvExtra;
+    SymTable_map(oSymTable, SymTableImage_gather, &sGather);
+    assert(sGather.uCount == uLength);
+    qsort(sGather.psItems, uLength, sizeof(struct SymTableImageItem),
+        SymTableImage_compareItems);
+
+    /* One bucket per binding, so that a lookup reads about one entry;
+    an empty image still has one bucket to look in. */
+    uBucketCount = uLength > 0 ? (uint64_t)uLength : 1;
+    uOffset = sizeof(struct SymTableImageHeader) +
+        (uBucketCount + 1) * sizeof(uint64_t) +
+        (uint64_t)uLength * sizeof(struct SymTableImageEntry);
+    for (i = 0; i < uLength; i++)
+    {
+        sGather.psItems[i].sEntry.uKeyOffset = uOffset;
+        uOffset += sGather.psItems[i].sEntry.uKeyLength + 1;
+        if (sGather.psItems[i].pvValue == NULL)
+        {
+            sGather.psItems[i].sEntry.uValueOffset = 0;
+            continue;
+        }
+        uOffset = SymTableImage_align(uOffset);
+        sGather.psItems[i].sEntry.uValueOffset = uOffset;
+        uOffset += sGather.psItems[i].sEntry.uValueSize;
+    }
+
+    psFile = fopen(pcPath, "wb");
+    if (psFile == NULL)
+    {
+        free(sGather.psItems);
+        return 0;
+    }
+    iSuccessful = SymTableImage_write(psFile, sGather.psItems, uLength,
+        uBucketCount);
+    if (fclose(psFile) != 0)
+    {
+        iSuccessful = 0;
+    }
+    free(sGather.psItems);
+    if (!iSuccessful)
+    {
+        /* Leave no partial image behind to be mistaken for a whole
+        one. */
+        remove(pcPath);
+    }
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the image of uSize bytes at pcBase has a header
+this machine can read and room for the bucket starts and entries that
+the header describes, or 0 (FALSE) otherwise. */
+static int SymTableImage_checkHeader(const char *pcBase, size_t uSize)
+{
+    const struct SymTableImageHeader *psHeader =
+        (const struct SymTableImageHeader*)(const void*)pcBase;
+    uint64_t uRoom;
+
+    assert(pcBase != NULL);
+
+    if (uSize < sizeof(struct SymTableImageHeader))
+    {
+        return 0;
+    }
+    if (memcmp(psHeader->acMagic, acMagic, sizeof(acMagic)) != 0 ||
+        psHeader->uByteOrder != BYTE_ORDER_MARK ||
+        psHeader->uWordSize != (uint64_t)sizeof(size_t) ||
+        psHeader->uBucketCount == 0)
+    {
+        return 0;
+    }
+    /* Check the sizes one at a time so that no sum overflows. */
+    uRoom = (uint64_t)(uSize - sizeof(struct SymTableImageHeader));
+    if (psHeader->uBucketCount >= uRoom / sizeof(uint64_t))
+    {
+        return 0;
+    }
+    uRoom -= (psHeader->uBucketCount + 1) * sizeof(uint64_t);
+    return psHeader->uLength <=
+        uRoom / sizeof(struct SymTableImageEntry);
+}
+
+/* Return 1 (TRUE) if the key and value of psEntry lie within
+oSymTableImage and the key is null-terminated, or 0 (FALSE)
+otherwise. Entries are checked as they are read, not when the image
+is opened, so that opening does not touch every page. */
+static int SymTableImage_checkEntry(SymTableImage_T oSymTableImage,
+    const struct SymTableImageEntry *psEntry)
+{
+    uint64_t uSize;
+
+    assert(oSymTableImage != NULL);
+    assert(psEntry != NULL);
+
+    uSize = (uint64_t)oSymTableImage->uSize;
+    if (psEntry->uKeyOffset >= uSize ||
+        psEntry->uKeyLength >= uSize - psEntry->uKeyOffset ||
+        oSymTableImage->pcBase[psEntry->uKeyOffset +
+            psEntry->uKeyLength] != '\0')
+    {
+        return 0;
+    }
+    if (psEntry->uValueSize == NULL_VALUE_SIZE)
+    {
+        return 1;
+    }
+    return psEntry->uValueOffset % VALUE_ALIGNMENT == 0 &&
+        psEntry->uValueOffset <= uSize &&
+        psEntry->uValueSize <= uSize - psEntry->uValueOffset;
+}
+
+/* Return the entry of oSymTableImage whose key is pcKey, or NULL if
+there is none. */
+static const struct SymTableImageEntry *SymTableImage_find(
+    SymTableImage_T oSymTableImage, const char *pcKey)
+{
+    const struct SymTableImageEntry *psEntry;
+    uint64_t uHash;
+    uint64_t uBucket;
+    uint64_t uEnd;
+    uint64_t i;
+    size_t uLength;
+
+    assert(oSymTableImage != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = (uint64_t)StrHash_word(pcKey, uLength);
+    uBucket = (uint64_t)StrHash_reduce((size_t)uHash,
+        (size_t)oSymTableImage->psHeader->uBucketCount);
+    uEnd = oSymTableImage->puBuckets[uBucket + 1];
+    if (uEnd > oSymTableImage->psHeader->uLength)
+    {
+        return NULL;
+    }
+    for (i = oSymTableImage->puBuckets[uBucket]; i < uEnd; i++)
+    {
+        psEntry = &oSymTableImage->psEntries[i];
+        if (psEntry->uHash == uHash &&
+            psEntry->uKeyLength == (uint64_t)uLength &&
+            SymTableImage_checkEntry(oSymTableImage, psEntry) &&
+            memcmp(oSymTableImage->pcBase + psEntry->uKeyOffset, pcKey,
+                uLength) == 0)
+        {
+            return psEntry;
+        }
+    }
+    return NULL;
+}
+
+/* Return the value of psEntry, an entry of oSymTableImage, and set
+*puSize, if puSize is not NULL, to its size. */
+static const void *SymTableImage_value(SymTableImage_T oSymTableImage,
+    const struct SymTableImageEntry *psEntry, size_t *puSize)
+{
+    assert(oSymTableImage != NULL);
+    assert(psEntry != NULL);
+
+    if (psEntry->uValueSize == NULL_VALUE_SIZE)
+    {
+        if (puSize != NULL)
+            *puSize = 0;
+        return NULL;
+    }
+    if (puSize != NULL)
+        *puSize = (size_t)psEntry->uValueSize;
+    return oSymTableImage->pcBase + psEntry->uValueOffset;
+}
+
+SymTableImage_T SymTableImage_open(const char *pcPath)
+{
+    SymTableImage_T oSymTableImage;
+    struct stat sStat;
+    void *pvBase;
+    int iFd;
+
+    assert(pcPath != NULL);
+
+    iFd = open(pcPath, O_RDONLY);
+    if (iFd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(iFd, &sStat) != 0 || sStat.st_size <= 0 ||
+        (uintmax_t)sStat.st_size > (uintmax_t)(size_t)-1)
+    {
+        close(iFd);
+        return NULL;
+    }
+    pvBase = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_SHARED,
+        iFd, 0);
+    /* The mapping keeps the file open. */
+    close(iFd);
+    if (pvBase == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (!SymTableImage_checkHeader((const char*)pvBase,
+        (size_t)sStat.st_size))
+    {
+        munmap(pvBase, (size_t)sStat.st_size);
+        return NULL;
+    }
+    oSymTableImage = (SymTableImage_T)
+        malloc(sizeof(struct SymTableImage));
+    if (oSymTableImage == NULL)
+    {
+        munmap(pvBase, (size_t)sStat.st_size);
+        return NULL;
+    }
+    oSymTableImage->pcBase = (const char*)pvBase;
+    oSymTableImage->uSize = (size_t)sStat.st_size;
+    oSymTableImage->psHeader =
+        (const struct SymTableImageHeader*)pvBase;
+    oSymTableImage->puBuckets = (const uint64_t*)(const void*)
+        (oSymTableImage->psHeader + 1);
+    oSymTableImage->psEntries = (const struct SymTableImageEntry*)
+        (const void*)(oSymTableImage->puBuckets +
+            oSymTableImage->psHeader->uBucketCount + 1);
+    return oSymTableImage;
+}
+
+void SymTableImage_close(SymTableImage_T oSymTableImage)
+{
+    assert(oSymTableImage != NULL);
+
+    munmap((void*)oSymTableImage->pcBase, oSymTableImage->uSize);
+    free(oSymTableImage);
+}
+
+size_t SymTableImage_getLength(SymTableImage_T oSymTableImage)
+{
+    assert(oSymTableImage != NULL);
+
+    return (size_t)oSymTableImage->psHeader->uLength;
+}
+
+int SymTableImage_contains(SymTableImage_T oSymTableImage,
+    const char *pcKey)
+{
+    return SymTableImage_find(oSymTableImage, pcKey) != NULL;
+}
+
+const void *SymTableImage_get(SymTableImage_T oSymTableImage,
+    const char *pcKey, size_t *puSize)
+{
+    const struct SymTableImageEntry *psEntry;
+
+    psEntry = SymTableImage_find(oSymTableImage, pcKey);
+    if (psEntry == NULL)
+    {
+        return NULL;
+    }
+    return SymTableImage_value(oSymTableImage, psEntry, puSize);
+}
+
+void SymTableImage_map(SymTableImage_T oSymTableImage,
+    void (*pfApply)(const char *pcKey, const void *pvValue,
+        size_t uSize, void *pvExtra),
+    const void *pvExtra)
+{
+    const struct SymTableImageEntry *psEntry;
+    const void *pvValue;
+    uint64_t i;
+    size_t uSize;
+
+    assert(oSymTableImage != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTableImage->psHeader->uLength; i++)
+    {
+        psEntry = &oSymTableImage->psEntries[i];
+        /* A damaged entry is skipped, as a lookup would skip it. */
+        if (!SymTableImage_checkEntry(oSymTableImage, psEntry))
+        {
+            continue;
+        }
+        pvValue = SymTableImage_value(oSymTableImage, psEntry, &uSize);
+        (*pfApply) (oSymTableImage->pcBase + psEntry->uKeyOffset,
+            pvValue, uSize, (void*)pvExtra);
+    }
+}
@@ -0,0 +1,72 @@
+/*--------------------------------------------------------------------*/
+/* symtableimage.h                                                    */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLEIMAGE_H
+#define SYMTABLEIMAGE_H
+#include <stddef.h>
+#include "symtable.h"
+
+/* A SymTableImage_T is a read-only symbol table served straight from
+a file that SymTableImage_save wrote. The file is mapped into memory,
+not read, so opening it takes time independent of its size, and
+processes that open the same file share its pages. The file holds
+offsets rather than pointers and may be opened at any address, but
+only on a machine with the byte order and word size of the one that
+wrote it. */
+typedef struct SymTableImage *SymTableImage_T;
+
+/* A SymTableImage_ValueSize returns the number of bytes at pvValue,
+the value of the binding with key pcKey, that SymTableImage_save is to
+write. */
+typedef size_t (*SymTableImage_ValueSize)(const char *pcKey,
+    const void *pvValue, void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Write an image of oSymTable to the file named pcPath, replacing any
+file of that name. The value of each binding is written as the
+(*pfValueSize)(pcKey, pvValue, pvExtra) bytes at pvValue; NULL values
+are written as NULL and pfValueSize is not called for them. Return 1
+(TRUE) if successful, or 0 (FALSE) if the file could not be written or
+insufficient memory is available. */
+int SymTableImage_save(SymTable_T oSymTable, const char *pcPath,
+    SymTableImage_ValueSize pfValueSize, const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a SymTableImage_T that serves the image in the file named
+pcPath, or NULL if the file cannot be mapped or does not hold an image
+that this machine can read. */
+SymTableImage_T SymTableImage_open(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* Unmap oSymTableImage and free it. Values it returned become
+invalid. */
+void SymTableImage_close(SymTableImage_T oSymTableImage);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings in oSymTableImage. */
+size_t SymTableImage_getLength(SymTableImage_T oSymTableImage);
+
+/*--------------------------------------------------------------------*/
+
+/* The functions below behave like the SymTable functions of the same
+names. Values point into the mapped file, aligned for any type, and
+must not be written to. If pcKey is bound, *puSize, if puSize is not
+NULL, is set to the number of bytes in its value. */
+
+int SymTableImage_contains(SymTableImage_T oSymTableImage,
+    const char *pcKey);
+
+const void *SymTableImage_get(SymTableImage_T oSymTableImage,
+    const char *pcKey, size_t *puSize);
+
+void SymTableImage_map(SymTableImage_T oSymTableImage,
+    void (*pfApply)(const char *pcKey, const void *pvValue,
+        size_t uSize, void *pvExtra),
+    const void *pvExtra);
+
+#endif
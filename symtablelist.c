@@ -2,24 +2,56 @@
 /* symtablelist.c                                                     */
 /* Author: Ryan Donoghue                                              */
 /*--------------------------------------------------------------------*/
+#include <stddef.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include "symtable.h"
+#include "arena.h"
+#include "parallel.h"
+#include "symtabletrace.h"
 
 /* Each binding is stored in a SymTableNode. SymTableNodes are linked
-to form a list. */
+to form a list. The key is stored inline at the end of the node, so
+each binding is a single allocation. */
 struct SymTableNode 
 {
-    /* The Key of the binding. */
-    char *pcKey;
     /* The value of the binding. */
     const void *pvValue;
     /* The address of the next SymTableNode. */
     struct SymTableNode *psNextNode;
-    
+    /* The number of characters in the key, not counting the null
+    terminator. */
+    size_t uKeyLength;
+    /* The Key of the binding. */
+    char acKey[];
 }; 
 
+/* SymTable_mapParallel splits the list into segments of at least
+this many bindings. */
+static const size_t MAP_MIN_SEGMENT_LENGTH = 1024;
+
+/* Number of segments SymTable_mapParallel aims to give each worker,
+so that a worker that finishes early has segments to steal. */
+static const size_t MAP_SEGMENTS_PER_WORKER = 8;
+
+#ifdef SYMTABLE_STATS
+/* Counts of the operations done on a SymTable, as reported by
+SymTable_getStats. */
+struct SymTableCounters
+{
+    /* Calls that tried to put a binding. */
+    size_t uPuts;
+    /* Lookups by get, contains, and replace, and how many found their
+    key. */
+    size_t uGets;
+    size_t uHits;
+    /* Key searches of any kind, and nodes they examined. */
+    size_t uSearches;
+    size_t uProbes;
+};
+#endif
+
 /* A SymTable is a "dummy" node that points to the first 
 SymTableNode. */
 struct SymTable 
@@ -29,8 +61,252 @@ struct SymTable
     struct SymTableNode *psFirstNode;
     /* Number of bindings in the the Symbol Table. */
     size_t uLength;
+    /* The arena that nodes are carved from, or NULL if each node is
+    allocated with malloc. */
+    Arena_T oArena;
+    /* How lookups reorder the list. */
+    enum SymTableOrder eOrder;
+    /* The iterators walking the table, linked through their
+    oNextIter fields, or NULL if there are none. */
+    SymTableIter_T oFirstIter;
+#ifdef SYMTABLE_STATS
+    /* Operation counts for SymTable_getStats. */
+    struct SymTableCounters sCounters;
+#endif
+#ifdef SYMTABLE_TRACE
+    /* The operation being traced. */
+    struct SymTableTrace sTrace;
+#endif
 }; 
 
+/* A SymTableIter walks the bindings of its table in list order. The
+table tells its iterators about every binding it unlinks and does not
+reorder the list while any are open, so each step just follows one
+link. */
+struct SymTableIter
+{
+    /* The table being walked. */
+    SymTable_T oSymTable;
+    /* The last binding returned that is still in the table, or NULL
+    if the walk continues at the front of the list. */
+    struct SymTableNode *psLastNode;
+    /* The next iterator walking the same table. */
+    SymTableIter_T oNextIter;
+};
+
+/* Add uAmount to the counter uField of oSymTable if operations are
+being counted, and otherwise do nothing at all. */
+#ifdef SYMTABLE_STATS
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) \
+    ((oSymTable)->sCounters.uField += (size_t)(uAmount))
+#else
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) ((void)0)
+#endif
+
+/* Return the number of bytes occupied by a node whose key is
+uKeyLength characters long. */
+static size_t SymTable_nodeSize(size_t uKeyLength)
+{
+    /* +1 at the end marks the null terminator character. */
+    return offsetof(struct SymTableNode, acKey) + uKeyLength + 1;
+}
+
+/* Return a new node of oSymTable with room for a key of uKeyLength
+characters, or NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->oArena != NULL)
+    {
+        return (struct SymTableNode*)Arena_alloc(oSymTable->oArena,
+            SymTable_nodeSize(uKeyLength));
+    }
+    return (struct SymTableNode*)malloc(SymTable_nodeSize(uKeyLength));
+}
+
+/* Return 1 (TRUE) if the key of psNode is the uLength characters at
+pcKey, or 0 (FALSE) otherwise. Lengths are compared first, so most
+mismatches never touch the key bytes. */
+static int SymTable_keyEquals(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uLength)
+{
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    return psNode->uKeyLength == uLength &&
+        memcmp(psNode->acKey, pcKey, uLength) == 0;
+}
+
+/* Move the binding that *ppsLink points to forward in the chain that
+begins at *ppsHead, in which *ppsPrevLink points to the binding before
+it (ppsPrevLink is NULL if it is first), as eOrder says. Return the
+address of the link that then points to it. */
+static struct SymTableNode **SymTable_promote(
+    enum SymTableOrder eOrder, struct SymTableNode **ppsHead,
+    struct SymTableNode **ppsPrevLink, struct SymTableNode **ppsLink)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psPrevNode;
+
+    assert(ppsHead != NULL);
+    assert(ppsLink != NULL);
+
+    if (ppsPrevLink == NULL || eOrder == SYMTABLE_ORDER_FIXED)
+    {
+        return ppsLink;
+    }
+    psNode = *ppsLink;
+    if (eOrder == SYMTABLE_ORDER_MOVE_TO_FRONT)
+    {
+        *ppsLink = psNode->psNextNode;
+        psNode->psNextNode = *ppsHead;
+        *ppsHead = psNode;
+        return ppsHead;
+    }
+    /* Transpose: *ppsLink is the psNextNode field of the binding
+    before. */
+    psPrevNode = *ppsPrevLink;
+    psPrevNode->psNextNode = psNode->psNextNode;
+    psNode->psNextNode = psPrevNode;
+    *ppsPrevLink = psNode;
+    return ppsPrevLink;
+}
+
+/* Return the address of the link (psFirstNode or a psNextNode field)
+in oSymTable that points to the binding whose key is the uLength
+characters at pcKey, or NULL if no such binding exists. If iPromote is
+1 (TRUE), first move the binding forward as the order of oSymTable
+says. */
+static struct SymTableNode **SymTable_findLink(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, int iPromote)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode **ppsPrevLink = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
+    for (ppsLink = &oSymTable->psFirstNode;
+        *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNextNode)
+    {
+        SYMTABLE_COUNT(oSymTable, uProbes, 1);
+        SYMTABLE_TRACE_PROBES(oSymTable, 1);
+        if (SymTable_keyEquals(*ppsLink, pcKey, uLength))
+        {
+            /* Reordering under an open iterator could make it skip
+            or repeat bindings. */
+            if (iPromote && oSymTable->oFirstIter == NULL)
+            {
+                return SymTable_promote(oSymTable->eOrder,
+                    &oSymTable->psFirstNode, ppsPrevLink, ppsLink);
+            }
+            return ppsLink;
+        }
+        ppsPrevLink = ppsLink;
+    }
+    return NULL;
+}
+
+/* Unlink from oSymTable the binding that *ppsLink points to. An
+iterator whose last binding it was moves back to the binding before
+it, so that its walk continues with the binding after. */
+static void SymTable_unlink(SymTable_T oSymTable,
+    struct SymTableNode **ppsLink)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psPrevNode = NULL;
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+    assert(ppsLink != NULL);
+    assert(*ppsLink != NULL);
+
+    psNode = *ppsLink;
+    *ppsLink = psNode->psNextNode;
+
+    if (oSymTable->oFirstIter == NULL)
+    {
+        return;
+    }
+    /* Unless it is psFirstNode, the link is the psNextNode field of
+    the binding before. */
+    if (ppsLink != &oSymTable->psFirstNode)
+    {
+        psPrevNode = (struct SymTableNode*)(void*)((char*)ppsLink -
+            offsetof(struct SymTableNode, psNextNode));
+    }
+    for (oIter = oSymTable->oFirstIter; oIter != NULL;
+        oIter = oIter->oNextIter)
+    {
+        if (oIter->psLastNode == psNode)
+        {
+            oIter->psLastNode = psPrevNode;
+        }
+    }
+}
+
+/* Free psNode, which belongs to oSymTable. */
+static void SymTable_freeNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode)
+{
+    assert(oSymTable != NULL);
+    assert(psNode != NULL);
+
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_release(oSymTable->oArena, psNode,
+            SymTable_nodeSize(psNode->uKeyLength));
+        return;
+    }
+    free(psNode);
+}
+
+/* Remove from the chain that begins at *ppsHead every binding of
+oSymTable for which (*pfPredicate)(pcKey, pvValue, pvExtra) returns
+nonzero, passing each to *pfRemoved, if pfRemoved is not NULL, before
+freeing it. Return the number of bindings removed. */
+static size_t SymTable_removeFromChain(SymTable_T oSymTable,
+    struct SymTableNode **ppsHead,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    size_t uRemoved = 0;
+
+    assert(oSymTable != NULL);
+    assert(ppsHead != NULL);
+    assert(pfPredicate != NULL);
+
+    ppsLink = ppsHead;
+    while (*ppsLink != NULL)
+    {
+        psNode = *ppsLink;
+        if (!(*pfPredicate)(psNode->acKey, (void*)psNode->pvValue,
+            (void*)pvExtra))
+        {
+            ppsLink = &psNode->psNextNode;
+            continue;
+        }
+        SymTable_unlink(oSymTable, ppsLink);
+        if (pfRemoved != NULL)
+        {
+            (*pfRemoved)(psNode->acKey, (void*)psNode->pvValue,
+                (void*)pvExtra);
+        }
+        SymTable_freeNode(oSymTable, psNode);
+        oSymTable->uLength--;
+        uRemoved++;
+    }
+    return uRemoved;
+}
+
 SymTable_T SymTable_new(void)
 {
     SymTable_T oSymTable;
@@ -41,9 +317,51 @@ SymTable_T SymTable_new(void)
     }
     oSymTable->psFirstNode = NULL;
     oSymTable->uLength = 0;
+    oSymTable->oArena = NULL;
+    oSymTable->eOrder = SYMTABLE_ORDER_FIXED;
+    oSymTable->oFirstIter = NULL;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+#endif
+#ifdef SYMTABLE_TRACE
+    memset(&oSymTable->sTrace, 0, sizeof(oSymTable->sTrace));
+#endif
     return oSymTable;
 }
 
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    /* A list has no buckets to size. */
+    (void)uCapacity;
+
+    return SymTable_new();
+}
+
+SymTable_T SymTable_newArena(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) {
+        return NULL;
+    }
+    oSymTable->oArena = Arena_new();
+    if (oSymTable->oArena == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash)
+{
+    /* A list finds bindings by comparing keys, not by hashing. */
+    assert(pfHash != NULL);
+    (void)pfHash;
+
+    return SymTable_new();
+}
+
 void SymTable_free(SymTable_T oSymTable) 
 {
     struct SymTableNode *psCurrentNode;
@@ -51,170 +369,445 @@ void SymTable_free(SymTable_T oSymTable)
 
     assert(oSymTable != NULL); 
 
+    SYMTABLE_TRACE_FREE(oSymTable);
+    /* Arena nodes are released together with their slabs. */
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_free(oSymTable->oArena);
+        free(oSymTable);
+        return;
+    }
+
     for (psCurrentNode = oSymTable->psFirstNode;
         psCurrentNode != NULL;
         psCurrentNode = psNextNode)
     {
         psNextNode = psCurrentNode->psNextNode;
-        free(psCurrentNode->pcKey);
         free(psCurrentNode);
     }
     free(oSymTable);
 }
 
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+    /* A list never hashes, so any hash code will do. */
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)oSymTable;
+    (void)pcKey;
+
+    return 0;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+    (void)uCapacity;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RESERVE, NULL);
+    return 1;
+}
+
 size_t SymTable_getLength(SymTable_T oSymTable) {
     return oSymTable->uLength; 
 }
 
-int SymTable_put(SymTable_T oSymTable, 
-    const char *pcKey, const void *pvValue) 
+/* Return the node of the binding in oSymTable whose key is the
+uLength characters at pcKey, first putting a binding of that key and
+pvValue if there is none. Set *piAdded to 1 (TRUE) if a binding was
+put, or 0 (FALSE) otherwise. Return NULL if insufficient memory is
+available. */
+static struct SymTableNode *SymTable_findOrAdd(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue,
+    int *piAdded)
 {
-struct SymTableNode *psNewNode; 
-struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNewNode;
 
-assert(oSymTable != NULL); 
-assert(pcKey != NULL);
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piAdded != NULL);
 
-for (psCurrentNode = oSymTable->psFirstNode;
-     psCurrentNode != NULL; 
-     psCurrentNode = psCurrentNode->psNextNode)
-{
-    if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+    SYMTABLE_COUNT(oSymTable, uPuts, 1);
+    *piAdded = 0;
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, 0);
+    if (ppsLink != NULL)
     {
-        return 0;
+        return *ppsLink;
+    }
+
+    psNewNode = SymTable_allocNode(oSymTable, uLength);
+    if (psNewNode == NULL)
+    {
+        return NULL;
     }
+    memcpy(psNewNode->acKey, pcKey, uLength);
+    psNewNode->acKey[uLength] = '\0';
+    psNewNode->uKeyLength = uLength;
+
+    psNewNode->pvValue = pvValue;
+    psNewNode->psNextNode = oSymTable->psFirstNode;
+    oSymTable->psFirstNode = psNewNode;
+    oSymTable->uLength++;
+    *piAdded = 1;
+    return psNewNode;
 }
 
-psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode)); 
-if (psNewNode == NULL) 
+/* Do the work of SymTable_putLen, which traces it. */
+static int SymTable_putUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
 {
-    return 0;
+    int iAdded;
+
+    return SymTable_findOrAdd(oSymTable, pcKey, uLength, pvValue,
+        &iAdded) != NULL && iAdded;
 }
-/* +1 at the end marks the null terminator character. */
-psNewNode->pcKey = (char*)malloc(strlen(pcKey) + 1); 
-if (psNewNode->pcKey == NULL)
+
+int SymTable_putLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
 {
-    free(psNewNode);
-    return 0; 
-}
-strcpy(psNewNode->pcKey, pcKey); 
+    int iSuccessful;
 
-psNewNode->pvValue = pvValue; 
-psNewNode->psNextNode = oSymTable->psFirstNode; 
-oSymTable->psFirstNode = psNewNode; 
-oSymTable->uLength++; 
-return 1; 
+    assert(oSymTable != NULL);
 
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, uLength,
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
 }
 
-void *SymTable_replace(SymTable_T oSymTable,
+int SymTable_put(SymTable_T oSymTable, 
     const char *pcKey, const void *pvValue) 
 {
-    struct SymTableNode *psCurrentNode;
-    const void *pvValueOld; 
+    int iSuccessful;
 
-    assert(oSymTable != NULL); 
+    assert(oSymTable != NULL);
     assert(pcKey != NULL);
-    
 
-    for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, strlen(pcKey),
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, strlen(pcKey),
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+size_t SymTable_putMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues,
+    size_t uCount)
+{
+    size_t uAdded = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* A list never expands, so there is nothing to size first. */
+    for (i = 0; i < uCount; i++)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
+        assert(ppcKeys[i] != NULL);
+        if (SymTable_putUntraced(oSymTable, ppcKeys[i],
+            strlen(ppcKeys[i]), ppvValues[i]))
         {
-            pvValueOld = psCurrentNode->pvValue;
-            psCurrentNode->pvValue = pvValue;
-            return (void*)pvValueOld; 
+            uAdded++;
         }
     }
-    return NULL; 
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT_MANY, NULL);
+    return uAdded;
+}
+
+/* Do the work of SymTable_replaceLen, which traces it. */
+static void *SymTable_replaceUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue) 
+{
+    struct SymTableNode **ppsLink;
+    const void *pvValueOld; 
+
+    assert(oSymTable != NULL); 
+    assert(pcKey != NULL);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, 1);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, ppsLink != NULL);
+    if (ppsLink == NULL)
+    {
+        return NULL;
+    }
+    pvValueOld = (*ppsLink)->pvValue;
+    (*ppsLink)->pvValue = pvValue;
+    return (void*)pvValueOld; 
 
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+void *SymTable_replaceLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
 {
-    struct SymTableNode *psCurrentNode;
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey, uLength,
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) 
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey,
+        strlen(pcKey), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replaceHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey,
+        strlen(pcKey), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+/* Do the work of SymTable_containsLen, which traces it. */
+static int SymTable_containsUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) 
+{
+    int iFound;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL) ; 
 
-    for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
-        {
-            return 1;
-        }
-    }
-    return 0; 
+    iFound = SymTable_findLink(oSymTable, pcKey, uLength, 1) != NULL;
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, iFound);
+    return iFound; 
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+int SymTable_containsLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
 {
-    struct SymTableNode *psCurrentNode;
-    const void *pvTargetValue; 
+    int iFound;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+/* Do the work of SymTable_getLen, which traces it. */
+static void *SymTable_getUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableNode **ppsLink;
     
     assert(oSymTable != NULL); 
     assert(pcKey != NULL); 
 
-    for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, 1);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, ppsLink != NULL);
+    if (ppsLink == NULL)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) 
-        {
-            pvTargetValue = psCurrentNode->pvValue;
-            return (void*)pvTargetValue; 
-        }
+        return NULL;
     }
-    return NULL; 
+    return (void*)(*ppsLink)->pvValue; 
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) 
+void *SymTable_getLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
 {
-    struct SymTableNode *psCurrentNode;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void SymTable_getMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* A list has no buckets to prefetch, so look the keys up one at
+    a time. */
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        ppvValues[i] = SymTable_getUntraced(oSymTable, ppcKeys[i],
+            strlen(ppcKeys[i]));
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_MANY, NULL);
+}
+
+/* Do the work of SymTable_removeLen, which traces it. */
+static void *SymTable_removeUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) 
+{
+    struct SymTableNode **ppsLink;
     struct SymTableNode *psNodeToRemove;
-    struct SymTableNode *psFirst;
     const void *pvRemovedValue; 
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL); 
 
-    psFirst = oSymTable->psFirstNode;
-    
-    /* Handle if the binding to be removed is first in the 
-    list. */
-    if (psFirst != NULL && 
-        strcmp(psFirst->pcKey, pcKey) == 0) 
-        {
-            pvRemovedValue = psFirst->pvValue;
-            oSymTable->psFirstNode = psFirst->psNextNode;
-            free(psFirst->pcKey);
-            free(psFirst);
-            oSymTable->uLength--; 
-            return (void*)pvRemovedValue; 
-        }
-
-    /* Handle all other cases */
-    for (psCurrentNode = psFirst;
-        psCurrentNode != NULL; 
-        psCurrentNode = psCurrentNode->psNextNode)
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, 0);
+    if (ppsLink == NULL)
     {
-        if (psCurrentNode->psNextNode != NULL && 
-            strcmp(psCurrentNode->psNextNode->pcKey, pcKey) == 0)
-        {
-            psNodeToRemove = psCurrentNode->psNextNode; 
-            pvRemovedValue = psNodeToRemove->pvValue; 
-            psCurrentNode->psNextNode = psNodeToRemove->psNextNode;  
-            free(psNodeToRemove->pcKey);
-            free(psNodeToRemove);
-            oSymTable->uLength--; 
-            return (void*)pvRemovedValue;
-        }
+        return NULL;
     }
-    return NULL; 
+    psNodeToRemove = *ppsLink;
+    pvRemovedValue = psNodeToRemove->pvValue; 
+    SymTable_unlink(oSymTable, ppsLink);
+    SymTable_freeNode(oSymTable, psNodeToRemove);
+    oSymTable->uLength--; 
+    return (void*)pvRemovedValue;
+}
+
+void *SymTable_removeLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) 
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
 }
 
 void SymTable_map(SymTable_T oSymTable,
@@ -226,11 +819,552 @@ void SymTable_map(SymTable_T oSymTable,
         assert(oSymTable != NULL);
         assert(pfApply != NULL);
     
+     SYMTABLE_TRACE_BEGIN(oSymTable);
      for (psCurrentNode = oSymTable->psFirstNode;
           psCurrentNode != NULL; 
           psCurrentNode = psCurrentNode->psNextNode)  
     { 
-        (*pfApply) ((void*)psCurrentNode->pcKey, 
+        (*pfApply) ((void*)psCurrentNode->acKey, 
         (void*)psCurrentNode->pvValue, ((void*)pvExtra)); 
     } 
-}
\ No newline at end of file
+     SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP, NULL);
+}
+
+/* The state of one call of SymTable_mapParallel. Task i covers the
+uSegmentLength bindings starting at segment i. */
+struct SymTableMapRun
+{
+    /* The first node of each segment. */
+    struct SymTableNode **ppsSegments;
+    /* Number of bindings in each segment but the last. */
+    size_t uSegmentLength;
+    /* The function to apply to each binding. */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* The extra parameter of each worker. */
+    void *const *ppvExtras;
+};
+
+/* Apply the function of pvRun, a struct SymTableMapRun, to the
+bindings in segment uTask, passing the extra parameter of worker
+uWorker. */
+static void SymTable_mapTask(void *pvRun, size_t uTask, size_t uWorker)
+{
+    struct SymTableMapRun *psRun = (struct SymTableMapRun*)pvRun;
+    struct SymTableNode *psCurrentNode;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    for (psCurrentNode = psRun->ppsSegments[uTask], i = 0;
+        psCurrentNode != NULL && i < psRun->uSegmentLength;
+        psCurrentNode = psCurrentNode->psNextNode, i++)
+    {
+        (*psRun->pfApply) (psCurrentNode->acKey,
+            (void*)psCurrentNode->pvValue, psRun->ppvExtras[uWorker]);
+    }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *const *ppvExtras, size_t uWorkerCount)
+{
+    struct SymTableMapRun sRun;
+    struct SymTableNode *psCurrentNode;
+    size_t uSegmentCount;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(ppvExtras != NULL);
+    assert(uWorkerCount > 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* A list cannot be indexed, so one serial pass finds where each
+    segment starts. */
+    sRun.uSegmentLength = oSymTable->uLength / uWorkerCount
+        / MAP_SEGMENTS_PER_WORKER;
+    if (sRun.uSegmentLength < MAP_MIN_SEGMENT_LENGTH)
+    {
+        sRun.uSegmentLength = MAP_MIN_SEGMENT_LENGTH;
+    }
+    uSegmentCount = oSymTable->uLength / sRun.uSegmentLength
+        + (oSymTable->uLength % sRun.uSegmentLength != 0);
+
+    sRun.ppsSegments = (struct SymTableNode**)
+        malloc(uSegmentCount * sizeof(struct SymTableNode*));
+    if (sRun.ppsSegments == NULL)
+    {
+        SymTable_map(oSymTable, pfApply, ppvExtras[0]);
+        SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL,
+            NULL);
+        return;
+    }
+    for (psCurrentNode = oSymTable->psFirstNode, i = 0;
+        psCurrentNode != NULL;
+        psCurrentNode = psCurrentNode->psNextNode, i++)
+    {
+        if (i % sRun.uSegmentLength == 0)
+        {
+            sRun.ppsSegments[i / sRun.uSegmentLength] = psCurrentNode;
+        }
+    }
+    sRun.pfApply = pfApply;
+    sRun.ppvExtras = ppvExtras;
+
+    Parallel_run(uSegmentCount, uWorkerCount, SymTable_mapTask, &sRun);
+    free(sRun.ppsSegments);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL, NULL);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    oIter = (SymTableIter_T)malloc(sizeof(struct SymTableIter));
+    if (oIter != NULL)
+    {
+        oIter->oSymTable = oSymTable;
+        oIter->psLastNode = NULL;
+        oIter->oNextIter = oSymTable->oFirstIter;
+        oSymTable->oFirstIter = oIter;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_BEGIN, NULL);
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    struct SymTableNode *psNextNode;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oIter->oSymTable);
+    /* New bindings go to the front of the list, so once the walk has
+    taken a step it does not return bindings put since. */
+    if (oIter->psLastNode == NULL)
+    {
+        psNextNode = oIter->oSymTable->psFirstNode;
+    }
+    else
+    {
+        psNextNode = oIter->psLastNode->psNextNode;
+    }
+    if (psNextNode != NULL)
+    {
+        oIter->psLastNode = psNextNode;
+        *ppcKey = psNextNode->acKey;
+        *ppvValue = (void*)psNextNode->pvValue;
+    }
+    SYMTABLE_TRACE_END(oIter->oSymTable, SYMTABLE_TRACE_ITER_NEXT,
+        NULL);
+    return psNextNode != NULL;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    SymTable_T oSymTable;
+    SymTableIter_T *poLink;
+
+    assert(oIter != NULL);
+
+    oSymTable = oIter->oSymTable;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    for (poLink = &oSymTable->oFirstIter; *poLink != oIter;
+        poLink = &(*poLink)->oNextIter)
+    {
+        assert(*poLink != NULL);
+    }
+    *poLink = oIter->oNextIter;
+    free(oIter);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_END, NULL);
+}
+
+/* The bounds of a SymTable_range or SymTable_prefix query. */
+struct SymTableBounds
+{
+    /* Every selected key is at least the uLowLength characters at
+    pcLow. */
+    const char *pcLow;
+    size_t uLowLength;
+    /* Every selected key is less than the uHighLength characters at
+    pcHigh, or, if pcHigh is NULL, begins with the characters at
+    pcLow. */
+    const char *pcHigh;
+    size_t uHighLength;
+};
+
+/* Return a negative number, 0, or a positive number as the uLength1
+characters at pcKey1 come before, are the same as, or come after the
+uLength2 characters at pcKey2. Keys are compared character by
+character as unsigned chars, and a key comes after its own
+prefixes. */
+static int SymTable_compareKeys(const char *pcKey1, size_t uLength1,
+    const char *pcKey2, size_t uLength2)
+{
+    int iResult;
+
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    iResult = memcmp(pcKey1, pcKey2,
+        uLength1 < uLength2 ? uLength1 : uLength2);
+    if (iResult != 0)
+    {
+        return iResult;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Return 1 (TRUE) if the uLength characters at pcKey are within
+psBounds, or 0 (FALSE) otherwise. */
+static int SymTable_inBounds(const struct SymTableBounds *psBounds,
+    const char *pcKey, size_t uLength)
+{
+    assert(psBounds != NULL);
+    assert(pcKey != NULL);
+
+    if (psBounds->pcHigh == NULL)
+    {
+        return uLength >= psBounds->uLowLength &&
+            memcmp(pcKey, psBounds->pcLow, psBounds->uLowLength) == 0;
+    }
+    return SymTable_compareKeys(pcKey, uLength, psBounds->pcLow,
+            psBounds->uLowLength) >= 0
+        && SymTable_compareKeys(pcKey, uLength, psBounds->pcHigh,
+            psBounds->uHighLength) < 0;
+}
+
+/* Compare the keys of the nodes that pv1 and pv2 point to, as
+SymTable_compareKeys does. Suitable for qsort. */
+static int SymTable_compareNodes(const void *pv1, const void *pv2)
+{
+    const struct SymTableNode *psNode1 =
+        *(struct SymTableNode *const *)pv1;
+    const struct SymTableNode *psNode2 =
+        *(struct SymTableNode *const *)pv2;
+
+    return SymTable_compareKeys(psNode1->acKey, psNode1->uKeyLength,
+        psNode2->acKey, psNode2->uKeyLength);
+}
+
+/* Apply *pfApply, passing pvExtra, to each binding of oSymTable within
+psBounds, in increasing order of key. The list keeps no order, so the
+bindings are gathered and sorted first. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available. */
+static int SymTable_applyRange(SymTable_T oSymTable,
+    const struct SymTableBounds *psBounds,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsSelected;
+    size_t uCount = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psBounds != NULL);
+    assert(pfApply != NULL);
+
+    for (psCurrentNode = oSymTable->psFirstNode;
+        psCurrentNode != NULL;
+        psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_inBounds(psBounds, psCurrentNode->acKey,
+            psCurrentNode->uKeyLength))
+            uCount++;
+    }
+    if (uCount == 0) {
+        return 1;
+    }
+
+    ppsSelected = (struct SymTableNode**)
+        malloc(uCount * sizeof(struct SymTableNode*));
+    if (ppsSelected == NULL) {
+        return 0;
+    }
+    i = 0;
+    for (psCurrentNode = oSymTable->psFirstNode;
+        psCurrentNode != NULL;
+        psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_inBounds(psBounds, psCurrentNode->acKey,
+            psCurrentNode->uKeyLength))
+            ppsSelected[i++] = psCurrentNode;
+    }
+    qsort(ppsSelected, uCount, sizeof(struct SymTableNode*),
+        SymTable_compareNodes);
+
+    for (i = 0; i < uCount; i++)
+    {
+        (*pfApply) (ppsSelected[i]->acKey,
+            (void*)ppsSelected[i]->pvValue, (void*)pvExtra);
+    }
+    free(ppsSelected);
+    return 1;
+}
+
+int SymTable_range(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcLow != NULL);
+    assert(pcHigh != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcLow;
+    sBounds.uLowLength = strlen(pcLow);
+    sBounds.pcHigh = pcHigh;
+    sBounds.uHighLength = strlen(pcHigh);
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RANGE, pcLow);
+    return iSuccessful;
+}
+
+int SymTable_prefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcPrefix;
+    sBounds.uLowLength = strlen(pcPrefix);
+    sBounds.pcHigh = NULL;
+    sBounds.uHighLength = 0;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PREFIX, pcPrefix);
+    return iSuccessful;
+}
+
+/* Return the node of a SymTable whose key is at pcKey, a pointer that
+SymTable_intern returned. Nodes never move, so the address of the key
+is enough. */
+static struct SymTableNode *SymTable_internedNode(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return (struct SymTableNode*)(void*)
+        (pcKey - offsetof(struct SymTableNode, acKey));
+}
+
+const char *SymTable_intern(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), NULL,
+        &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_INTERN, pcKey);
+    if (psNode == NULL) {
+        return NULL;
+    }
+    return psNode->acKey;
+}
+
+void *SymTable_getInterned(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, 1);
+    pvValue = (void*)SymTable_internedNode(pcKey)->pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableNode *psNode;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psNode = SymTable_internedNode(pcKey);
+    pvOldValue = psNode->pvValue;
+    psNode->pvValue = pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return (void*)pvOldValue;
+}
+
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    const char *pcKey)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    const void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* The node still has to be unlinked, so find the link that points
+    to it, comparing addresses rather than keys. */
+    psNode = SymTable_internedNode(pcKey);
+    for (ppsLink = &oSymTable->psFirstNode; *ppsLink != psNode;
+        ppsLink = &(*ppsLink)->psNextNode)
+    {
+        assert(*ppsLink != NULL);
+        SYMTABLE_TRACE_PROBES(oSymTable, 1);
+    }
+    pvRemovedValue = psNode->pvValue;
+    SymTable_unlink(oSymTable, ppsLink);
+    SymTable_freeNode(oSymTable, psNode);
+    oSymTable->uLength--;
+    /* The key went with the node. */
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, NULL);
+    return (void*)pvRemovedValue;
+}
+
+/* Return the number of bytes taken by the keys of oSymTable, null
+terminators included. */
+static size_t SymTable_keyBytes(SymTable_T oSymTable)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t uBytes = 0;
+
+    assert(oSymTable != NULL);
+
+    for (psCurrentNode = oSymTable->psFirstNode;
+        psCurrentNode != NULL;
+        psCurrentNode = psCurrentNode->psNextNode)
+    {
+        uBytes += psCurrentNode->uKeyLength + 1;
+    }
+    return uBytes;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* The list is reported as a single bucket whose chain holds every
+    binding. */
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uLength = oSymTable->uLength;
+    psStats->uBucketCount = 1;
+    psStats->dLoadFactor = (double)oSymTable->uLength;
+    psStats->auChainLengths[oSymTable->uLength < SYMTABLE_HISTOGRAM_SIZE
+        ? oSymTable->uLength : SYMTABLE_HISTOGRAM_SIZE - 1] = 1;
+    psStats->uMaxChainLength = oSymTable->uLength;
+    psStats->uNodeBytes =
+        oSymTable->uLength * offsetof(struct SymTableNode, acKey);
+    psStats->uKeyBytes = SymTable_keyBytes(oSymTable);
+
+#ifdef SYMTABLE_STATS
+    psStats->uPuts = oSymTable->sCounters.uPuts;
+    psStats->uGets = oSymTable->sCounters.uGets;
+    psStats->uHits = oSymTable->sCounters.uHits;
+    psStats->uMisses =
+        oSymTable->sCounters.uGets - oSymTable->sCounters.uHits;
+    if (oSymTable->sCounters.uSearches > 0)
+    {
+        psStats->dProbesPerLookup =
+            (double)oSymTable->sCounters.uProbes /
+            (double)oSymTable->sCounters.uSearches;
+    }
+#endif
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_STATS, NULL);
+}
+
+void SymTable_setOrder(SymTable_T oSymTable,
+    enum SymTableOrder eOrder)
+{
+    assert(oSymTable != NULL);
+
+    oSymTable->eOrder = eOrder;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue)
+{
+    struct SymTableNode *psNode;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey),
+        pvValue, &iAdded);
+    if (psNode != NULL)
+    {
+        if (ppvOldValue != NULL)
+        {
+            *ppvOldValue = iAdded ? NULL : (void*)psNode->pvValue;
+        }
+        psNode->pvValue = pvValue;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_UPSERT, pcKey);
+    return psNode != NULL;
+}
+
+void **SymTable_getOrInsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue)
+{
+    struct SymTableNode *psNode;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psNode = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey),
+        pvValue, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_OR_INSERT,
+        pcKey);
+    return psNode == NULL ? NULL : (void**)&psNode->pvValue;
+}
+
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t uRemoved;
+
+    assert(oSymTable != NULL);
+    assert(pfPredicate != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uRemoved = SymTable_removeFromChain(oSymTable,
+        &oSymTable->psFirstNode, pfPredicate, pfRemoved, pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE_IF, NULL);
+    return uRemoved;
+}
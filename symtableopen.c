@@ -0,0 +1,1852 @@
+/*--------------------------------------------------------------------*/
+/* symtableopen.c                                                     */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "symtable.h"
+#include "arena.h"
+#include "strhash.h"
+#include "parallel.h"
+#include "symtabletrace.h"
+
+/* Number of slots in a new SymTable. Must be a power of two. */
+static const size_t INITIAL_SLOT_COUNT = 16;
+
+/* The table expands once it would become more than
+MAX_LOAD_NUMERATOR/MAX_LOAD_DENOMINATOR full. */
+static const size_t MAX_LOAD_NUMERATOR = 7;
+static const size_t MAX_LOAD_DENOMINATOR = 8;
+
+/* A table with more than INITIAL_SLOT_COUNT slots shrinks once it has
+more than SHRINK_LOAD_DENOMINATOR slots per binding. It shrinks to
+room for twice its bindings, so a table must double or halve again
+before it resizes again. */
+static const size_t SHRINK_LOAD_DENOMINATOR = 8;
+
+/* Each binding is stored in a SymTableSlot. All slots live in one
+contiguous array, so a lookup usually touches a single cache line
+before it has to look at any key bytes. */
+struct SymTableSlot
+{
+    /* The full hash code of pcKey. Only meaningful when pcKey is not
+    NULL. */
+    size_t uHash;
+    /* The key of the binding, or NULL if the slot is empty. */
+    char *pcKey;
+    /* The number of characters in pcKey, not counting the null
+    terminator. */
+    size_t uKeyLength;
+    /* The value of the binding. */
+    const void *pvValue;
+};
+
+#ifdef SYMTABLE_STATS
+/* Counts of the operations done on a SymTable, as reported by
+SymTable_getStats. */
+struct SymTableCounters
+{
+    /* Calls that tried to put a binding. */
+    size_t uPuts;
+    /* Lookups by get, contains, and replace, and how many found their
+    key. */
+    size_t uGets;
+    size_t uHits;
+    /* Key searches of any kind, and slots they examined. */
+    size_t uSearches;
+    size_t uProbes;
+    /* Resizes that added slots. */
+    size_t uExpansions;
+};
+#endif
+
+/* A SymTable in the open addressing implementation is a power of two
+sized array of SymTableSlots, managed with Robin Hood hashing: a
+binding that is further from its home slot may displace one that is
+closer to its own, which keeps probe sequences short and lets a
+failed lookup stop early. */
+struct SymTable
+{
+    /* Pointer to the array of slots. */
+    struct SymTableSlot *psSlots;
+    /* Current number of slots. Always a power of two. */
+    size_t uSlotCount;
+    /* Number of bits to shift a scrambled hash code right to get a
+    home slot index. */
+    size_t uShift;
+    /* Number of bindings in the symbol table. */
+    size_t uLength;
+    /* The arena that keys are carved from, or NULL if each key is
+    allocated with malloc. */
+    Arena_T oArena;
+    /* The function that computes the full hash code of a key. */
+    SymTable_HashFunction pfHash;
+#ifdef SYMTABLE_STATS
+    /* Operation counts for SymTable_getStats. */
+    struct SymTableCounters sCounters;
+#endif
+#ifdef SYMTABLE_TRACE
+    /* The operation being traced. */
+    struct SymTableTrace sTrace;
+#endif
+};
+
+/* Add uAmount to the counter uField of oSymTable if operations are
+being counted, and otherwise do nothing at all. */
+#ifdef SYMTABLE_STATS
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) \
+    ((oSymTable)->sCounters.uField += (size_t)(uAmount))
+#else
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) ((void)0)
+#endif
+
+/* Number of slots each task of SymTable_mapParallel visits. */
+static const size_t MAP_TASK_SLOTS = 4096;
+
+/* Number of keys SymTable_getMany resolves side by side. */
+enum {GET_MANY_BATCH = 16};
+
+/* Hint that the memory at pv will be read soon. Does nothing on
+compilers without a prefetch builtin. */
+static void SymTable_prefetch(const void *pv)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(pv);
+#else
+    (void)pv;
+#endif
+}
+
+/* Return the full hash code in oSymTable of the key that is the
+uLength characters at pcKey. The code is not reduced to a slot index,
+so it can be cached in the slot and reused on expansion. */
+static size_t SymTable_hash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Each key is allocated behind a copy of its full hash code, so that
+the slot of an interned key can be found from the key alone. */
+struct SymTableKey
+{
+    /* The full hash code of the key. */
+    size_t uHash;
+    /* The characters of the key. */
+    char acKey[];
+};
+
+/* Return the number of bytes occupied by a key of uLength
+characters. */
+static size_t SymTable_keySize(size_t uLength)
+{
+    /* +1 at the end marks the null terminator character. */
+    return offsetof(struct SymTableKey, acKey) + uLength + 1;
+}
+
+/* Return the SymTableKey whose characters are at pcKey, a key copy
+owned by a SymTable. */
+static struct SymTableKey *SymTable_keyOf(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return (struct SymTableKey*)(void*)
+        (pcKey - offsetof(struct SymTableKey, acKey));
+}
+
+/* Return a null-terminated copy, owned by oSymTable, of the uLength
+characters at pcKey, whose full hash code is uHash, or NULL if
+insufficient memory is available. */
+static char *SymTable_copyKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    struct SymTableKey *psCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oArena != NULL)
+        psCopy = (struct SymTableKey*)Arena_alloc(oSymTable->oArena,
+            SymTable_keySize(uLength));
+    else
+        psCopy = (struct SymTableKey*)malloc(SymTable_keySize(uLength));
+    if (psCopy == NULL)
+    {
+        return NULL;
+    }
+    psCopy->uHash = uHash;
+    memcpy(psCopy->acKey, pcKey, uLength);
+    psCopy->acKey[uLength] = '\0';
+    return psCopy->acKey;
+}
+
+/* Free the key in psSlot, a key copy owned by oSymTable. */
+static void SymTable_freeKey(SymTable_T oSymTable,
+    struct SymTableSlot *psSlot)
+{
+    assert(oSymTable != NULL);
+    assert(psSlot != NULL);
+    assert(psSlot->pcKey != NULL);
+
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_release(oSymTable->oArena, SymTable_keyOf(psSlot->pcKey),
+            SymTable_keySize(psSlot->uKeyLength));
+        return;
+    }
+    free(SymTable_keyOf(psSlot->pcKey));
+}
+
+/* Return the position in iteration order of bindings whose full hash
+code is uHash. The hash code is scrambled with Fibonacci hashing so
+that the high bits depend on every character of the key. */
+static size_t SymTable_order(size_t uHash)
+{
+    const size_t FIBONACCI_MULTIPLIER = (size_t)0x9E3779B97F4A7C15u;
+
+    return uHash * FIBONACCI_MULTIPLIER;
+}
+
+/* Return the home slot of a binding whose hash code is uHash in
+oSymTable: the high bits of its position, so that home slots are in
+the same order as positions. */
+static size_t SymTable_home(SymTable_T oSymTable, size_t uHash)
+{
+    assert(oSymTable != NULL);
+
+    return SymTable_order(uHash) >> oSymTable->uShift;
+}
+
+/* Return the distance between slot uIndex of oSymTable and the home
+slot of the binding stored there. */
+static size_t SymTable_distance(SymTable_T oSymTable, size_t uIndex)
+{
+    assert(oSymTable != NULL);
+    assert(oSymTable->psSlots[uIndex].pcKey != NULL);
+
+    return (uIndex - SymTable_home(oSymTable,
+        oSymTable->psSlots[uIndex].uHash))
+        & (oSymTable->uSlotCount - 1);
+}
+
+/* Place sSlot into oSymTable, which must have an empty slot and must
+not already contain sSlot's key, starting at slot uIndex, which is
+uDistance slots past sSlot's home slot. No slot before uIndex may hold
+a binding closer to its home slot than sSlot would be. Bindings that
+are closer to their home slots are displaced along the way. Return the
+index of the slot that sSlot was placed in. */
+static size_t SymTable_placeFrom(SymTable_T oSymTable,
+    struct SymTableSlot sSlot, size_t uIndex, size_t uDistance)
+{
+    struct SymTableSlot sDisplaced;
+    size_t uMask;
+    size_t uPlaced;
+
+    assert(oSymTable != NULL);
+    assert(sSlot.pcKey != NULL);
+    assert(uIndex < oSymTable->uSlotCount);
+
+    uMask = oSymTable->uSlotCount - 1;
+    uPlaced = oSymTable->uSlotCount;
+
+    while (oSymTable->psSlots[uIndex].pcKey != NULL)
+    {
+        if (SymTable_distance(oSymTable, uIndex) < uDistance)
+        {
+            /* The first displacement is where sSlot itself stays. */
+            if (uPlaced == oSymTable->uSlotCount)
+            {
+                uPlaced = uIndex;
+            }
+            sDisplaced = oSymTable->psSlots[uIndex];
+            oSymTable->psSlots[uIndex] = sSlot;
+            sSlot = sDisplaced;
+            uDistance = SymTable_distance(oSymTable, uIndex);
+        }
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+    oSymTable->psSlots[uIndex] = sSlot;
+    return uPlaced == oSymTable->uSlotCount ? uIndex : uPlaced;
+}
+
+/* Place sSlot into oSymTable, as SymTable_placeFrom does, starting at
+its home slot. */
+static size_t SymTable_place(SymTable_T oSymTable,
+    struct SymTableSlot sSlot)
+{
+    assert(oSymTable != NULL);
+
+    return SymTable_placeFrom(oSymTable, sSlot,
+        SymTable_home(oSymTable, sSlot.uHash), 0);
+}
+
+/* Return the index of the slot in oSymTable whose key is the uLength
+characters at pcKey and whose hash code is uHash, or
+oSymTable->uSlotCount if there is no such slot. In that case set
+*puStop to the slot where the search stopped and *puDistance to its
+distance from the key's home slot: where SymTable_placeFrom can put
+the key. */
+static size_t SymTable_search(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, size_t *puStop,
+    size_t *puDistance)
+{
+    struct SymTableSlot *psSlot;
+    size_t uIndex;
+    size_t uDistance = 0;
+    size_t uMask;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uMask = oSymTable->uSlotCount - 1;
+    uIndex = SymTable_home(oSymTable, uHash);
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
+
+    for (;;)
+    {
+        SYMTABLE_COUNT(oSymTable, uProbes, 1);
+        SYMTABLE_TRACE_PROBES(oSymTable, 1);
+        psSlot = &oSymTable->psSlots[uIndex];
+        /* Under Robin Hood ordering the key cannot lie past an empty
+        slot or past a binding closer to its home than we are. */
+        if (psSlot->pcKey == NULL ||
+            SymTable_distance(oSymTable, uIndex) < uDistance)
+        {
+            *puStop = uIndex;
+            *puDistance = uDistance;
+            return oSymTable->uSlotCount;
+        }
+        if (psSlot->uHash == uHash && psSlot->uKeyLength == uLength &&
+            memcmp(psSlot->pcKey, pcKey, uLength) == 0)
+        {
+            return uIndex;
+        }
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+}
+
+/* Return the index of the slot in oSymTable whose key is the uLength
+characters at pcKey and whose hash code is uHash, or
+oSymTable->uSlotCount if there is no such slot. */
+static size_t SymTable_find(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    size_t uStop;
+    size_t uDistance;
+
+    return SymTable_search(oSymTable, pcKey, uLength, uHash, &uStop,
+        &uDistance);
+}
+
+/* Return SymTable_find(oSymTable, pcKey, uLength, uHash), counting
+the search as a lookup by a get, contains, or replace function. */
+static size_t SymTable_lookup(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    size_t uIndex;
+
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, uIndex != oSymTable->uSlotCount);
+    return uIndex;
+}
+
+/* Return the number of slots needed to hold uCapacity bindings
+without exceeding the maximum load: the smallest power of two, at
+least INITIAL_SLOT_COUNT, that is large enough. Return 0 if that
+count cannot be represented. */
+static size_t SymTable_slotCountFor(size_t uCapacity)
+{
+    size_t uSlotCount = INITIAL_SLOT_COUNT;
+
+    if (uCapacity > (size_t)-1 / MAX_LOAD_DENOMINATOR)
+    {
+        return 0;
+    }
+    while (uCapacity * MAX_LOAD_DENOMINATOR >
+        uSlotCount * MAX_LOAD_NUMERATOR)
+    {
+        if (uSlotCount > (size_t)-1 / 2 / sizeof(struct SymTableSlot))
+        {
+            return 0;
+        }
+        uSlotCount *= 2;
+    }
+    return uSlotCount;
+}
+
+/* Return the number of bits to shift a scrambled hash code right to
+get a slot index among uSlotCount slots, a power of two. */
+static size_t SymTable_shiftFor(size_t uSlotCount)
+{
+    size_t uBits = 0;
+
+    while (((size_t)1 << uBits) < uSlotCount)
+        uBits++;
+    return sizeof(size_t) * 8 - uBits;
+}
+
+/* Move every binding of oSymTable into a new array of uNewSlotCount
+slots, a power of two that must have room for all of them. Return 1
+on success, 0 on failure (not enough memory). */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewSlotCount)
+{
+    struct SymTableSlot *psOldSlots;
+    struct SymTableSlot *psNewSlots;
+    size_t uOldSlotCount;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(uNewSlotCount > oSymTable->uLength);
+
+    psNewSlots = (struct SymTableSlot*)
+        calloc(uNewSlotCount, sizeof(struct SymTableSlot));
+    if (psNewSlots == NULL)
+    {
+        return 0;
+    }
+
+    SYMTABLE_COUNT(oSymTable, uExpansions,
+        uNewSlotCount > oSymTable->uSlotCount);
+    SYMTABLE_TRACE_CAUSE(oSymTable,
+        uNewSlotCount > oSymTable->uSlotCount ?
+        SYMTABLE_TRACE_EXPAND : SYMTABLE_TRACE_SHRINK);
+    psOldSlots = oSymTable->psSlots;
+    uOldSlotCount = oSymTable->uSlotCount;
+    oSymTable->psSlots = psNewSlots;
+    oSymTable->uSlotCount = uNewSlotCount;
+    oSymTable->uShift = SymTable_shiftFor(uNewSlotCount);
+
+    /* The cached hash codes make this a pure redistribution: no key
+    is hashed or compared again. */
+    for (i = 0; i < uOldSlotCount; i++)
+    {
+        if (psOldSlots[i].pcKey != NULL)
+        {
+            (void)SymTable_place(oSymTable, psOldSlots[i]);
+        }
+    }
+    free(psOldSlots);
+
+    return 1;
+}
+
+/* Double the number of slots in oSymTable. Return 1 on success, 0 on
+failure (not enough memory). */
+static int SymTable_expand(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->uSlotCount >
+        (size_t)-1 / 2 / sizeof(struct SymTableSlot))
+    {
+        return 0;
+    }
+    return SymTable_resize(oSymTable, oSymTable->uSlotCount * 2);
+}
+
+/* Shrink oSymTable if it has far more slots than bindings. A failed
+shrink is harmless: the table keeps its current slots. */
+static void SymTable_shrink(SymTable_T oSymTable)
+{
+    size_t uNewSlotCount;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->uSlotCount <= INITIAL_SLOT_COUNT ||
+        oSymTable->uLength >
+        oSymTable->uSlotCount / SHRINK_LOAD_DENOMINATOR)
+    {
+        return;
+    }
+
+    uNewSlotCount = SymTable_slotCountFor(oSymTable->uLength * 2);
+    if (uNewSlotCount == 0 || uNewSlotCount >= oSymTable->uSlotCount)
+    {
+        return;
+    }
+    (void)SymTable_resize(oSymTable, uNewSlotCount);
+}
+
+/* Remove the binding in slot uIndex of oSymTable, shifting the
+bindings that follow it back toward their home slots. */
+static void SymTable_erase(SymTable_T oSymTable, size_t uIndex)
+{
+    size_t uNext;
+    size_t uMask;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->psSlots[uIndex].pcKey != NULL);
+
+    uMask = oSymTable->uSlotCount - 1;
+    SymTable_freeKey(oSymTable, &oSymTable->psSlots[uIndex]);
+
+    for (uNext = (uIndex + 1) & uMask;
+        oSymTable->psSlots[uNext].pcKey != NULL &&
+        SymTable_distance(oSymTable, uNext) != 0;
+        uNext = (uNext + 1) & uMask)
+    {
+        oSymTable->psSlots[uIndex] = oSymTable->psSlots[uNext];
+        uIndex = uNext;
+    }
+    oSymTable->psSlots[uIndex].pcKey = NULL;
+    oSymTable->uLength--;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uSlotCount;
+
+    uSlotCount = SymTable_slotCountFor(uCapacity);
+    if (uSlotCount == 0)
+    {
+        return NULL;
+    }
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oSymTable->psSlots = (struct SymTableSlot*)
+        calloc(uSlotCount, sizeof(struct SymTableSlot));
+    if (oSymTable->psSlots == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->uSlotCount = uSlotCount;
+    oSymTable->uShift = SymTable_shiftFor(uSlotCount);
+    oSymTable->uLength = 0;
+    oSymTable->oArena = NULL;
+    oSymTable->pfHash = StrHash_multiply;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+#endif
+#ifdef SYMTABLE_TRACE
+    memset(&oSymTable->sTrace, 0, sizeof(oSymTable->sTrace));
+#endif
+
+    return oSymTable;
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newArena(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oSymTable->oArena = Arena_new();
+    if (oSymTable->oArena == NULL)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash)
+{
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    oSymTable->pfHash = pfHash;
+
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_FREE(oSymTable);
+    /* Arena keys are released together with their slabs, so the
+    slots need not be walked at all. */
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_free(oSymTable->oArena);
+    }
+    else
+    {
+        for (i = 0; i < oSymTable->uSlotCount; i++)
+        {
+            if (oSymTable->psSlots[i].pcKey != NULL)
+            {
+                SymTable_freeKey(oSymTable, &oSymTable->psSlots[i]);
+            }
+        }
+    }
+    free(oSymTable->psSlots);
+    free(oSymTable);
+}
+
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_hash(oSymTable, pcKey, strlen(pcKey));
+}
+
+/* Do the work of SymTable_reserve, which traces it. */
+static int SymTable_reserveUntraced(SymTable_T oSymTable,
+    size_t uCapacity)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    uSlotCount = SymTable_slotCountFor(uCapacity);
+    if (uSlotCount == 0)
+    {
+        return 0;
+    }
+    if (uSlotCount <= oSymTable->uSlotCount)
+    {
+        return 1;
+    }
+    return SymTable_resize(oSymTable, uSlotCount);
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_reserveUntraced(oSymTable, uCapacity);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RESERVE, NULL);
+    return iSuccessful;
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    return oSymTable->uLength;
+}
+
+/* Return the slot of the binding in oSymTable whose key is the
+uLength characters at pcKey, whose full hash code is uHash, first
+putting a binding of that key and pvValue if there is none. Set
+*piAdded to 1 (TRUE) if a binding was put, or 0 (FALSE) otherwise.
+Return NULL if insufficient memory is available. */
+static struct SymTableSlot *SymTable_findOrAdd(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue, int *piAdded)
+{
+    struct SymTableSlot sNewSlot;
+    size_t uIndex;
+    size_t uStop;
+    size_t uDistance;
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piAdded != NULL);
+
+    SYMTABLE_COUNT(oSymTable, uPuts, 1);
+    *piAdded = 0;
+    uIndex = SymTable_search(oSymTable, pcKey, uLength, uHash, &uStop,
+        &uDistance);
+    if (uIndex != oSymTable->uSlotCount)
+    {
+        return &oSymTable->psSlots[uIndex];
+    }
+    uSlotCount = oSymTable->uSlotCount;
+
+    /* Expand before the table gets too full for short probes. If
+    expansion fails, keep going as long as a slot remains free. */
+    if ((oSymTable->uLength + 1) * MAX_LOAD_DENOMINATOR >
+        oSymTable->uSlotCount * MAX_LOAD_NUMERATOR)
+    {
+        if (!SymTable_expand(oSymTable) &&
+            oSymTable->uLength + 1 >= oSymTable->uSlotCount)
+        {
+            return NULL;
+        }
+    }
+
+    sNewSlot.pcKey = SymTable_copyKey(oSymTable, pcKey, uLength,
+        uHash);
+    if (sNewSlot.pcKey == NULL)
+    {
+        return NULL;
+    }
+    sNewSlot.uKeyLength = uLength;
+    sNewSlot.uHash = uHash;
+    sNewSlot.pvValue = pvValue;
+
+    /* Unless an expansion moved every binding, carry on from where the
+    search stopped instead of walking the probe sequence again. */
+    if (oSymTable->uSlotCount == uSlotCount)
+    {
+        uIndex = SymTable_placeFrom(oSymTable, sNewSlot, uStop,
+            uDistance);
+    }
+    else
+    {
+        uIndex = SymTable_place(oSymTable, sNewSlot);
+    }
+    oSymTable->uLength++;
+    *piAdded = 1;
+    return &oSymTable->psSlots[uIndex];
+}
+
+/* Put a binding of the uLength characters at pcKey, whose full hash
+code is uHash, and pvValue into oSymTable. Return 1 (TRUE) if
+successful, or 0 (FALSE) if the key is already present or
+insufficient memory is available. */
+static int SymTable_putWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue)
+{
+    int iAdded;
+
+    return SymTable_findOrAdd(oSymTable, pcKey, uLength, uHash,
+        pvValue, &iAdded) != NULL && iAdded;
+}
+
+int SymTable_putLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash, pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uLength;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    iSuccessful = SymTable_putWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+size_t SymTable_putMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues,
+    size_t uCount)
+{
+    size_t uAdded = 0;
+    size_t uLength;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Size the table once, so that no put below expands it. If that
+    fails, the puts still expand the table as they go. */
+    if (uCount <= (size_t)-1 - oSymTable->uLength)
+    {
+        (void)SymTable_reserveUntraced(oSymTable,
+            oSymTable->uLength + uCount);
+    }
+
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        uLength = strlen(ppcKeys[i]);
+        if (SymTable_putWithHash(oSymTable, ppcKeys[i], uLength,
+            SymTable_hash(oSymTable, ppcKeys[i], uLength),
+            ppvValues[i]))
+        {
+            uAdded++;
+        }
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT_MANY, NULL);
+    return uAdded;
+}
+
+/* If oSymTable contains a binding whose key is the uLength characters
+at pcKey, with full hash code uHash, then replace the binding's value
+with pvValue and return the old value. Otherwise return NULL. */
+static void *SymTable_replaceWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    const void *pvValue)
+{
+    const void *pvValueOld;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_lookup(oSymTable, pcKey, uLength, uHash);
+    if (uIndex == oSymTable->uSlotCount)
+    {
+        return NULL;
+    }
+
+    pvValueOld = oSymTable->psSlots[uIndex].pvValue;
+    oSymTable->psSlots[uIndex].pvValue = pvValue;
+    return (void*)pvValueOld;
+}
+
+void *SymTable_replaceLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replaceHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash, pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uLength;
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvOldValue = SymTable_replaceWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+int SymTable_containsLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_lookup(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength))
+        != oSymTable->uSlotCount;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_lookup(oSymTable, pcKey, strlen(pcKey), uHash)
+        != oSymTable->uSlotCount;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    iFound = SymTable_lookup(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength))
+        != oSymTable->uSlotCount;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+/* Return the value of the binding within oSymTable whose key is the
+uLength characters at pcKey, with full hash code uHash, or NULL if no
+such binding exists. */
+static void *SymTable_getWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_lookup(oSymTable, pcKey, uLength, uHash);
+    if (uIndex == oSymTable->uSlotCount)
+    {
+        return NULL;
+    }
+    return (void*)oSymTable->psSlots[uIndex].pvValue;
+}
+
+void *SymTable_getLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, strlen(pcKey),
+        uHash);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvValue = SymTable_getWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void SymTable_getMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues)
+{
+    size_t auLengths[GET_MANY_BATCH];
+    size_t auHashes[GET_MANY_BATCH];
+    size_t uBatch;
+    size_t uIndex;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Hash a batch of keys and prefetch their home slots before
+    probing any of them, so that the cache misses overlap. A probe
+    rarely leaves the cache line of its home slot. */
+    while (uCount > 0)
+    {
+        uBatch = uCount < GET_MANY_BATCH ? uCount : GET_MANY_BATCH;
+        for (i = 0; i < uBatch; i++)
+        {
+            assert(ppcKeys[i] != NULL);
+            auLengths[i] = strlen(ppcKeys[i]);
+            auHashes[i] = SymTable_hash(oSymTable, ppcKeys[i],
+                auLengths[i]);
+            SymTable_prefetch(&oSymTable->psSlots[
+                SymTable_home(oSymTable, auHashes[i])]);
+        }
+        for (i = 0; i < uBatch; i++)
+        {
+            uIndex = SymTable_lookup(oSymTable, ppcKeys[i],
+                auLengths[i], auHashes[i]);
+            if (uIndex == oSymTable->uSlotCount)
+                ppvValues[i] = NULL;
+            else
+                ppvValues[i] =
+                    (void*)oSymTable->psSlots[uIndex].pvValue;
+        }
+        ppcKeys += uBatch;
+        ppvValues += uBatch;
+        uCount -= uBatch;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_MANY, NULL);
+}
+
+/* If oSymTable contains a binding whose key is the uLength characters
+at pcKey, with full hash code uHash, remove that binding from
+oSymTable and return the binding's value. Otherwise return NULL. */
+static void *SymTable_removeWithHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    const void *pvRemovedValue;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash);
+    if (uIndex == oSymTable->uSlotCount)
+    {
+        return NULL;
+    }
+
+    pvRemovedValue = oSymTable->psSlots[uIndex].pvValue;
+    SymTable_erase(oSymTable, uIndex);
+    SymTable_shrink(oSymTable);
+    return (void*)pvRemovedValue;
+}
+
+void *SymTable_removeLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey,
+        strlen(pcKey), uHash);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    pvRemovedValue = SymTable_removeWithHash(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableSlot *psSlot;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    for (i = 0; i < oSymTable->uSlotCount; i++)
+    {
+        psSlot = &oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL)
+        {
+            (*pfApply) ((void*)psSlot->pcKey,
+            (void*)psSlot->pvValue, ((void*)pvExtra));
+        }
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP, NULL);
+}
+
+/* The state of one call of SymTable_mapParallel. Task i covers slots
+i * MAP_TASK_SLOTS up to (i + 1) * MAP_TASK_SLOTS. */
+struct SymTableMapRun
+{
+    /* The table being mapped. */
+    SymTable_T oSymTable;
+    /* The function to apply to each binding. */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* The extra parameter of each worker. */
+    void *const *ppvExtras;
+};
+
+/* Apply the function of pvRun, a struct SymTableMapRun, to the
+bindings in the slots of task uTask, passing the extra parameter of
+worker uWorker. */
+static void SymTable_mapTask(void *pvRun, size_t uTask, size_t uWorker)
+{
+    struct SymTableMapRun *psRun = (struct SymTableMapRun*)pvRun;
+    struct SymTableSlot *psSlot;
+    size_t uLast;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    uLast = psRun->oSymTable->uSlotCount;
+    if (uLast - uTask * MAP_TASK_SLOTS > MAP_TASK_SLOTS)
+    {
+        uLast = (uTask + 1) * MAP_TASK_SLOTS;
+    }
+
+    for (i = uTask * MAP_TASK_SLOTS; i < uLast; i++)
+    {
+        psSlot = &psRun->oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL)
+        {
+            (*psRun->pfApply) (psSlot->pcKey, (void*)psSlot->pvValue,
+                psRun->ppvExtras[uWorker]);
+        }
+    }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *const *ppvExtras, size_t uWorkerCount)
+{
+    struct SymTableMapRun sRun;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(ppvExtras != NULL);
+    assert(uWorkerCount > 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    sRun.oSymTable = oSymTable;
+    sRun.pfApply = pfApply;
+    sRun.ppvExtras = ppvExtras;
+
+    Parallel_run(oSymTable->uSlotCount / MAP_TASK_SLOTS
+        + (oSymTable->uSlotCount % MAP_TASK_SLOTS != 0),
+        uWorkerCount, SymTable_mapTask, &sRun);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL, NULL);
+}
+
+/* A SymTableIter walks the bindings of its table in iteration order:
+by position (see SymTable_order), then by key length, then by key
+bytes. That order is total and does not depend on the slot count, so
+remembering the last binding returned is enough to resume. */
+struct SymTableIter
+{
+    /* The table being walked. */
+    SymTable_T oSymTable;
+    /* 1 (TRUE) once a binding has been returned, 0 (FALSE) before. */
+    int iStarted;
+    /* The position of the last binding returned. */
+    size_t uLastOrder;
+    /* A copy of the key of the last binding returned, not null
+    terminated, or NULL if none has been returned. */
+    char *pcLastKey;
+    /* The number of characters in pcLastKey. */
+    size_t uLastLength;
+    /* The number of bytes allocated for pcLastKey. */
+    size_t uKeyCapacity;
+};
+
+/* Return a negative number, 0, or a positive number as the binding at
+position uOrder1 whose key is the uLength1 characters at pcKey1 comes
+before, is the same as, or comes after the binding at position uOrder2
+whose key is the uLength2 characters at pcKey2 in iteration order. */
+static int SymTable_compareOrder(size_t uOrder1, const char *pcKey1,
+    size_t uLength1, size_t uOrder2, const char *pcKey2,
+    size_t uLength2)
+{
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    if (uOrder1 != uOrder2)
+    {
+        return uOrder1 < uOrder2 ? -1 : 1;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return memcmp(pcKey1, pcKey2, uLength1);
+}
+
+/* Return 1 (TRUE) if the binding in psSlot comes after the last
+binding oIter returned, or if oIter has returned none yet; 0 (FALSE)
+otherwise. */
+static int SymTable_iterAfter(SymTableIter_T oIter,
+    const struct SymTableSlot *psSlot)
+{
+    assert(oIter != NULL);
+    assert(psSlot != NULL);
+    assert(psSlot->pcKey != NULL);
+
+    return !oIter->iStarted
+        || SymTable_compareOrder(SymTable_order(psSlot->uHash),
+            psSlot->pcKey, psSlot->uKeyLength, oIter->uLastOrder,
+            oIter->pcLastKey, oIter->uLastLength) > 0;
+}
+
+/* Record the binding in psSlot as the last binding oIter returned.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available to copy its key. */
+static int SymTable_iterRemember(SymTableIter_T oIter,
+    const struct SymTableSlot *psSlot)
+{
+    char *pcNewKey;
+
+    assert(oIter != NULL);
+    assert(psSlot != NULL);
+
+    /* +1 so that even an empty key gets a buffer. */
+    if (psSlot->uKeyLength + 1 > oIter->uKeyCapacity)
+    {
+        pcNewKey = (char*)realloc(oIter->pcLastKey,
+            psSlot->uKeyLength + 1);
+        if (pcNewKey == NULL)
+        {
+            return 0;
+        }
+        oIter->pcLastKey = pcNewKey;
+        oIter->uKeyCapacity = psSlot->uKeyLength + 1;
+    }
+    memcpy(oIter->pcLastKey, psSlot->pcKey, psSlot->uKeyLength);
+    oIter->uLastLength = psSlot->uKeyLength;
+    oIter->uLastOrder = SymTable_order(psSlot->uHash);
+    oIter->iStarted = 1;
+    return 1;
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    oIter = (SymTableIter_T)malloc(sizeof(struct SymTableIter));
+    if (oIter != NULL)
+    {
+        oIter->oSymTable = oSymTable;
+        oIter->iStarted = 0;
+        oIter->uLastOrder = 0;
+        oIter->pcLastKey = NULL;
+        oIter->uLastLength = 0;
+        oIter->uKeyCapacity = 0;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_BEGIN, NULL);
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    SymTable_T oSymTable;
+    struct SymTableSlot *psSlot;
+    struct SymTableSlot *psBest = NULL;
+    size_t uIndex;
+    size_t uScanned;
+    int iFound = 0;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    oSymTable = oIter->oSymTable;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Bindings that come after the last one returned have home slots
+    at or after its home slot, and linear probing keeps each one
+    between its home slot and the next empty slot. So scanning on
+    from that home slot, the first binding found rules out every
+    cluster after the one it is in. A binding whose cluster wraps
+    around the end of the array may be met before the scan has passed
+    its home slot; it is skipped then, and taken when the scan comes
+    round to it again. */
+    uIndex = oIter->uLastOrder >> oSymTable->uShift;
+    for (uScanned = 0; uScanned < 2 * oSymTable->uSlotCount;
+        uScanned++)
+    {
+        psSlot = &oSymTable->psSlots[uIndex];
+        if (psSlot->pcKey == NULL)
+        {
+            if (psBest != NULL)
+                break;
+        }
+        else if (SymTable_distance(oSymTable, uIndex) <= uScanned
+            && SymTable_iterAfter(oIter, psSlot)
+            && (psBest == NULL
+                || SymTable_compareOrder(SymTable_order(psSlot->uHash),
+                    psSlot->pcKey, psSlot->uKeyLength,
+                    SymTable_order(psBest->uHash), psBest->pcKey,
+                    psBest->uKeyLength) < 0))
+        {
+            psBest = psSlot;
+        }
+        uIndex = (uIndex + 1) & (oSymTable->uSlotCount - 1);
+    }
+
+    if (psBest != NULL && SymTable_iterRemember(oIter, psBest))
+    {
+        *ppcKey = psBest->pcKey;
+        *ppvValue = (void*)psBest->pvValue;
+        iFound = 1;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_NEXT, NULL);
+    return iFound;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    assert(oIter != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oIter->oSymTable);
+    free(oIter->pcLastKey);
+    SYMTABLE_TRACE_END(oIter->oSymTable, SYMTABLE_TRACE_ITER_END, NULL);
+    free(oIter);
+}
+
+/* The bounds of a SymTable_range or SymTable_prefix query. */
+struct SymTableBounds
+{
+    /* Every selected key is at least the uLowLength characters at
+    pcLow. */
+    const char *pcLow;
+    size_t uLowLength;
+    /* Every selected key is less than the uHighLength characters at
+    pcHigh, or, if pcHigh is NULL, begins with the characters at
+    pcLow. */
+    const char *pcHigh;
+    size_t uHighLength;
+};
+
+/* Return a negative number, 0, or a positive number as the uLength1
+characters at pcKey1 come before, are the same as, or come after the
+uLength2 characters at pcKey2. Keys are compared character by
+character as unsigned chars, and a key comes after its own
+prefixes. */
+static int SymTable_compareKeys(const char *pcKey1, size_t uLength1,
+    const char *pcKey2, size_t uLength2)
+{
+    int iResult;
+
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    iResult = memcmp(pcKey1, pcKey2,
+        uLength1 < uLength2 ? uLength1 : uLength2);
+    if (iResult != 0)
+    {
+        return iResult;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Return 1 (TRUE) if the uLength characters at pcKey are within
+psBounds, or 0 (FALSE) otherwise. */
+static int SymTable_inBounds(const struct SymTableBounds *psBounds,
+    const char *pcKey, size_t uLength)
+{
+    assert(psBounds != NULL);
+    assert(pcKey != NULL);
+
+    if (psBounds->pcHigh == NULL)
+    {
+        return uLength >= psBounds->uLowLength &&
+            memcmp(pcKey, psBounds->pcLow, psBounds->uLowLength) == 0;
+    }
+    return SymTable_compareKeys(pcKey, uLength, psBounds->pcLow,
+            psBounds->uLowLength) >= 0
+        && SymTable_compareKeys(pcKey, uLength, psBounds->pcHigh,
+            psBounds->uHighLength) < 0;
+}
+
+/* Compare the keys of the slots that pv1 and pv2 point to, as
+SymTable_compareKeys does. Suitable for qsort. */
+static int SymTable_compareSlots(const void *pv1, const void *pv2)
+{
+    const struct SymTableSlot *psSlot1 =
+        *(struct SymTableSlot *const *)pv1;
+    const struct SymTableSlot *psSlot2 =
+        *(struct SymTableSlot *const *)pv2;
+
+    return SymTable_compareKeys(psSlot1->pcKey, psSlot1->uKeyLength,
+        psSlot2->pcKey, psSlot2->uKeyLength);
+}
+
+/* Apply *pfApply, passing pvExtra, to each binding of oSymTable within
+psBounds, in increasing order of key. Slots keep no order, so the
+bindings are gathered and sorted first. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available. */
+static int SymTable_applyRange(SymTable_T oSymTable,
+    const struct SymTableBounds *psBounds,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableSlot *psSlot;
+    struct SymTableSlot **ppsSelected;
+    size_t uCount = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psBounds != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTable->uSlotCount; i++)
+    {
+        psSlot = &oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL && SymTable_inBounds(psBounds,
+            psSlot->pcKey, psSlot->uKeyLength))
+            uCount++;
+    }
+    if (uCount == 0)
+    {
+        return 1;
+    }
+
+    ppsSelected = (struct SymTableSlot**)
+        malloc(uCount * sizeof(struct SymTableSlot*));
+    if (ppsSelected == NULL)
+    {
+        return 0;
+    }
+    uCount = 0;
+    for (i = 0; i < oSymTable->uSlotCount; i++)
+    {
+        psSlot = &oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL && SymTable_inBounds(psBounds,
+            psSlot->pcKey, psSlot->uKeyLength))
+            ppsSelected[uCount++] = psSlot;
+    }
+    qsort(ppsSelected, uCount, sizeof(struct SymTableSlot*),
+        SymTable_compareSlots);
+
+    for (i = 0; i < uCount; i++)
+    {
+        (*pfApply) (ppsSelected[i]->pcKey,
+            (void*)ppsSelected[i]->pvValue, (void*)pvExtra);
+    }
+    free(ppsSelected);
+    return 1;
+}
+
+int SymTable_range(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcLow != NULL);
+    assert(pcHigh != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcLow;
+    sBounds.uLowLength = strlen(pcLow);
+    sBounds.pcHigh = pcHigh;
+    sBounds.uHighLength = strlen(pcHigh);
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RANGE, pcLow);
+    return iSuccessful;
+}
+
+int SymTable_prefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcPrefix;
+    sBounds.uLowLength = strlen(pcPrefix);
+    sBounds.pcHigh = NULL;
+    sBounds.uHighLength = 0;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_applyRange(oSymTable, &sBounds, pfApply,
+        pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PREFIX, pcPrefix);
+    return iSuccessful;
+}
+
+/* Return the index of the slot of oSymTable that holds pcKey, a
+pointer that SymTable_intern returned for oSymTable. The hash code
+stored with the key gives the home slot, and slots are compared by key
+address, so no key is hashed or compared. */
+static size_t SymTable_findInterned(SymTable_T oSymTable,
+    const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_home(oSymTable, SymTable_keyOf(pcKey)->uHash);
+    while (oSymTable->psSlots[uIndex].pcKey != pcKey)
+    {
+        assert(oSymTable->psSlots[uIndex].pcKey != NULL);
+        uIndex = (uIndex + 1) & (oSymTable->uSlotCount - 1);
+    }
+    return uIndex;
+}
+
+const char *SymTable_intern(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableSlot *psSlot;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psSlot = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), NULL, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_INTERN, pcKey);
+    if (psSlot == NULL)
+    {
+        return NULL;
+    }
+    return psSlot->pcKey;
+}
+
+void *SymTable_getInterned(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, 1);
+    pvValue = (void*)oSymTable->psSlots[
+        SymTable_findInterned(oSymTable, pcKey)].pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableSlot *psSlot;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psSlot = &oSymTable->psSlots[SymTable_findInterned(oSymTable,
+        pcKey)];
+    pvOldValue = psSlot->pvValue;
+    psSlot->pvValue = pvValue;
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return (void*)pvOldValue;
+}
+
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    const char *pcKey)
+{
+    const void *pvRemovedValue;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uIndex = SymTable_findInterned(oSymTable, pcKey);
+    pvRemovedValue = oSymTable->psSlots[uIndex].pvValue;
+    SymTable_erase(oSymTable, uIndex);
+    SymTable_shrink(oSymTable);
+    /* The key went with the slot. */
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, NULL);
+    return (void*)pvRemovedValue;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    struct SymTableSlot *psSlot;
+    size_t uHomes = 0;
+    size_t uRun = 0;
+    size_t uHome = 0;
+    size_t uNextHome;
+    size_t uStart;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uLength = oSymTable->uLength;
+    psStats->uBucketCount = oSymTable->uSlotCount;
+    psStats->dLoadFactor =
+        (double)oSymTable->uLength / (double)oSymTable->uSlotCount;
+    psStats->uBucketBytes =
+        oSymTable->uSlotCount * sizeof(struct SymTableSlot);
+
+    /* Robin Hood ordering keeps the bindings with the same home slot
+    next to each other, so each bucket is a run of equal homes. Start
+    the scan at an empty slot so that no run wraps around the end;
+    a table always has at least one empty slot. */
+    for (uStart = 0; oSymTable->psSlots[uStart].pcKey != NULL; uStart++)
+    {
+        assert(uStart + 1 < oSymTable->uSlotCount);
+    }
+    for (i = 1; i <= oSymTable->uSlotCount; i++)
+    {
+        psSlot = &oSymTable->psSlots[(uStart + i) &
+            (oSymTable->uSlotCount - 1)];
+        uNextHome = psSlot->pcKey == NULL ? 0 :
+            SymTable_home(oSymTable, psSlot->uHash);
+        if (uRun > 0 && (psSlot->pcKey == NULL || uNextHome != uHome))
+        {
+            if (uRun > psStats->uMaxChainLength)
+                psStats->uMaxChainLength = uRun;
+            psStats->auChainLengths[uRun < SYMTABLE_HISTOGRAM_SIZE ?
+                uRun : SYMTABLE_HISTOGRAM_SIZE - 1]++;
+            uHomes++;
+            uRun = 0;
+        }
+        if (psSlot->pcKey != NULL)
+        {
+            uHome = uNextHome;
+            uRun++;
+            psStats->uKeyBytes += SymTable_keySize(psSlot->uKeyLength);
+        }
+    }
+    assert(uRun == 0);
+    psStats->auChainLengths[0] = oSymTable->uSlotCount - uHomes;
+
+#ifdef SYMTABLE_STATS
+    psStats->uPuts = oSymTable->sCounters.uPuts;
+    psStats->uGets = oSymTable->sCounters.uGets;
+    psStats->uHits = oSymTable->sCounters.uHits;
+    psStats->uMisses =
+        oSymTable->sCounters.uGets - oSymTable->sCounters.uHits;
+    psStats->uExpansions = oSymTable->sCounters.uExpansions;
+    if (oSymTable->sCounters.uSearches > 0)
+    {
+        psStats->dProbesPerLookup =
+            (double)oSymTable->sCounters.uProbes /
+            (double)oSymTable->sCounters.uSearches;
+    }
+#endif
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_STATS, NULL);
+}
+
+void SymTable_setOrder(SymTable_T oSymTable,
+    enum SymTableOrder eOrder)
+{
+    assert(oSymTable != NULL);
+
+    /* Each binding stays where its hash code puts it. */
+    (void)oSymTable;
+    (void)eOrder;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue)
+{
+    struct SymTableSlot *psSlot;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psSlot = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue, &iAdded);
+    if (psSlot != NULL)
+    {
+        if (ppvOldValue != NULL)
+        {
+            *ppvOldValue = iAdded ? NULL : (void*)psSlot->pvValue;
+        }
+        psSlot->pvValue = pvValue;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_UPSERT, pcKey);
+    return psSlot != NULL;
+}
+
+void **SymTable_getOrInsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue)
+{
+    struct SymTableSlot *psSlot;
+    size_t uLength;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    uLength = strlen(pcKey);
+    psSlot = SymTable_findOrAdd(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_OR_INSERT,
+        pcKey);
+    return psSlot == NULL ? NULL : (void**)&psSlot->pvValue;
+}
+
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableSlot *psSlot;
+    size_t uStart;
+    size_t uOffset;
+    size_t uFree;
+    size_t uShift;
+    size_t uIndex;
+    size_t uMask;
+    size_t uRemoved = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfPredicate != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Sweep once around the table from an empty slot. No probe
+    sequence crosses an empty slot, so no binding ever has to move
+    back past the start of the sweep. */
+    uMask = oSymTable->uSlotCount - 1;
+    for (uStart = 0; oSymTable->psSlots[uStart].pcKey != NULL;
+        uStart++)
+    {
+    }
+
+    /* uFree is the offset from uStart of the first slot that the next
+    binding kept may move back to. Moving each binding kept back over
+    the slots freed before it, but not past its home slot, does what
+    SymTable_erase would have done for each binding removed. */
+    uFree = 1;
+    for (uOffset = 1; uOffset < oSymTable->uSlotCount; uOffset++)
+    {
+        uIndex = (uStart + uOffset) & uMask;
+        psSlot = &oSymTable->psSlots[uIndex];
+        if (psSlot->pcKey == NULL)
+        {
+            uFree = uOffset + 1;
+            continue;
+        }
+        if ((*pfPredicate)(psSlot->pcKey, (void*)psSlot->pvValue,
+            (void*)pvExtra))
+        {
+            if (pfRemoved != NULL)
+            {
+                (*pfRemoved)(psSlot->pcKey, (void*)psSlot->pvValue,
+                    (void*)pvExtra);
+            }
+            SymTable_freeKey(oSymTable, psSlot);
+            psSlot->pcKey = NULL;
+            oSymTable->uLength--;
+            uRemoved++;
+            continue;
+        }
+        uShift = SymTable_distance(oSymTable, uIndex);
+        if (uShift > uOffset - uFree)
+        {
+            uShift = uOffset - uFree;
+        }
+        if (uShift > 0)
+        {
+            oSymTable->psSlots[(uIndex - uShift) & uMask] = *psSlot;
+            psSlot->pcKey = NULL;
+        }
+        uFree = uOffset - uShift + 1;
+    }
+
+    SymTable_shrink(oSymTable);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE_IF, NULL);
+    return uRemoved;
+}
@@ -0,0 +1,280 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.c                                                    */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not C99. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include "symtabletrace.h"
+
+/* Histograms are updated with the GCC __atomic builtins, which C99
+lacks. */
+#if !defined(__GNUC__)
+#error "symtabletrace.c requires the GCC __atomic builtins"
+#endif
+
+enum {
+    /* Each power of two above 2^SUB_BUCKET_BITS is split into
+    2^SUB_BUCKET_BITS buckets. */
+    SUB_BUCKET_BITS = 3,
+    SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS
+};
+
+/* One histogram per kind of operation. Threads add to them with
+relaxed atomic increments, so recording takes no lock. */
+static size_t aauCounts[SYMTABLE_TRACE_OP_COUNT]
+    [SYMTABLE_TRACE_BUCKET_COUNT];
+
+/* The number of operations of each kind, added to by each table when
+it times an operation and when it is freed. */
+static size_t auOpCounts[SYMTABLE_TRACE_OP_COUNT];
+
+/* Each table times one operation in this many. */
+static size_t uSamplePeriod = SYMTABLE_TRACE_DEFAULT_PERIOD;
+
+/* The registered sink, its extra argument, and the time at or above
+which operations are reported to it. */
+static SymTableTrace_Sink pfTraceSink = NULL;
+static void *pvTraceExtra = NULL;
+static size_t uTraceThreshold = 0;
+
+/* Return the current time, in nanoseconds since some fixed point. */
+static size_t SymTableTrace_now(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (size_t)sNow.tv_sec * 1000000000u + (size_t)sNow.tv_nsec;
+}
+
+/* Return the index of the histogram bucket that counts operations
+that took uNanoseconds. */
+static size_t SymTableTrace_bucket(size_t uNanoseconds)
+{
+    size_t uExponent;
+
+    if (uNanoseconds < SUB_BUCKET_COUNT)
+    {
+        return uNanoseconds;
+    }
+    /* uExponent is the position of the highest set bit, at least
+    SUB_BUCKET_BITS. The SUB_BUCKET_BITS bits below it pick the
+    bucket within its power of two. */
+    uExponent = sizeof(unsigned long long) * 8 - 1 -
+        (size_t)__builtin_clzll((unsigned long long)uNanoseconds);
+    return (uExponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT +
+        ((uNanoseconds >> (uExponent - SUB_BUCKET_BITS)) &
+            (SUB_BUCKET_COUNT - 1));
+}
+
+size_t SymTableTrace_bucketLimit(size_t uBucket)
+{
+    size_t uExponent;
+    size_t uSub;
+
+    assert(uBucket < SYMTABLE_TRACE_BUCKET_COUNT);
+
+    if (uBucket < SUB_BUCKET_COUNT)
+    {
+        return uBucket + 1;
+    }
+    uExponent = uBucket / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+    uSub = uBucket % SUB_BUCKET_COUNT;
+    /* The last bucket has no end that a size_t can hold. */
+    if (uExponent >= sizeof(size_t) * 8 - 1 &&
+        uSub == SUB_BUCKET_COUNT - 1)
+    {
+        return (size_t)-1;
+    }
+    return (SUB_BUCKET_COUNT + uSub + 1) <<
+        (uExponent - SUB_BUCKET_BITS);
+}
+
+void SymTableTrace_setSink(SymTableTrace_Sink pfSink,
+    size_t uThreshold, const void *pvExtra)
+{
+    pfTraceSink = pfSink;
+    uTraceThreshold = uThreshold;
+    pvTraceExtra = (void*)pvExtra;
+}
+
+void SymTableTrace_setSamplePeriod(size_t uPeriod)
+{
+    assert(uPeriod > 0);
+
+    uSamplePeriod = uPeriod;
+}
+
+size_t SymTableTrace_getCount(enum SymTableTraceOp eOp)
+{
+    assert(eOp < SYMTABLE_TRACE_OP_COUNT);
+
+    return __atomic_load_n(&auOpCounts[eOp], __ATOMIC_RELAXED);
+}
+
+void SymTableTrace_getHistogram(enum SymTableTraceOp eOp,
+    size_t *puCounts)
+{
+    size_t i;
+
+    assert(eOp < SYMTABLE_TRACE_OP_COUNT);
+    assert(puCounts != NULL);
+
+    for (i = 0; i < SYMTABLE_TRACE_BUCKET_COUNT; i++)
+    {
+        puCounts[i] = __atomic_load_n(&aauCounts[eOp][i],
+            __ATOMIC_RELAXED);
+    }
+}
+
+size_t SymTableTrace_percentile(enum SymTableTraceOp eOp,
+    double dFraction)
+{
+    size_t auCounts[SYMTABLE_TRACE_BUCKET_COUNT];
+    size_t uTotal = 0;
+    size_t uSeen = 0;
+    size_t i;
+
+    assert(eOp < SYMTABLE_TRACE_OP_COUNT);
+    assert(dFraction >= 0.0 && dFraction <= 1.0);
+
+    SymTableTrace_getHistogram(eOp, auCounts);
+    for (i = 0; i < SYMTABLE_TRACE_BUCKET_COUNT; i++)
+    {
+        uTotal += auCounts[i];
+    }
+    if (uTotal == 0)
+    {
+        return 0;
+    }
+    for (i = 0; i < SYMTABLE_TRACE_BUCKET_COUNT; i++)
+    {
+        uSeen += auCounts[i];
+        if ((double)uSeen >= dFraction * (double)uTotal &&
+            uSeen > 0)
+        {
+            break;
+        }
+    }
+    return SymTableTrace_bucketLimit(i) - 1;
+}
+
+void SymTableTrace_reset(void)
+{
+    size_t uOp;
+    size_t i;
+
+    for (uOp = 0; uOp < SYMTABLE_TRACE_OP_COUNT; uOp++)
+    {
+        __atomic_store_n(&auOpCounts[uOp], 0, __ATOMIC_RELAXED);
+        for (i = 0; i < SYMTABLE_TRACE_BUCKET_COUNT; i++)
+        {
+            __atomic_store_n(&aauCounts[uOp][i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void SymTableTrace_sample(struct SymTableTrace *psTrace)
+{
+    assert(psTrace != NULL);
+
+    /* Reading the clock costs as much as a short operation, so most
+    operations are only counted. */
+    psTrace->uCountdown = uSamplePeriod - 1;
+    psTrace->iTimed = 1;
+    psTrace->iSampled = 1;
+    psTrace->uProbes = 0;
+    psTrace->eCause = SYMTABLE_TRACE_NO_CAUSE;
+    psTrace->uStart = SymTableTrace_now();
+}
+
+void SymTableTrace_cause(struct SymTableTrace *psTrace,
+    enum SymTableTraceCause eCause)
+{
+    assert(psTrace != NULL);
+
+    if (!psTrace->iTimed)
+    {
+        if (eCause != SYMTABLE_TRACE_EXPAND &&
+            eCause != SYMTABLE_TRACE_SHRINK)
+        {
+            return;
+        }
+        psTrace->iTimed = 1;
+        psTrace->iSampled = 0;
+        psTrace->uProbes = 0;
+        psTrace->uStart = SymTableTrace_now();
+    }
+    /* A resize is followed by rehash steps, as when SymTable_reserve
+    finishes moving the bindings; the resize is what gets reported. */
+    else if (psTrace->eCause == SYMTABLE_TRACE_EXPAND ||
+        psTrace->eCause == SYMTABLE_TRACE_SHRINK)
+    {
+        return;
+    }
+    psTrace->eCause = eCause;
+}
+
+void SymTableTrace_flush(struct SymTableTrace *psTrace)
+{
+    size_t uOp;
+
+    assert(psTrace != NULL);
+
+    for (uOp = 0; uOp < SYMTABLE_TRACE_OP_COUNT; uOp++)
+    {
+        if (psTrace->auUncounted[uOp] != 0)
+        {
+            __atomic_fetch_add(&auOpCounts[uOp],
+                psTrace->auUncounted[uOp], __ATOMIC_RELAXED);
+            psTrace->auUncounted[uOp] = 0;
+        }
+    }
+}
+
+void SymTableTrace_end(SymTable_T oSymTable,
+    struct SymTableTrace *psTrace, enum SymTableTraceOp eOp,
+    const char *pcKey, const void *pvCaller)
+{
+    struct SymTableTraceEvent sEvent;
+    size_t uElapsed;
+
+    assert(psTrace != NULL);
+    assert(eOp < SYMTABLE_TRACE_OP_COUNT);
+    assert(psTrace->iTimed);
+
+    uElapsed = SymTableTrace_now() - psTrace->uStart;
+    psTrace->iTimed = 0;
+    /* An operation timed only from its resize would skew the
+    histogram. */
+    if (psTrace->iSampled)
+    {
+        __atomic_fetch_add(
+            &aauCounts[eOp][SymTableTrace_bucket(uElapsed)], 1,
+            __ATOMIC_RELAXED);
+        SymTableTrace_flush(psTrace);
+    }
+
+    /* Rehash steps happen all the time; only a resize is notable
+    on its own. */
+    if (pfTraceSink == NULL ||
+        (uElapsed < uTraceThreshold &&
+        psTrace->eCause != SYMTABLE_TRACE_EXPAND &&
+        psTrace->eCause != SYMTABLE_TRACE_SHRINK))
+    {
+        return;
+    }
+    sEvent.oSymTable = oSymTable;
+    sEvent.eOp = eOp;
+    sEvent.pcKey = pcKey;
+    sEvent.pvCaller = pvCaller;
+    sEvent.uNanoseconds = uElapsed;
+    sEvent.uProbes = psTrace->uProbes;
+    sEvent.eCause = psTrace->eCause;
+    (*pfTraceSink)(&sEvent, pvTraceExtra);
+}
@@ -0,0 +1,246 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.h                                                    */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLETRACE_H
+#define SYMTABLETRACE_H
+#include <stddef.h>
+#include "symtable.h"
+
+/* SymTable implementations compiled with SYMTABLE_TRACE defined count
+every call of their public functions, by kind of operation, and time
+one call in every few of each table. The times go into one histogram
+per kind of operation. Timed operations that are slow, and all
+operations that resized the table, are also reported to a sink that
+the caller may register. Without SYMTABLE_TRACE the hooks below expand
+to nothing, and the counts and histograms stay empty.
+
+A call that a function applied by the table makes back into the same
+table, as from SymTable_map or SymTable_removeIf, is part of the
+outer call: it is not counted or timed on its own. */
+
+/* The kinds of operation that are traced. The "Len" and "Hashed"
+variants of a function count as the function itself, and
+SymTable_getInterned, SymTable_replaceInterned, and
+SymTable_removeInterned count as get, replace, and remove. */
+enum SymTableTraceOp
+{
+    SYMTABLE_TRACE_PUT,
+    SYMTABLE_TRACE_GET,
+    SYMTABLE_TRACE_CONTAINS,
+    SYMTABLE_TRACE_REPLACE,
+    SYMTABLE_TRACE_REMOVE,
+    SYMTABLE_TRACE_PUT_MANY,
+    SYMTABLE_TRACE_GET_MANY,
+    SYMTABLE_TRACE_RESERVE,
+    SYMTABLE_TRACE_MAP,
+    SYMTABLE_TRACE_MAP_PARALLEL,
+    SYMTABLE_TRACE_REMOVE_IF,
+    SYMTABLE_TRACE_ITER_BEGIN,
+    SYMTABLE_TRACE_ITER_NEXT,
+    SYMTABLE_TRACE_ITER_END,
+    SYMTABLE_TRACE_RANGE,
+    SYMTABLE_TRACE_PREFIX,
+    SYMTABLE_TRACE_INTERN,
+    SYMTABLE_TRACE_GET_STATS,
+    SYMTABLE_TRACE_UPSERT,
+    SYMTABLE_TRACE_GET_OR_INSERT,
+    SYMTABLE_TRACE_OP_COUNT
+};
+
+/* What, besides searching, an operation did to the table. */
+enum SymTableTraceCause
+{
+    /* Nothing. */
+    SYMTABLE_TRACE_NO_CAUSE,
+    /* Moved bindings left over from an earlier resize. */
+    SYMTABLE_TRACE_REHASH,
+    /* Gave the table more buckets or slots, or a taller tree. */
+    SYMTABLE_TRACE_EXPAND,
+    /* Gave the table fewer buckets or slots, or a shorter tree. */
+    SYMTABLE_TRACE_SHRINK
+};
+
+/* Each histogram has this many buckets. Bucket i counts operations
+that took at least SymTableTrace_bucketLimit(i - 1) (or 0, for bucket
+0) and less than SymTableTrace_bucketLimit(i) nanoseconds. Below 8
+nanoseconds each bucket is one nanosecond wide; above, each power of
+two is split into 8 buckets, so every bucket is within 12.5% of its
+limit. */
+enum {SYMTABLE_TRACE_BUCKET_COUNT = 496};
+
+/* Unless SymTableTrace_setSamplePeriod says otherwise, each table
+times one operation in this many. */
+enum {SYMTABLE_TRACE_DEFAULT_PERIOD = 256};
+
+/* A SymTableTraceEvent describes one reported operation. */
+struct SymTableTraceEvent
+{
+    /* The table operated on. */
+    SymTable_T oSymTable;
+    /* The kind of operation. */
+    enum SymTableTraceOp eOp;
+    /* The key it was given, or NULL if it takes none. */
+    const char *pcKey;
+    /* The address that the public function doing the operation was
+    called from, or NULL if the compiler cannot tell. addr2line maps
+    it to a file and line of the caller. */
+    const void *pvCaller;
+    /* How long it took. If it was not one of the operations sampled
+    for timing, only the resize is timed. */
+    size_t uNanoseconds;
+    /* The number of bindings (or tree nodes) it examined: the length
+    of the chain it walked. Like uNanoseconds, from the resize on if
+    only the resize is timed. */
+    size_t uProbes;
+    /* What else it did. */
+    enum SymTableTraceCause eCause;
+};
+
+/* A SymTableTrace_Sink receives reported operations. It is called
+from the thread that did the operation, after the operation. */
+typedef void (*SymTableTrace_Sink)(
+    const struct SymTableTraceEvent *psEvent, void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Report to *pfSink, with extra argument pvExtra, every timed
+operation that takes at least uThreshold nanoseconds, and every
+operation that resizes its table. If pfSink is NULL, report nothing.
+Must not be called while another thread is operating on a traced
+table. */
+void SymTableTrace_setSink(SymTableTrace_Sink pfSink,
+    size_t uThreshold, const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Make each table time one operation in uPeriod, starting with its
+first; 1 times them all. Operations are counted whether or not they
+are timed. Must not be called while another thread is operating on a
+traced table. */
+void SymTableTrace_setSamplePeriod(size_t uPeriod);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of operations of kind eOp done so far. Tables add
+their operations to the count each time they time one and when they
+are freed, so the operations since a live table last timed one may be
+missing. */
+size_t SymTableTrace_getCount(enum SymTableTraceOp eOp);
+
+/*--------------------------------------------------------------------*/
+
+/* Store the histogram of timed operations of kind eOp in the
+SYMTABLE_TRACE_BUCKET_COUNT elements of puCounts. Operations that
+finish meanwhile may or may not be included. */
+void SymTableTrace_getHistogram(enum SymTableTraceOp eOp,
+    size_t *puCounts);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of nanoseconds at which histogram bucket uBucket
+ends: the least time that falls in a later bucket. */
+size_t SymTableTrace_bucketLimit(size_t uBucket);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a time, in nanoseconds, that at least the fraction dFraction
+(between 0 and 1) of timed operations of kind eOp took no more than,
+as far as the histogram can tell. Return 0 if none have been
+recorded. */
+size_t SymTableTrace_percentile(enum SymTableTraceOp eOp,
+    double dFraction);
+
+/*--------------------------------------------------------------------*/
+
+/* Empty every histogram and zero every count. */
+void SymTableTrace_reset(void);
+
+/*--------------------------------------------------------------------*/
+
+/* The rest of this file is for SymTable implementations. */
+
+/* The state of the operation in progress on one table. A table
+compiled with SYMTABLE_TRACE holds one, named sTrace, that starts out
+all zero. */
+struct SymTableTrace
+{
+    /* The number of traced calls in progress on the table: more than
+    one while a function the table applies calls back into it. */
+    size_t uDepth;
+    /* Operations to go before the table times one. */
+    size_t uCountdown;
+    /* 1 (TRUE) if the operation in progress is being timed, because
+    it is sampled or has resized the table, or 0 (FALSE) otherwise. */
+    int iTimed;
+    /* If iTimed, 1 (TRUE) if the operation in progress is sampled, or
+    0 (FALSE) if it is timed only from its resize. */
+    int iSampled;
+    /* When timing started. */
+    size_t uStart;
+    /* If iTimed, bindings or nodes examined since timing started. */
+    size_t uProbes;
+    /* If iTimed, what else the operation has done so far. */
+    enum SymTableTraceCause eCause;
+    /* Operations done, by kind, that are not yet in the counts that
+    SymTableTrace_getCount returns. */
+    size_t auUncounted[SYMTABLE_TRACE_OP_COUNT];
+};
+
+/* Start timing the operation with state psTrace, which is sampled. */
+void SymTableTrace_sample(struct SymTableTrace *psTrace);
+
+/* Note that the operation with state psTrace has done eCause, and
+start timing it if that resized the table. A resize is not replaced
+by a later cause of the same operation. */
+void SymTableTrace_cause(struct SymTableTrace *psTrace,
+    enum SymTableTraceCause eCause);
+
+/* Finish timing the operation of kind eOp on key pcKey of oSymTable,
+called from pvCaller, whose state is psTrace: record it if it was
+sampled, and report it if it is slow or resized the table. */
+void SymTableTrace_end(SymTable_T oSymTable,
+    struct SymTableTrace *psTrace, enum SymTableTraceOp eOp,
+    const char *pcKey, const void *pvCaller);
+
+/* Add the operations counted in psTrace to the shared counts. Called
+when the table is freed. */
+void SymTableTrace_flush(struct SymTableTrace *psTrace);
+
+/* The address the function expanding it was called from. */
+#if defined(__GNUC__)
+#define SYMTABLE_TRACE_CALLER __builtin_return_address(0)
+#else
+#define SYMTABLE_TRACE_CALLER NULL
+#endif
+
+/* An operation that is not timed is only counted, inline; nested
+calls cost an increment and a decrement. */
+#ifdef SYMTABLE_TRACE
+#define SYMTABLE_TRACE_BEGIN(oSymTable) \
+    ((oSymTable)->sTrace.uDepth++ == 0 && \
+        (oSymTable)->sTrace.uCountdown-- == 0 ? \
+        SymTableTrace_sample(&(oSymTable)->sTrace) : (void)0)
+#define SYMTABLE_TRACE_END(oSymTable, eOp, pcKey) \
+    (--(oSymTable)->sTrace.uDepth != 0 ? (void)0 : \
+        ((oSymTable)->sTrace.auUncounted[eOp]++, \
+        (oSymTable)->sTrace.iTimed ? \
+            SymTableTrace_end(oSymTable, &(oSymTable)->sTrace, eOp, \
+                pcKey, SYMTABLE_TRACE_CALLER) : (void)0))
+#define SYMTABLE_TRACE_PROBES(oSymTable, uAmount) \
+    ((oSymTable)->sTrace.iTimed ? \
+        (void)((oSymTable)->sTrace.uProbes += (size_t)(uAmount)) : \
+        (void)0)
+#define SYMTABLE_TRACE_CAUSE(oSymTable, eNewCause) \
+    SymTableTrace_cause(&(oSymTable)->sTrace, eNewCause)
+#define SYMTABLE_TRACE_FREE(oSymTable) \
+    SymTableTrace_flush(&(oSymTable)->sTrace)
+#else
+#define SYMTABLE_TRACE_BEGIN(oSymTable) ((void)0)
+#define SYMTABLE_TRACE_END(oSymTable, eOp, pcKey) ((void)0)
+#define SYMTABLE_TRACE_PROBES(oSymTable, uAmount) ((void)0)
+#define SYMTABLE_TRACE_CAUSE(oSymTable, eNewCause) ((void)0)
+#define SYMTABLE_TRACE_FREE(oSymTable) ((void)0)
+#endif
+
+#endif
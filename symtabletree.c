@@ -0,0 +1,1937 @@
+/*--------------------------------------------------------------------*/
+/* symtabletree.c                                                     */
+/* Author: Ryan Donoghue                                              */
+/*--------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "symtable.h"
+#include "arena.h"
+#include "parallel.h"
+#include "symtabletrace.h"
+
+/* Most bindings a leaf holds. Must be even, so that a full leaf
+splits into two leaves that each hold the fewest allowed, half as
+many. */
+enum {LEAF_CAPACITY = 32};
+
+/* Most children a branch has. Must be even, for the same reason. */
+enum {BRANCH_CAPACITY = 32};
+
+/* Number of leaves each task of SymTable_mapParallel visits. */
+static const size_t MAP_TASK_LEAVES = 64;
+
+/* Each key is stored once, in a SymTableKey, and shared by the leaf
+entry of its binding and by any branches that use it as a separator.
+Since no key is ever copied, splitting and rebalancing need no memory
+beyond the nodes themselves. */
+struct SymTableKey
+{
+    /* Number of leaf entries and separators that refer to the key. */
+    size_t uRefCount;
+    /* The number of characters in the key, not counting the null
+    terminator. */
+    size_t uLength;
+    /* The characters of the key. */
+    char acKey[];
+};
+
+/* A binding, as held in a leaf. */
+struct SymTableEntry
+{
+    /* The key of the binding. */
+    struct SymTableKey *psKey;
+    /* The value of the binding. */
+    const void *pvValue;
+};
+
+/* A SymTableLeaf holds bindings in increasing order of key. Leaves
+are linked in the same order, so a range of keys is read leaf after
+leaf without climbing back into the tree. */
+struct SymTableLeaf
+{
+    /* Number of entries in asEntries. */
+    size_t uCount;
+    /* The leaf that follows this one in key order, or NULL. */
+    struct SymTableLeaf *psNextLeaf;
+    /* The bindings, in increasing order of key. */
+    struct SymTableEntry asEntries[LEAF_CAPACITY];
+};
+
+/* A SymTableBranch directs a search to one of its children. Every key
+under child i is at least separator i - 1 and less than separator
+i. */
+struct SymTableBranch
+{
+    /* Number of children in apvChildren. */
+    size_t uCount;
+    /* The separators between adjacent children, in increasing
+    order. */
+    struct SymTableKey *apsSeparators[BRANCH_CAPACITY - 1];
+    /* The children: leaves if the branch is just above the leaves,
+    branches otherwise. */
+    void *apvChildren[BRANCH_CAPACITY];
+};
+
+#ifdef SYMTABLE_STATS
+/* Counts of the operations done on a SymTable, as reported by
+SymTable_getStats. */
+struct SymTableCounters
+{
+    /* Calls that tried to put a binding. */
+    size_t uPuts;
+    /* Lookups by get, contains, and replace, and how many found their
+    key. */
+    size_t uGets;
+    size_t uHits;
+    /* Descents from the root, and nodes they visited. */
+    size_t uSearches;
+    size_t uProbes;
+    /* Splits of the root, each of which made the tree taller. */
+    size_t uExpansions;
+};
+#endif
+
+/* A SymTable in the tree implementation is a B+-tree: all bindings
+are in leaves, every leaf is the same distance from the root, and
+every node but the root is at least half full. Lookups compare keys
+and never hash them. */
+struct SymTable
+{
+    /* The root: a SymTableLeaf if uHeight is 0, otherwise a
+    SymTableBranch. */
+    void *pvRoot;
+    /* Number of levels of branches above the leaves. */
+    size_t uHeight;
+    /* Number of bindings in the symbol table. */
+    size_t uLength;
+    /* The arena that nodes and keys are carved from, or NULL if each
+    is allocated with malloc. */
+    Arena_T oArena;
+#ifdef SYMTABLE_STATS
+    /* Operation counts for SymTable_getStats. */
+    struct SymTableCounters sCounters;
+#endif
+#ifdef SYMTABLE_TRACE
+    /* The operation being traced. */
+    struct SymTableTrace sTrace;
+#endif
+};
+
+/* Add uAmount to the counter uField of oSymTable if operations are
+being counted, and otherwise do nothing at all. */
+#ifdef SYMTABLE_STATS
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) \
+    ((oSymTable)->sCounters.uField += (size_t)(uAmount))
+#else
+#define SYMTABLE_COUNT(oSymTable, uField, uAmount) ((void)0)
+#endif
+
+/* The bounds of a SymTable_range or SymTable_prefix query. */
+struct SymTableBounds
+{
+    /* Every selected key is at least the uLowLength characters at
+    pcLow. */
+    const char *pcLow;
+    size_t uLowLength;
+    /* Every selected key is less than the uHighLength characters at
+    pcHigh, or, if pcHigh is NULL, begins with the characters at
+    pcLow. */
+    const char *pcHigh;
+    size_t uHighLength;
+};
+
+/* Return a block of uSize bytes for oSymTable, or NULL if
+insufficient memory is available. */
+static void *SymTable_alloc(SymTable_T oSymTable, size_t uSize)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->oArena != NULL)
+    {
+        return Arena_alloc(oSymTable->oArena, uSize);
+    }
+    return malloc(uSize);
+}
+
+/* Free pvBlock, a block of uSize bytes that SymTable_alloc returned
+for oSymTable. */
+static void SymTable_release(SymTable_T oSymTable, void *pvBlock,
+    size_t uSize)
+{
+    assert(oSymTable != NULL);
+    assert(pvBlock != NULL);
+
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_release(oSymTable->oArena, pvBlock, uSize);
+        return;
+    }
+    free(pvBlock);
+}
+
+/* Return the number of bytes occupied by a key of uLength
+characters. */
+static size_t SymTable_keySize(size_t uLength)
+{
+    /* +1 at the end marks the null terminator character. */
+    return offsetof(struct SymTableKey, acKey) + uLength + 1;
+}
+
+/* Return a new key of oSymTable, with one reference, that holds the
+uLength characters at pcKey, or NULL if insufficient memory is
+available. */
+static struct SymTableKey *SymTable_newKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableKey *psKey;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psKey = (struct SymTableKey*)SymTable_alloc(oSymTable,
+        SymTable_keySize(uLength));
+    if (psKey == NULL)
+    {
+        return NULL;
+    }
+    psKey->uRefCount = 1;
+    psKey->uLength = uLength;
+    memcpy(psKey->acKey, pcKey, uLength);
+    psKey->acKey[uLength] = '\0';
+    return psKey;
+}
+
+/* Add a reference to psKey, and return psKey. */
+static struct SymTableKey *SymTable_refKey(struct SymTableKey *psKey)
+{
+    assert(psKey != NULL);
+
+    psKey->uRefCount++;
+    return psKey;
+}
+
+/* Drop a reference to psKey, a key of oSymTable, and free it if that
+was the last one. */
+static void SymTable_unrefKey(SymTable_T oSymTable,
+    struct SymTableKey *psKey)
+{
+    assert(oSymTable != NULL);
+    assert(psKey != NULL);
+    assert(psKey->uRefCount > 0);
+
+    if (--psKey->uRefCount == 0)
+    {
+        SymTable_release(oSymTable, psKey,
+            SymTable_keySize(psKey->uLength));
+    }
+}
+
+/* Return a negative number, 0, or a positive number as the uLength1
+characters at pcKey1 come before, are the same as, or come after the
+uLength2 characters at pcKey2. Keys are compared character by
+character as unsigned chars, and a key comes after its own
+prefixes. */
+static int SymTable_compareKeys(const char *pcKey1, size_t uLength1,
+    const char *pcKey2, size_t uLength2)
+{
+    int iResult;
+
+    assert(pcKey1 != NULL);
+    assert(pcKey2 != NULL);
+
+    iResult = memcmp(pcKey1, pcKey2,
+        uLength1 < uLength2 ? uLength1 : uLength2);
+    if (iResult != 0)
+    {
+        return iResult;
+    }
+    if (uLength1 != uLength2)
+    {
+        return uLength1 < uLength2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Compare psKey with the uLength characters at pcKey, as
+SymTable_compareKeys does. A key of oSymTable that SymTable_intern
+returned is recognized by its address wherever it is met. */
+static int SymTable_compareKey(const struct SymTableKey *psKey,
+    const char *pcKey, size_t uLength)
+{
+    assert(psKey != NULL);
+
+    if (pcKey == psKey->acKey && uLength == psKey->uLength)
+    {
+        return 0;
+    }
+    return SymTable_compareKeys(psKey->acKey, psKey->uLength,
+        pcKey, uLength);
+}
+
+/* Return the index of the child of psBranch under which the uLength
+characters at pcKey belong: the number of separators that are not
+greater than the key. */
+static size_t SymTable_childIndex(const struct SymTableBranch *psBranch,
+    const char *pcKey, size_t uLength)
+{
+    size_t uLow = 0;
+    size_t uHigh;
+    size_t uMiddle;
+
+    assert(psBranch != NULL);
+    assert(psBranch->uCount > 0);
+
+    uHigh = psBranch->uCount - 1;
+    while (uLow < uHigh)
+    {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if (SymTable_compareKey(psBranch->apsSeparators[uMiddle],
+            pcKey, uLength) <= 0)
+            uLow = uMiddle + 1;
+        else
+            uHigh = uMiddle;
+    }
+    return uLow;
+}
+
+/* Return the index of the first entry of psLeaf whose key is not less
+than the uLength characters at pcKey, or psLeaf->uCount if there is
+no such entry. */
+static size_t SymTable_entryIndex(const struct SymTableLeaf *psLeaf,
+    const char *pcKey, size_t uLength)
+{
+    size_t uLow = 0;
+    size_t uHigh;
+    size_t uMiddle;
+
+    assert(psLeaf != NULL);
+
+    uHigh = psLeaf->uCount;
+    while (uLow < uHigh)
+    {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if (SymTable_compareKey(psLeaf->asEntries[uMiddle].psKey,
+            pcKey, uLength) < 0)
+            uLow = uMiddle + 1;
+        else
+            uHigh = uMiddle;
+    }
+    return uLow;
+}
+
+/* Return the leaf of oSymTable under which the uLength characters at
+pcKey belong. */
+static struct SymTableLeaf *SymTable_findLeaf(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableBranch *psBranch;
+    void *pvNode;
+    size_t uHeight;
+
+    assert(oSymTable != NULL);
+
+    pvNode = oSymTable->pvRoot;
+    for (uHeight = oSymTable->uHeight; uHeight > 0; uHeight--)
+    {
+        psBranch = (struct SymTableBranch*)pvNode;
+        pvNode = psBranch->apvChildren[
+            SymTable_childIndex(psBranch, pcKey, uLength)];
+    }
+    return (struct SymTableLeaf*)pvNode;
+}
+
+/* Return the leftmost leaf of oSymTable. */
+static struct SymTableLeaf *SymTable_firstLeaf(SymTable_T oSymTable)
+{
+    void *pvNode;
+    size_t uHeight;
+
+    assert(oSymTable != NULL);
+
+    pvNode = oSymTable->pvRoot;
+    for (uHeight = oSymTable->uHeight; uHeight > 0; uHeight--)
+    {
+        pvNode = ((struct SymTableBranch*)pvNode)->apvChildren[0];
+    }
+    return (struct SymTableLeaf*)pvNode;
+}
+
+/* Return the entry of oSymTable whose key is the uLength characters
+at pcKey, or NULL if there is none. */
+static struct SymTableEntry *SymTable_findEntry(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableLeaf *psLeaf;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
+    SYMTABLE_COUNT(oSymTable, uProbes, oSymTable->uHeight + 1);
+    SYMTABLE_TRACE_PROBES(oSymTable, oSymTable->uHeight + 1);
+    psLeaf = SymTable_findLeaf(oSymTable, pcKey, uLength);
+    uIndex = SymTable_entryIndex(psLeaf, pcKey, uLength);
+    if (uIndex < psLeaf->uCount &&
+        SymTable_compareKey(psLeaf->asEntries[uIndex].psKey,
+            pcKey, uLength) == 0)
+    {
+        return &psLeaf->asEntries[uIndex];
+    }
+    return NULL;
+}
+
+/* Return SymTable_findEntry(oSymTable, pcKey, uLength), counting the
+search as a lookup by a get, contains, or replace function. */
+static struct SymTableEntry *SymTable_lookup(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableEntry *psEntry;
+
+    psEntry = SymTable_findEntry(oSymTable, pcKey, uLength);
+    SYMTABLE_COUNT(oSymTable, uGets, 1);
+    SYMTABLE_COUNT(oSymTable, uHits, psEntry != NULL);
+    return psEntry;
+}
+
+/* Return the number of entries or children of pvNode, which is a
+leaf if uHeight is 0 and a branch otherwise. */
+static size_t SymTable_nodeCount(const void *pvNode, size_t uHeight)
+{
+    assert(pvNode != NULL);
+
+    if (uHeight == 0)
+    {
+        return ((const struct SymTableLeaf*)pvNode)->uCount;
+    }
+    return ((const struct SymTableBranch*)pvNode)->uCount;
+}
+
+/* Return the most entries or children that a node of height uHeight
+may have. */
+static size_t SymTable_nodeCapacity(size_t uHeight)
+{
+    return uHeight == 0 ? LEAF_CAPACITY : BRANCH_CAPACITY;
+}
+
+/* Free pvNode, a node of oSymTable of height uHeight, together with
+every node below it and every key they hold. */
+static void SymTable_freeNode(SymTable_T oSymTable, void *pvNode,
+    size_t uHeight)
+{
+    struct SymTableLeaf *psLeaf;
+    struct SymTableBranch *psBranch;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pvNode != NULL);
+
+    if (uHeight == 0)
+    {
+        psLeaf = (struct SymTableLeaf*)pvNode;
+        for (i = 0; i < psLeaf->uCount; i++)
+        {
+            SymTable_unrefKey(oSymTable, psLeaf->asEntries[i].psKey);
+        }
+        SymTable_release(oSymTable, psLeaf,
+            sizeof(struct SymTableLeaf));
+        return;
+    }
+
+    psBranch = (struct SymTableBranch*)pvNode;
+    for (i = 0; i < psBranch->uCount; i++)
+    {
+        SymTable_freeNode(oSymTable, psBranch->apvChildren[i],
+            uHeight - 1);
+    }
+    for (i = 0; i + 1 < psBranch->uCount; i++)
+    {
+        SymTable_unrefKey(oSymTable, psBranch->apsSeparators[i]);
+    }
+    SymTable_release(oSymTable, psBranch,
+        sizeof(struct SymTableBranch));
+}
+
+/* Split child uIndex of psParent, a full node of height uHeight, in
+half, and add the right half to psParent, which must not be full.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+is available, in which case nothing changes. */
+static int SymTable_splitChild(SymTable_T oSymTable,
+    struct SymTableBranch *psParent, size_t uIndex, size_t uHeight)
+{
+    struct SymTableLeaf *psLeaf;
+    struct SymTableLeaf *psNewLeaf;
+    struct SymTableBranch *psBranch;
+    struct SymTableBranch *psNewBranch;
+    struct SymTableKey *psSeparator;
+    void *pvNewChild;
+
+    assert(oSymTable != NULL);
+    assert(psParent != NULL);
+    assert(psParent->uCount < BRANCH_CAPACITY);
+    assert(uIndex < psParent->uCount);
+
+    if (uHeight == 0)
+    {
+        psLeaf = (struct SymTableLeaf*)psParent->apvChildren[uIndex];
+        assert(psLeaf->uCount == LEAF_CAPACITY);
+        psNewLeaf = (struct SymTableLeaf*)SymTable_alloc(oSymTable,
+            sizeof(struct SymTableLeaf));
+        if (psNewLeaf == NULL)
+        {
+            return 0;
+        }
+        memcpy(psNewLeaf->asEntries,
+            &psLeaf->asEntries[LEAF_CAPACITY / 2],
+            LEAF_CAPACITY / 2 * sizeof(struct SymTableEntry));
+        psNewLeaf->uCount = LEAF_CAPACITY / 2;
+        psLeaf->uCount = LEAF_CAPACITY / 2;
+        psNewLeaf->psNextLeaf = psLeaf->psNextLeaf;
+        psLeaf->psNextLeaf = psNewLeaf;
+        psSeparator = SymTable_refKey(psNewLeaf->asEntries[0].psKey);
+        pvNewChild = psNewLeaf;
+    }
+    else
+    {
+        psBranch = (struct SymTableBranch*)
+            psParent->apvChildren[uIndex];
+        assert(psBranch->uCount == BRANCH_CAPACITY);
+        psNewBranch = (struct SymTableBranch*)SymTable_alloc(oSymTable,
+            sizeof(struct SymTableBranch));
+        if (psNewBranch == NULL)
+        {
+            return 0;
+        }
+        /* The middle separator moves up into psParent. */
+        memcpy(psNewBranch->apvChildren,
+            &psBranch->apvChildren[BRANCH_CAPACITY / 2],
+            BRANCH_CAPACITY / 2 * sizeof(void*));
+        memcpy(psNewBranch->apsSeparators,
+            &psBranch->apsSeparators[BRANCH_CAPACITY / 2],
+            (BRANCH_CAPACITY / 2 - 1) * sizeof(struct SymTableKey*));
+        psSeparator = psBranch->apsSeparators[BRANCH_CAPACITY / 2 - 1];
+        psNewBranch->uCount = BRANCH_CAPACITY / 2;
+        psBranch->uCount = BRANCH_CAPACITY / 2;
+        pvNewChild = psNewBranch;
+    }
+
+    memmove(&psParent->apvChildren[uIndex + 2],
+        &psParent->apvChildren[uIndex + 1],
+        (psParent->uCount - uIndex - 1) * sizeof(void*));
+    memmove(&psParent->apsSeparators[uIndex + 1],
+        &psParent->apsSeparators[uIndex],
+        (psParent->uCount - uIndex - 1) * sizeof(struct SymTableKey*));
+    psParent->apvChildren[uIndex + 1] = pvNewChild;
+    psParent->apsSeparators[uIndex] = psSeparator;
+    psParent->uCount++;
+    return 1;
+}
+
+/* Split the root of oSymTable, which must be full, under a new root.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+is available, in which case nothing changes. */
+static int SymTable_splitRoot(SymTable_T oSymTable)
+{
+    struct SymTableBranch *psRoot;
+
+    assert(oSymTable != NULL);
+
+    psRoot = (struct SymTableBranch*)SymTable_alloc(oSymTable,
+        sizeof(struct SymTableBranch));
+    if (psRoot == NULL)
+    {
+        return 0;
+    }
+    psRoot->uCount = 1;
+    psRoot->apvChildren[0] = oSymTable->pvRoot;
+    if (!SymTable_splitChild(oSymTable, psRoot, 0, oSymTable->uHeight))
+    {
+        SymTable_release(oSymTable, psRoot,
+            sizeof(struct SymTableBranch));
+        return 0;
+    }
+    oSymTable->pvRoot = psRoot;
+    oSymTable->uHeight++;
+    SYMTABLE_COUNT(oSymTable, uExpansions, 1);
+    SYMTABLE_TRACE_CAUSE(oSymTable, SYMTABLE_TRACE_EXPAND);
+    return 1;
+}
+
+/* Move the last entry or child of child uIndex of psParent to the
+front of child uIndex + 1. Both children have height uHeight. */
+static void SymTable_moveRight(SymTable_T oSymTable,
+    struct SymTableBranch *psParent, size_t uIndex, size_t uHeight)
+{
+    struct SymTableLeaf *psLeft;
+    struct SymTableLeaf *psRight;
+    struct SymTableBranch *psLeftBranch;
+    struct SymTableBranch *psRightBranch;
+
+    assert(oSymTable != NULL);
+    assert(psParent != NULL);
+    assert(uIndex + 1 < psParent->uCount);
+
+    if (uHeight == 0)
+    {
+        psLeft = (struct SymTableLeaf*)psParent->apvChildren[uIndex];
+        psRight = (struct SymTableLeaf*)
+            psParent->apvChildren[uIndex + 1];
+        memmove(&psRight->asEntries[1], &psRight->asEntries[0],
+            psRight->uCount * sizeof(struct SymTableEntry));
+        psRight->asEntries[0] = psLeft->asEntries[psLeft->uCount - 1];
+        psLeft->uCount--;
+        psRight->uCount++;
+        SymTable_unrefKey(oSymTable, psParent->apsSeparators[uIndex]);
+        psParent->apsSeparators[uIndex] =
+            SymTable_refKey(psRight->asEntries[0].psKey);
+        return;
+    }
+
+    /* The separator in psParent rotates down into the right child,
+    and the left child's last separator rotates up to replace it. */
+    psLeftBranch = (struct SymTableBranch*)
+        psParent->apvChildren[uIndex];
+    psRightBranch = (struct SymTableBranch*)
+        psParent->apvChildren[uIndex + 1];
+    memmove(&psRightBranch->apvChildren[1],
+        &psRightBranch->apvChildren[0],
+        psRightBranch->uCount * sizeof(void*));
+    memmove(&psRightBranch->apsSeparators[1],
+        &psRightBranch->apsSeparators[0],
+        (psRightBranch->uCount - 1) * sizeof(struct SymTableKey*));
+    psRightBranch->apvChildren[0] =
+        psLeftBranch->apvChildren[psLeftBranch->uCount - 1];
+    psRightBranch->apsSeparators[0] = psParent->apsSeparators[uIndex];
+    psParent->apsSeparators[uIndex] =
+        psLeftBranch->apsSeparators[psLeftBranch->uCount - 2];
+    psLeftBranch->uCount--;
+    psRightBranch->uCount++;
+}
+
+/* Move the first entry or child of child uIndex + 1 of psParent to the
+end of child uIndex. Both children have height uHeight. */
+static void SymTable_moveLeft(SymTable_T oSymTable,
+    struct SymTableBranch *psParent, size_t uIndex, size_t uHeight)
+{
+    struct SymTableLeaf *psLeft;
+    struct SymTableLeaf *psRight;
+    struct SymTableBranch *psLeftBranch;
+    struct SymTableBranch *psRightBranch;
+
+    assert(oSymTable != NULL);
+    assert(psParent != NULL);
+    assert(uIndex + 1 < psParent->uCount);
+
+    if (uHeight == 0)
+    {
+        psLeft = (struct SymTableLeaf*)psParent->apvChildren[uIndex];
+        psRight = (struct SymTableLeaf*)
+            psParent->apvChildren[uIndex + 1];
+        psLeft->asEntries[psLeft->uCount] = psRight->asEntries[0];
+        psLeft->uCount++;
+        psRight->uCount--;
+        memmove(&psRight->asEntries[0], &psRight->asEntries[1],
+            psRight->uCount * sizeof(struct SymTableEntry));
+        SymTable_unrefKey(oSymTable, psParent->apsSeparators[uIndex]);
+        psParent->apsSeparators[uIndex] =
+            SymTable_refKey(psRight->asEntries[0].psKey);
+        return;
+    }
+
+    psLeftBranch = (struct SymTableBranch*)
+        psParent->apvChildren[uIndex];
+    psRightBranch = (struct SymTableBranch*)
+        psParent->apvChildren[uIndex + 1];
+    psLeftBranch->apvChildren[psLeftBranch->uCount] =
+        psRightBranch->apvChildren[0];
+    psLeftBranch->apsSeparators[psLeftBranch->uCount - 1] =
+        psParent->apsSeparators[uIndex];
+    psParent->apsSeparators[uIndex] = psRightBranch->apsSeparators[0];
+    memmove(&psRightBranch->apvChildren[0],
+        &psRightBranch->apvChildren[1],
+        (psRightBranch->uCount - 1) * sizeof(void*));
+    memmove(&psRightBranch->apsSeparators[0],
+        &psRightBranch->apsSeparators[1],
+        (psRightBranch->uCount - 2) * sizeof(struct SymTableKey*));
+    psLeftBranch->uCount++;
+    psRightBranch->uCount--;
+}
+
+/* Merge child uIndex + 1 of psParent into child uIndex, and free it.
+Both children have height uHeight, and together they must fit in one
+node. */
+static void SymTable_merge(SymTable_T oSymTable,
+    struct SymTableBranch *psParent, size_t uIndex, size_t uHeight)
+{
+    struct SymTableLeaf *psLeft;
+    struct SymTableLeaf *psRight;
+    struct SymTableBranch *psLeftBranch;
+    struct SymTableBranch *psRightBranch;
+
+    assert(oSymTable != NULL);
+    assert(psParent != NULL);
+    assert(uIndex + 1 < psParent->uCount);
+
+    if (uHeight == 0)
+    {
+        psLeft = (struct SymTableLeaf*)psParent->apvChildren[uIndex];
+        psRight = (struct SymTableLeaf*)
+            psParent->apvChildren[uIndex + 1];
+        assert(psLeft->uCount + psRight->uCount <= LEAF_CAPACITY);
+        memcpy(&psLeft->asEntries[psLeft->uCount], psRight->asEntries,
+            psRight->uCount * sizeof(struct SymTableEntry));
+        psLeft->uCount += psRight->uCount;
+        psLeft->psNextLeaf = psRight->psNextLeaf;
+        SymTable_unrefKey(oSymTable, psParent->apsSeparators[uIndex]);
+        SymTable_release(oSymTable, psRight,
+            sizeof(struct SymTableLeaf));
+    }
+    else
+    {
+        /* The separator between the children moves down between
+        their children. */
+        psLeftBranch = (struct SymTableBranch*)
+            psParent->apvChildren[uIndex];
+        psRightBranch = (struct SymTableBranch*)
+            psParent->apvChildren[uIndex + 1];
+        assert(psLeftBranch->uCount + psRightBranch->uCount
+            <= BRANCH_CAPACITY);
+        psLeftBranch->apsSeparators[psLeftBranch->uCount - 1] =
+            psParent->apsSeparators[uIndex];
+        memcpy(&psLeftBranch->apsSeparators[psLeftBranch->uCount],
+            psRightBranch->apsSeparators,
+            (psRightBranch->uCount - 1) * sizeof(struct SymTableKey*));
+        memcpy(&psLeftBranch->apvChildren[psLeftBranch->uCount],
+            psRightBranch->apvChildren,
+            psRightBranch->uCount * sizeof(void*));
+        psLeftBranch->uCount += psRightBranch->uCount;
+        SymTable_release(oSymTable, psRightBranch,
+            sizeof(struct SymTableBranch));
+    }
+
+    memmove(&psParent->apsSeparators[uIndex],
+        &psParent->apsSeparators[uIndex + 1],
+        (psParent->uCount - uIndex - 2) * sizeof(struct SymTableKey*));
+    memmove(&psParent->apvChildren[uIndex + 1],
+        &psParent->apvChildren[uIndex + 2],
+        (psParent->uCount - uIndex - 2) * sizeof(void*));
+    psParent->uCount--;
+}
+
+/* Child uIndex of psParent, a node of height uHeight, has the fewest
+entries or children allowed. Give it one more, either from a sibling
+that can spare one or by merging it with a sibling. psParent must have
+a child to spare, unless it is the root. */
+static void SymTable_fillChild(SymTable_T oSymTable,
+    struct SymTableBranch *psParent, size_t uIndex, size_t uHeight)
+{
+    size_t uMinimum;
+
+    assert(oSymTable != NULL);
+    assert(psParent != NULL);
+    assert(psParent->uCount > 1);
+
+    uMinimum = SymTable_nodeCapacity(uHeight) / 2;
+    if (uIndex > 0 && SymTable_nodeCount(
+        psParent->apvChildren[uIndex - 1], uHeight) > uMinimum)
+        SymTable_moveRight(oSymTable, psParent, uIndex - 1, uHeight);
+    else if (uIndex + 1 < psParent->uCount && SymTable_nodeCount(
+        psParent->apvChildren[uIndex + 1], uHeight) > uMinimum)
+        SymTable_moveLeft(oSymTable, psParent, uIndex, uHeight);
+    else if (uIndex + 1 < psParent->uCount)
+        SymTable_merge(oSymTable, psParent, uIndex, uHeight);
+    else
+        SymTable_merge(oSymTable, psParent, uIndex - 1, uHeight);
+}
+
+/* Apply *pfApply, passing pvExtra, to each binding of oSymTable within
+psBounds, in increasing order of key. */
+static void SymTable_applyRange(SymTable_T oSymTable,
+    const struct SymTableBounds *psBounds,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableLeaf *psLeaf;
+    struct SymTableEntry *psEntry;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(psBounds != NULL);
+    assert(pfApply != NULL);
+
+    psLeaf = SymTable_findLeaf(oSymTable, psBounds->pcLow,
+        psBounds->uLowLength);
+    uIndex = SymTable_entryIndex(psLeaf, psBounds->pcLow,
+        psBounds->uLowLength);
+    for (;;)
+    {
+        if (uIndex == psLeaf->uCount)
+        {
+            psLeaf = psLeaf->psNextLeaf;
+            if (psLeaf == NULL)
+                return;
+            uIndex = 0;
+            continue;
+        }
+        psEntry = &psLeaf->asEntries[uIndex];
+        if (psBounds->pcHigh == NULL)
+        {
+            if (psEntry->psKey->uLength < psBounds->uLowLength ||
+                memcmp(psEntry->psKey->acKey, psBounds->pcLow,
+                    psBounds->uLowLength) != 0)
+                return;
+        }
+        else if (SymTable_compareKey(psEntry->psKey, psBounds->pcHigh,
+            psBounds->uHighLength) >= 0)
+            return;
+        (*pfApply) (psEntry->psKey->acKey, (void*)psEntry->pvValue,
+            (void*)pvExtra);
+        uIndex++;
+    }
+}
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+    struct SymTableLeaf *psLeaf;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+    psLeaf = (struct SymTableLeaf*)malloc(sizeof(struct SymTableLeaf));
+    if (psLeaf == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+    psLeaf->uCount = 0;
+    psLeaf->psNextLeaf = NULL;
+    oSymTable->pvRoot = psLeaf;
+    oSymTable->uHeight = 0;
+    oSymTable->uLength = 0;
+    oSymTable->oArena = NULL;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+#endif
+#ifdef SYMTABLE_TRACE
+    memset(&oSymTable->sTrace, 0, sizeof(oSymTable->sTrace));
+#endif
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    /* A tree grows a node at a time, so there is nothing to size. */
+    (void)uCapacity;
+
+    return SymTable_new();
+}
+
+SymTable_T SymTable_newArena(void)
+{
+    SymTable_T oSymTable;
+    struct SymTableLeaf *psLeaf;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+    oSymTable->oArena = Arena_new();
+    if (oSymTable->oArena == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+    psLeaf = (struct SymTableLeaf*)Arena_alloc(oSymTable->oArena,
+        sizeof(struct SymTableLeaf));
+    if (psLeaf == NULL)
+    {
+        Arena_free(oSymTable->oArena);
+        free(oSymTable);
+        return NULL;
+    }
+    psLeaf->uCount = 0;
+    psLeaf->psNextLeaf = NULL;
+    oSymTable->pvRoot = psLeaf;
+    oSymTable->uHeight = 0;
+    oSymTable->uLength = 0;
+#ifdef SYMTABLE_STATS
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+#endif
+#ifdef SYMTABLE_TRACE
+    memset(&oSymTable->sTrace, 0, sizeof(oSymTable->sTrace));
+#endif
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash)
+{
+    /* A tree finds bindings by comparing keys, not by hashing. */
+    assert(pfHash != NULL);
+    (void)pfHash;
+
+    return SymTable_new();
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_FREE(oSymTable);
+    /* Arena nodes and keys are released together with their
+    slabs. */
+    if (oSymTable->oArena != NULL)
+    {
+        Arena_free(oSymTable->oArena);
+        free(oSymTable);
+        return;
+    }
+    SymTable_freeNode(oSymTable, oSymTable->pvRoot, oSymTable->uHeight);
+    free(oSymTable);
+}
+
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+    /* A tree never hashes, so any hash code will do. */
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)oSymTable;
+    (void)pcKey;
+
+    return 0;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+    (void)oSymTable;
+    (void)uCapacity;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RESERVE, NULL);
+    return 1;
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    return oSymTable->uLength;
+}
+
+/* Return the leaf entry of the binding in oSymTable whose key is the
+uLength characters at pcKey, first putting a binding of that key and
+pvValue if there is none. Set *piAdded to 1 (TRUE) if a binding was
+put, or 0 (FALSE) otherwise. Return NULL if insufficient memory is
+available. */
+static struct SymTableEntry *SymTable_findOrAdd(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue,
+    int *piAdded)
+{
+    struct SymTableBranch *psBranch;
+    struct SymTableLeaf *psLeaf;
+    struct SymTableKey *psKey;
+    void *pvNode;
+    size_t uHeight;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piAdded != NULL);
+
+    SYMTABLE_COUNT(oSymTable, uPuts, 1);
+    *piAdded = 0;
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
+    SYMTABLE_COUNT(oSymTable, uProbes, oSymTable->uHeight + 1);
+    SYMTABLE_TRACE_PROBES(oSymTable, oSymTable->uHeight + 1);
+
+    /* Full nodes are split on the way down, so a split below always
+    has room in its parent. A split changes no bindings, so running
+    out of memory part of the way down leaves the table as it was. */
+    if (SymTable_nodeCount(oSymTable->pvRoot, oSymTable->uHeight)
+        == SymTable_nodeCapacity(oSymTable->uHeight))
+    {
+        if (!SymTable_splitRoot(oSymTable))
+        {
+            return NULL;
+        }
+    }
+    pvNode = oSymTable->pvRoot;
+    for (uHeight = oSymTable->uHeight; uHeight > 0; uHeight--)
+    {
+        psBranch = (struct SymTableBranch*)pvNode;
+        uIndex = SymTable_childIndex(psBranch, pcKey, uLength);
+        if (SymTable_nodeCount(psBranch->apvChildren[uIndex],
+            uHeight - 1) == SymTable_nodeCapacity(uHeight - 1))
+        {
+            if (!SymTable_splitChild(oSymTable, psBranch, uIndex,
+                uHeight - 1))
+            {
+                return NULL;
+            }
+            if (SymTable_compareKey(psBranch->apsSeparators[uIndex],
+                pcKey, uLength) <= 0)
+            {
+                uIndex++;
+            }
+        }
+        pvNode = psBranch->apvChildren[uIndex];
+    }
+
+    psLeaf = (struct SymTableLeaf*)pvNode;
+    uIndex = SymTable_entryIndex(psLeaf, pcKey, uLength);
+    if (uIndex < psLeaf->uCount &&
+        SymTable_compareKey(psLeaf->asEntries[uIndex].psKey,
+            pcKey, uLength) == 0)
+    {
+        return &psLeaf->asEntries[uIndex];
+    }
+    psKey = SymTable_newKey(oSymTable, pcKey, uLength);
+    if (psKey == NULL)
+    {
+        return NULL;
+    }
+    memmove(&psLeaf->asEntries[uIndex + 1], &psLeaf->asEntries[uIndex],
+        (psLeaf->uCount - uIndex) * sizeof(struct SymTableEntry));
+    psLeaf->asEntries[uIndex].psKey = psKey;
+    psLeaf->asEntries[uIndex].pvValue = pvValue;
+    psLeaf->uCount++;
+    oSymTable->uLength++;
+    *piAdded = 1;
+    return &psLeaf->asEntries[uIndex];
+}
+
+/* Do the work of SymTable_putLen, which traces it. */
+static int SymTable_putUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    int iAdded;
+
+    return SymTable_findOrAdd(oSymTable, pcKey, uLength, pvValue,
+        &iAdded) != NULL && iAdded;
+}
+
+int SymTable_putLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, uLength,
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, strlen(pcKey),
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iSuccessful = SymTable_putUntraced(oSymTable, pcKey, strlen(pcKey),
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT, pcKey);
+    return iSuccessful;
+}
+
+size_t SymTable_putMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues,
+    size_t uCount)
+{
+    size_t uAdded = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* A tree never resizes, so there is nothing to size first. */
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        if (SymTable_putUntraced(oSymTable, ppcKeys[i],
+            strlen(ppcKeys[i]), ppvValues[i]))
+        {
+            uAdded++;
+        }
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PUT_MANY, NULL);
+    return uAdded;
+}
+
+/* Do the work of SymTable_replaceLen, which traces it. */
+static void *SymTable_replaceUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    struct SymTableEntry *psEntry;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_lookup(oSymTable, pcKey, uLength);
+    if (psEntry == NULL)
+    {
+        return NULL;
+    }
+    pvOldValue = psEntry->pvValue;
+    psEntry->pvValue = pvValue;
+    return (void*)pvOldValue;
+}
+
+void *SymTable_replaceLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey, uLength,
+        pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey,
+        strlen(pcKey), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_replaceHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey,
+        strlen(pcKey), pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+/* Do the work of SymTable_containsLen, which traces it. */
+static int SymTable_containsUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_lookup(oSymTable, pcKey, uLength) != NULL;
+}
+
+int SymTable_containsLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    iFound = SymTable_containsUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return iFound;
+}
+
+/* Do the work of SymTable_getLen, which traces it. */
+static void *SymTable_getUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableEntry *psEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_lookup(oSymTable, pcKey, uLength);
+    if (psEntry == NULL)
+    {
+        return NULL;
+    }
+    return (void*)psEntry->pvValue;
+}
+
+void *SymTable_getLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey, strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void SymTable_getMany(SymTable_T oSymTable,
+    const char *const *ppcKeys, size_t uCount, void **ppvValues)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Each step of a descent depends on the last comparison, so
+    there is no address to prefetch ahead of time. */
+    for (i = 0; i < uCount; i++)
+    {
+        assert(ppcKeys[i] != NULL);
+        ppvValues[i] = SymTable_getUntraced(oSymTable, ppcKeys[i],
+            strlen(ppcKeys[i]));
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_MANY, NULL);
+}
+
+/* Do the work of SymTable_removeLen, which traces it. */
+static void *SymTable_removeUntraced(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    struct SymTableBranch *psBranch;
+    struct SymTableLeaf *psLeaf;
+    const void *pvValue;
+    void *pvNode;
+    size_t uHeight;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_COUNT(oSymTable, uSearches, 1);
+    SYMTABLE_COUNT(oSymTable, uProbes, oSymTable->uHeight + 1);
+    SYMTABLE_TRACE_PROBES(oSymTable, oSymTable->uHeight + 1);
+
+    /* Nodes at the minimum are filled on the way down, so the leaf
+    can lose an entry and no node above it needs fixing afterward.
+    Filling never allocates, so removal cannot fail. */
+    pvNode = oSymTable->pvRoot;
+    for (uHeight = oSymTable->uHeight; uHeight > 0; uHeight--)
+    {
+        psBranch = (struct SymTableBranch*)pvNode;
+        uIndex = SymTable_childIndex(psBranch, pcKey, uLength);
+        if (SymTable_nodeCount(psBranch->apvChildren[uIndex],
+            uHeight - 1) == SymTable_nodeCapacity(uHeight - 1) / 2)
+        {
+            SymTable_fillChild(oSymTable, psBranch, uIndex,
+                uHeight - 1);
+            uIndex = SymTable_childIndex(psBranch, pcKey, uLength);
+        }
+        pvNode = psBranch->apvChildren[uIndex];
+    }
+
+    /* A merge just below the root may have left it one child. */
+    while (oSymTable->uHeight > 0 &&
+        ((struct SymTableBranch*)oSymTable->pvRoot)->uCount == 1)
+    {
+        psBranch = (struct SymTableBranch*)oSymTable->pvRoot;
+        oSymTable->pvRoot = psBranch->apvChildren[0];
+        oSymTable->uHeight--;
+        SYMTABLE_TRACE_CAUSE(oSymTable, SYMTABLE_TRACE_SHRINK);
+        SymTable_release(oSymTable, psBranch,
+            sizeof(struct SymTableBranch));
+    }
+
+    psLeaf = (struct SymTableLeaf*)pvNode;
+    uIndex = SymTable_entryIndex(psLeaf, pcKey, uLength);
+    if (uIndex == psLeaf->uCount ||
+        SymTable_compareKey(psLeaf->asEntries[uIndex].psKey,
+            pcKey, uLength) != 0)
+    {
+        return NULL;
+    }
+    pvValue = psLeaf->asEntries[uIndex].pvValue;
+    SymTable_unrefKey(oSymTable, psLeaf->asEntries[uIndex].psKey);
+    psLeaf->uCount--;
+    memmove(&psLeaf->asEntries[uIndex], &psLeaf->asEntries[uIndex + 1],
+        (psLeaf->uCount - uIndex) * sizeof(struct SymTableEntry));
+    oSymTable->uLength--;
+    return (void*)pvValue;
+}
+
+void *SymTable_removeLen(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey, uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    (void)uHash;
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey,
+        strlen(pcKey));
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey);
+    return pvRemovedValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableLeaf *psLeaf;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    for (psLeaf = SymTable_firstLeaf(oSymTable); psLeaf != NULL;
+        psLeaf = psLeaf->psNextLeaf)
+    {
+        for (i = 0; i < psLeaf->uCount; i++)
+        {
+            (*pfApply) (psLeaf->asEntries[i].psKey->acKey,
+                (void*)psLeaf->asEntries[i].pvValue, (void*)pvExtra);
+        }
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP, NULL);
+}
+
+/* The state of one call of SymTable_mapParallel. Task i covers the
+MAP_TASK_LEAVES leaves starting at segment i. */
+struct SymTableMapRun
+{
+    /* The first leaf of each segment. */
+    struct SymTableLeaf **ppsSegments;
+    /* The function to apply to each binding. */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* The extra parameter of each worker. */
+    void *const *ppvExtras;
+};
+
+/* Apply the function of pvRun, a struct SymTableMapRun, to the
+bindings in segment uTask, passing the extra parameter of worker
+uWorker. */
+static void SymTable_mapTask(void *pvRun, size_t uTask, size_t uWorker)
+{
+    struct SymTableMapRun *psRun = (struct SymTableMapRun*)pvRun;
+    struct SymTableLeaf *psLeaf;
+    size_t uLeaves;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    for (psLeaf = psRun->ppsSegments[uTask], uLeaves = 0;
+        psLeaf != NULL && uLeaves < MAP_TASK_LEAVES;
+        psLeaf = psLeaf->psNextLeaf, uLeaves++)
+    {
+        for (i = 0; i < psLeaf->uCount; i++)
+        {
+            (*psRun->pfApply) (psLeaf->asEntries[i].psKey->acKey,
+                (void*)psLeaf->asEntries[i].pvValue,
+                psRun->ppvExtras[uWorker]);
+        }
+    }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *const *ppvExtras, size_t uWorkerCount)
+{
+    struct SymTableMapRun sRun;
+    struct SymTableLeaf *psLeaf;
+    size_t uMaxSegments;
+    size_t uSegmentCount = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(ppvExtras != NULL);
+    assert(uWorkerCount > 0);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Every leaf but the root is at least half full, which bounds
+    the number of leaves. One pass along the leaves finds where each
+    segment starts. */
+    uMaxSegments = (oSymTable->uLength / (LEAF_CAPACITY / 2) + 1)
+        / MAP_TASK_LEAVES + 1;
+    sRun.ppsSegments = (struct SymTableLeaf**)
+        malloc(uMaxSegments * sizeof(struct SymTableLeaf*));
+    if (sRun.ppsSegments == NULL)
+    {
+        SymTable_map(oSymTable, pfApply, ppvExtras[0]);
+        SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL,
+            NULL);
+        return;
+    }
+    for (psLeaf = SymTable_firstLeaf(oSymTable), i = 0; psLeaf != NULL;
+        psLeaf = psLeaf->psNextLeaf, i++)
+    {
+        if (i % MAP_TASK_LEAVES == 0)
+        {
+            assert(uSegmentCount < uMaxSegments);
+            sRun.ppsSegments[uSegmentCount++] = psLeaf;
+        }
+    }
+    sRun.pfApply = pfApply;
+    sRun.ppvExtras = ppvExtras;
+
+    Parallel_run(uSegmentCount, uWorkerCount, SymTable_mapTask, &sRun);
+    free(sRun.ppsSegments);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_MAP_PARALLEL, NULL);
+}
+
+int SymTable_range(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+
+    assert(oSymTable != NULL);
+    assert(pcLow != NULL);
+    assert(pcHigh != NULL);
+    assert(pfApply != NULL);
+
+    sBounds.pcLow = pcLow;
+    sBounds.uLowLength = strlen(pcLow);
+    sBounds.pcHigh = pcHigh;
+    sBounds.uHighLength = strlen(pcHigh);
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SymTable_applyRange(oSymTable, &sBounds, pfApply, pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_RANGE, pcLow);
+    return 1;
+}
+
+int SymTable_prefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableBounds sBounds;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    /* Keys that begin with pcPrefix are not less than it, and come
+    one after another in key order. */
+    sBounds.pcLow = pcPrefix;
+    sBounds.uLowLength = strlen(pcPrefix);
+    sBounds.pcHigh = NULL;
+    sBounds.uHighLength = 0;
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    SymTable_applyRange(oSymTable, &sBounds, pfApply, pvExtra);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_PREFIX, pcPrefix);
+    return 1;
+}
+
+/* A SymTableIter walks the bindings of its table in increasing order
+of key. After each step it keeps a copy of the key it returned, and
+the next step looks up the first key after that one. */
+struct SymTableIter
+{
+    /* The table being walked. */
+    SymTable_T oSymTable;
+    /* 1 (TRUE) once a binding has been returned, 0 (FALSE) before. */
+    int iStarted;
+    /* A copy of the key of the last binding returned, not null
+    terminated, or NULL if none has been returned. */
+    char *pcLastKey;
+    /* The number of characters in pcLastKey. */
+    size_t uLastLength;
+    /* The number of bytes allocated for pcLastKey. */
+    size_t uKeyCapacity;
+};
+
+/* Record psKey as the key of the last binding oIter returned. Return
+1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available to copy it. */
+static int SymTable_iterRemember(SymTableIter_T oIter,
+    const struct SymTableKey *psKey)
+{
+    char *pcNewKey;
+
+    assert(oIter != NULL);
+    assert(psKey != NULL);
+
+    /* +1 so that even an empty key gets a buffer. */
+    if (psKey->uLength + 1 > oIter->uKeyCapacity)
+    {
+        pcNewKey = (char*)realloc(oIter->pcLastKey, psKey->uLength + 1);
+        if (pcNewKey == NULL)
+        {
+            return 0;
+        }
+        oIter->pcLastKey = pcNewKey;
+        oIter->uKeyCapacity = psKey->uLength + 1;
+    }
+    memcpy(oIter->pcLastKey, psKey->acKey, psKey->uLength);
+    oIter->uLastLength = psKey->uLength;
+    oIter->iStarted = 1;
+    return 1;
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    oIter = (SymTableIter_T)malloc(sizeof(struct SymTableIter));
+    if (oIter != NULL)
+    {
+        oIter->oSymTable = oSymTable;
+        oIter->iStarted = 0;
+        oIter->pcLastKey = NULL;
+        oIter->uLastLength = 0;
+        oIter->uKeyCapacity = 0;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_ITER_BEGIN, NULL);
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    struct SymTableLeaf *psLeaf;
+    struct SymTableEntry *psEntry;
+    size_t uIndex = 0;
+    int iFound = 0;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oIter->oSymTable);
+    if (!oIter->iStarted)
+    {
+        psLeaf = SymTable_firstLeaf(oIter->oSymTable);
+    }
+    else
+    {
+        psLeaf = SymTable_findLeaf(oIter->oSymTable, oIter->pcLastKey,
+            oIter->uLastLength);
+        uIndex = SymTable_entryIndex(psLeaf, oIter->pcLastKey,
+            oIter->uLastLength);
+        if (uIndex < psLeaf->uCount &&
+            SymTable_compareKey(psLeaf->asEntries[uIndex].psKey,
+                oIter->pcLastKey, oIter->uLastLength) == 0)
+        {
+            uIndex++;
+        }
+    }
+    while (psLeaf != NULL && uIndex == psLeaf->uCount)
+    {
+        psLeaf = psLeaf->psNextLeaf;
+        uIndex = 0;
+    }
+
+    if (psLeaf != NULL)
+    {
+        psEntry = &psLeaf->asEntries[uIndex];
+        if (SymTable_iterRemember(oIter, psEntry->psKey))
+        {
+            *ppcKey = psEntry->psKey->acKey;
+            *ppvValue = (void*)psEntry->pvValue;
+            iFound = 1;
+        }
+    }
+    SYMTABLE_TRACE_END(oIter->oSymTable, SYMTABLE_TRACE_ITER_NEXT,
+        NULL);
+    return iFound;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    assert(oIter != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oIter->oSymTable);
+    free(oIter->pcLastKey);
+    SYMTABLE_TRACE_END(oIter->oSymTable, SYMTABLE_TRACE_ITER_END, NULL);
+    free(oIter);
+}
+
+/* Return the key of a SymTable whose characters are at pcKey, a
+pointer that SymTable_intern returned. */
+static const struct SymTableKey *SymTable_internedKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return (const struct SymTableKey*)(const void*)
+        (pcKey - offsetof(struct SymTableKey, acKey));
+}
+
+const char *SymTable_intern(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableEntry *psEntry;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psEntry = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), NULL,
+        &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_INTERN, pcKey);
+    if (psEntry == NULL)
+    {
+        return NULL;
+    }
+    return psEntry->psKey->acKey;
+}
+
+/* Bindings are ordered by key, so the interned functions below still
+descend the tree comparing keys. The stored length spares a strlen,
+and SymTable_compareKey returns at once when it meets the interned key
+itself. */
+
+void *SymTable_getInterned(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvValue = SymTable_getUntraced(oSymTable, pcKey,
+        SymTable_internedKey(pcKey)->uLength);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET, pcKey);
+    return pvValue;
+}
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    void *pvOldValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvOldValue = SymTable_replaceUntraced(oSymTable, pcKey,
+        SymTable_internedKey(pcKey)->uLength, pvValue);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey);
+    return pvOldValue;
+}
+
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    const char *pcKey)
+{
+    void *pvRemovedValue;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    pvRemovedValue = SymTable_removeUntraced(oSymTable, pcKey,
+        SymTable_internedKey(pcKey)->uLength);
+    /* The key may have gone with the binding. */
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE, NULL);
+    return pvRemovedValue;
+}
+
+/* Add the bytes taken by pvNode, a node of height uHeight, and by
+everything below it to *psStats. Keys are counted once, at their
+leaf entries, though separators share them. */
+static void SymTable_addNodeBytes(const void *pvNode, size_t uHeight,
+    struct SymTableStats *psStats)
+{
+    const struct SymTableBranch *psBranch;
+    const struct SymTableLeaf *psLeaf;
+    size_t i;
+
+    assert(pvNode != NULL);
+    assert(psStats != NULL);
+
+    if (uHeight == 0)
+    {
+        psLeaf = (const struct SymTableLeaf*)pvNode;
+        psStats->uNodeBytes += sizeof(struct SymTableLeaf);
+        for (i = 0; i < psLeaf->uCount; i++)
+        {
+            psStats->uKeyBytes +=
+                SymTable_keySize(psLeaf->asEntries[i].psKey->uLength);
+        }
+        return;
+    }
+    psBranch = (const struct SymTableBranch*)pvNode;
+    psStats->uNodeBytes += sizeof(struct SymTableBranch);
+    for (i = 0; i < psBranch->uCount; i++)
+    {
+        SymTable_addNodeBytes(psBranch->apvChildren[i], uHeight - 1,
+            psStats);
+    }
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* A tree has no buckets, so the histogram stays empty. */
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uLength = oSymTable->uLength;
+    SymTable_addNodeBytes(oSymTable->pvRoot, oSymTable->uHeight,
+        psStats);
+
+#ifdef SYMTABLE_STATS
+    psStats->uPuts = oSymTable->sCounters.uPuts;
+    psStats->uGets = oSymTable->sCounters.uGets;
+    psStats->uHits = oSymTable->sCounters.uHits;
+    psStats->uMisses =
+        oSymTable->sCounters.uGets - oSymTable->sCounters.uHits;
+    psStats->uExpansions = oSymTable->sCounters.uExpansions;
+    if (oSymTable->sCounters.uSearches > 0)
+    {
+        psStats->dProbesPerLookup =
+            (double)oSymTable->sCounters.uProbes /
+            (double)oSymTable->sCounters.uSearches;
+    }
+#endif
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_STATS, NULL);
+}
+
+void SymTable_setOrder(SymTable_T oSymTable,
+    enum SymTableOrder eOrder)
+{
+    assert(oSymTable != NULL);
+
+    /* A tree keeps its keys sorted, so there is nothing to reorder. */
+    (void)oSymTable;
+    (void)eOrder;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue)
+{
+    struct SymTableEntry *psEntry;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psEntry = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey),
+        pvValue, &iAdded);
+    if (psEntry != NULL)
+    {
+        if (ppvOldValue != NULL)
+        {
+            *ppvOldValue = iAdded ? NULL : (void*)psEntry->pvValue;
+        }
+        psEntry->pvValue = pvValue;
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_UPSERT, pcKey);
+    return psEntry != NULL;
+}
+
+void **SymTable_getOrInsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue)
+{
+    struct SymTableEntry *psEntry;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    psEntry = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey),
+        pvValue, &iAdded);
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_GET_OR_INSERT,
+        pcKey);
+    return psEntry == NULL ? NULL : (void**)&psEntry->pvValue;
+}
+
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfPredicate)(const char *pcKey, void *pvValue,
+        void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableLeaf *psLeaf;
+    struct SymTableKey *psKey;
+    void *pvValue;
+    size_t uIndex = 0;
+    size_t uRemoved = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfPredicate != NULL);
+
+    SYMTABLE_TRACE_BEGIN(oSymTable);
+    /* Walk the leaves in key order. A leaf above the minimum size
+    loses its binding in place, as SymTable_removeUntraced would do;
+    a leaf at the minimum goes through SymTable_removeUntraced, which
+    keeps the tree balanced, and the walk resumes at the first key
+    after the one removed. */
+    psLeaf = SymTable_firstLeaf(oSymTable);
+    while (psLeaf != NULL)
+    {
+        if (uIndex == psLeaf->uCount)
+        {
+            psLeaf = psLeaf->psNextLeaf;
+            uIndex = 0;
+            continue;
+        }
+        psKey = psLeaf->asEntries[uIndex].psKey;
+        if (!(*pfPredicate)(psKey->acKey,
+            (void*)psLeaf->asEntries[uIndex].pvValue, (void*)pvExtra))
+        {
+            uIndex++;
+            continue;
+        }
+
+        if (psLeaf->uCount > LEAF_CAPACITY / 2)
+        {
+            pvValue = (void*)psLeaf->asEntries[uIndex].pvValue;
+            if (pfRemoved != NULL)
+            {
+                (*pfRemoved)(psKey->acKey, pvValue, (void*)pvExtra);
+            }
+            SymTable_unrefKey(oSymTable, psKey);
+            psLeaf->uCount--;
+            memmove(&psLeaf->asEntries[uIndex],
+                &psLeaf->asEntries[uIndex + 1],
+                (psLeaf->uCount - uIndex) *
+                sizeof(struct SymTableEntry));
+            oSymTable->uLength--;
+            uRemoved++;
+            continue;
+        }
+
+        /* Hold the key so that it outlives its binding. */
+        (void)SymTable_refKey(psKey);
+        pvValue = SymTable_removeUntraced(oSymTable, psKey->acKey,
+            psKey->uLength);
+        if (pfRemoved != NULL)
+        {
+            (*pfRemoved)(psKey->acKey, pvValue, (void*)pvExtra);
+        }
+        uRemoved++;
+
+        psLeaf = SymTable_findLeaf(oSymTable, psKey->acKey,
+            psKey->uLength);
+        uIndex = SymTable_entryIndex(psLeaf, psKey->acKey,
+            psKey->uLength);
+        SymTable_unrefKey(oSymTable, psKey);
+    }
+    SYMTABLE_TRACE_END(oSymTable, SYMTABLE_TRACE_REMOVE_IF, NULL);
+    return uRemoved;
+}
@@ -4,11 +4,17 @@
 /*--------------------------------------------------------------------*/
 
 #include "symtable.h"
+#include "strhash.h"
+#include "concsymtable.h"
+#include "rcusymtable.h"
+#include "symtableimage.h"
+#include "symtabletrace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
 #ifndef S_SPLINT_S
 #include <sys/resource.h>
@@ -776,6 +782,2349 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test a SymTable object whose bindings come from an arena, including
+   reuse of the memory of removed bindings and keys too long to be
+   carved from a slab. */
+
+static void testArena(void)
+{
+   enum {BINDING_COUNT = 1000, MAX_KEY_LENGTH = 10};
+   enum {LONG_KEY_SIZE = 1000};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acLongKey[LONG_KEY_SIZE];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   int iSuccessful;
+   int iFound;
+   int i;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object created by\n");
+   printf("SymTable_newArena().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < LONG_KEY_SIZE - 1; i++)
+      acLongKey[i] = 'a';
+   acLongKey[LONG_KEY_SIZE - 1] = '\0';
+
+   oSymTable = SymTable_newArena();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, acLongKey, acCenterField);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == BINDING_COUNT + 1);
+
+   /* Remove every other binding, then put them back so that their
+      memory is reused. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+   pcValue = (char*)SymTable_remove(oSymTable, acLongKey);
+   ASSURE(pcValue == acCenterField);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == BINDING_COUNT / 2);
+
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      iFound = SymTable_contains(oSymTable, acKey);
+      ASSURE(! iFound);
+      iSuccessful = SymTable_put(oSymTable, acKey, acCenterField);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, acLongKey, acShortstop);
+   ASSURE(iSuccessful);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      if (i % 2 == 0)
+         ASSURE(pcValue == acCenterField);
+      else
+         ASSURE(pcValue == acShortstop);
+   }
+   pcValue = (char*)SymTable_get(oSymTable, acLongKey);
+   ASSURE(pcValue == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == BINDING_COUNT + 1);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 0 for every key, so that all bindings collide. pcKey and
+   uLength are unused. */
+
+static size_t hashConstant(const char *pcKey, size_t uLength)
+{
+   assert(pcKey != NULL);
+   (void)pcKey;
+   (void)uLength;
+
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects that use hash function pfHash, with
+   iBindingCount bindings plus some long keys. */
+
+static void testHashFunction(SymTable_HashFunction pfHash,
+   int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12, LONG_KEY_SIZE = 200};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acLongKeyA[LONG_KEY_SIZE];
+   char acLongKeyB[LONG_KEY_SIZE];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   int iSuccessful;
+   int iFound;
+   int i;
+   size_t uLength;
+
+   for (i = 0; i < LONG_KEY_SIZE - 1; i++)
+   {
+      acLongKeyA[i] = 'a';
+      acLongKeyB[i] = 'a';
+   }
+   acLongKeyA[LONG_KEY_SIZE - 1] = '\0';
+   acLongKeyB[LONG_KEY_SIZE - 1] = '\0';
+   /* The keys differ only in their last byte. */
+   acLongKeyB[LONG_KEY_SIZE - 2] = 'b';
+
+   oSymTable = SymTable_newWithHash(pfHash);
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "0", acCenterField);
+   ASSURE(! iSuccessful);
+
+   iSuccessful = SymTable_put(oSymTable, acLongKeyA, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, acLongKeyB, acCenterField);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == (size_t)iBindingCount + 2);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+   pcValue = (char*)SymTable_get(oSymTable, acLongKeyA);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable, acLongKeyB);
+   ASSURE(pcValue == acCenterField);
+
+   pcValue = (char*)SymTable_replace(oSymTable, acLongKeyA,
+      acCenterField);
+   ASSURE(pcValue == acShortstop);
+
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iFound = SymTable_contains(oSymTable, acKey);
+      ASSURE(iFound == (i % 2 != 0));
+   }
+
+   pcValue = (char*)SymTable_remove(oSymTable, acLongKeyB);
+   ASSURE(pcValue == acCenterField);
+   iFound = SymTable_contains(oSymTable, acLongKeyA);
+   ASSURE(iFound);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects created by SymTable_newWithHash(). */
+
+static void testNewWithHash(void)
+{
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects created by\n");
+   printf("SymTable_newWithHash().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   testHashFunction(StrHash_multiply, 2000);
+   testHashFunction(StrHash_word, 2000);
+   testHashFunction(hashConstant, 200);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that take keys as a pointer and a length. */
+
+static void testLengthKeys(void)
+{
+   SymTable_T oSymTable;
+   /* The tokens are not null-terminated inside the buffer. */
+   const char acBuffer[] = "JeterMantleGehrig";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char *pcValue;
+   int iSuccessful;
+   int iFound;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the functions that take key lengths.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putLen(oSymTable, acBuffer, 5, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putLen(oSymTable, acBuffer + 5, 6,
+      acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putLen(oSymTable, acBuffer + 11, 6,
+      acFirstBase);
+   ASSURE(iSuccessful);
+
+   /* A key put with a length matches the equivalent string. */
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acFirstBase);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
+   ASSURE(pcValue == acCenterField);
+   iSuccessful = SymTable_putLen(oSymTable, "Gehrig", 6, acShortstop);
+   ASSURE(! iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 3);
+
+   /* Prefixes and extensions of a key are different keys. */
+   iFound = SymTable_containsLen(oSymTable, acBuffer, 3);
+   ASSURE(! iFound);
+   iFound = SymTable_containsLen(oSymTable, acBuffer, 6);
+   ASSURE(! iFound);
+   iFound = SymTable_containsLen(oSymTable, acBuffer, 5);
+   ASSURE(iFound);
+   pcValue = (char*)SymTable_getLen(oSymTable, acBuffer + 5, 5);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_getLen(oSymTable, acBuffer + 11, 6);
+   ASSURE(pcValue == acFirstBase);
+
+   pcValue = (char*)SymTable_replaceLen(oSymTable, acBuffer, 5,
+      acCenterField);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_replaceLen(oSymTable, acBuffer, 4,
+      acCenterField);
+   ASSURE(pcValue == NULL);
+
+   /* An empty key. */
+   iSuccessful = SymTable_putLen(oSymTable, acBuffer, 0, acShortstop);
+   ASSURE(iSuccessful);
+   iFound = SymTable_contains(oSymTable, "");
+   ASSURE(iFound);
+
+   pcValue = (char*)SymTable_removeLen(oSymTable, acBuffer + 5, 6);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_removeLen(oSymTable, acBuffer + 5, 6);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_removeLen(oSymTable, "", 0);
+   ASSURE(pcValue == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that take precomputed hash codes, including
+   reuse of a hash code across expansion and across tables. */
+
+static void testHashedKeys(void)
+{
+   enum {BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oSymTable2;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   size_t uHash;
+   int iSuccessful;
+   int iFound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the functions that take hash codes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oSymTable2 = SymTable_new();
+   ASSURE(oSymTable2 != NULL);
+
+   uHash = SymTable_hashKey(oSymTable, "Jeter");
+   iFound = SymTable_containsHashed(oSymTable, "Jeter", uHash);
+   ASSURE(! iFound);
+   iSuccessful = SymTable_putHashed(oSymTable, "Jeter", uHash,
+      acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putHashed(oSymTable, "Jeter", uHash,
+      acShortstop);
+   ASSURE(! iSuccessful);
+
+   /* The same hash code works in another table. */
+   iSuccessful = SymTable_putHashed(oSymTable2, "Jeter", uHash,
+      acCenterField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable2, "Jeter");
+   ASSURE(pcValue == acCenterField);
+
+   /* Grow the table, then reuse the hash code. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putHashed(oSymTable, acKey,
+         SymTable_hashKey(oSymTable, acKey), acCenterField);
+      ASSURE(iSuccessful);
+   }
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Jeter", uHash);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_replaceHashed(oSymTable, "Jeter", uHash,
+      acCenterField);
+   ASSURE(pcValue == acShortstop);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == acCenterField);
+   }
+
+   pcValue = (char*)SymTable_removeHashed(oSymTable, "Jeter", uHash);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_removeHashed(oSymTable, "Jeter", uHash);
+   ASSURE(pcValue == NULL);
+   iFound = SymTable_contains(oSymTable, "Jeter");
+   ASSURE(! iFound);
+
+   SymTable_free(oSymTable2);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up every key of acKeys in oSymTable with one call of
+   SymTable_getMany, and check the results against SymTable_get. Only
+   the keys with even indices are bound, each to itself. */
+
+static void checkGetMany(SymTable_T oSymTable,
+   const char *apcKeys[], int iKeyCount, void *apvValues[])
+{
+   int i;
+
+   SymTable_getMany(oSymTable, apcKeys, (size_t)iKeyCount, apvValues);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      if (i % 2 == 0)
+         ASSURE(apvValues[i] == apcKeys[i]);
+      else
+         ASSURE(apvValues[i] == NULL);
+      ASSURE(apvValues[i] == SymTable_get(oSymTable, apcKeys[i]));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getMany, with batches of several sizes and with
+   tables that are in the middle of expanding. */
+
+static void testGetMany(void)
+{
+   enum {KEY_COUNT = 3000, MAX_KEY_LENGTH = 10};
+
+   static char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   static const char *apcKeys[KEY_COUNT];
+   static void *apvValues[KEY_COUNT];
+   SymTable_T oSymTable;
+   SymTable_T oSymTableWord;
+   const char *apcRepeated[3];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getMany.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      apcKeys[i] = aacKeys[i];
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oSymTableWord = SymTable_newWithHash(StrHash_word);
+   ASSURE(oSymTableWord != NULL);
+
+   /* An empty batch and an empty table. */
+   SymTable_getMany(oSymTable, apcKeys, 0, apvValues);
+   SymTable_getMany(oSymTable, apcKeys, 1, apvValues);
+   ASSURE(apvValues[0] == NULL);
+
+   for (i = 0; i < KEY_COUNT; i += 2)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTableWord, apcKeys[i],
+         apcKeys[i]);
+      ASSURE(iSuccessful);
+
+      /* Check now and then, while expansions are under way. */
+      if (i % 250 == 0)
+      {
+         checkGetMany(oSymTable, apcKeys, i + 2, apvValues);
+         checkGetMany(oSymTableWord, apcKeys, i + 2, apvValues);
+      }
+   }
+
+   checkGetMany(oSymTable, apcKeys, KEY_COUNT, apvValues);
+   checkGetMany(oSymTableWord, apcKeys, KEY_COUNT, apvValues);
+   checkGetMany(oSymTable, apcKeys, 17, apvValues);
+
+   /* The same key may appear more than once in a batch. */
+   apcRepeated[0] = "42";
+   apcRepeated[1] = "43";
+   apcRepeated[2] = "42";
+   SymTable_getMany(oSymTable, apcRepeated, 3, apvValues);
+   ASSURE(apvValues[0] == apcKeys[42]);
+   ASSURE(apvValues[1] == NULL);
+   ASSURE(apvValues[2] == apcKeys[42]);
+
+   SymTable_free(oSymTableWord);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity, SymTable_reserve, and
+   SymTable_putMany. */
+
+static void testCapacity(void)
+{
+   enum {KEY_COUNT = 3000, MAX_KEY_LENGTH = 10};
+
+   static char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   static const char *apcKeys[KEY_COUNT];
+   static const void *apvValues[KEY_COUNT];
+   SymTable_T oSymTable;
+   const char *apcRepeated[4];
+   const void *apvRepeated[4];
+   size_t uAdded;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing capacity and bulk loading.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      apcKeys[i] = aacKeys[i];
+      apvValues[i] = aacKeys[KEY_COUNT - 1 - i];
+   }
+
+   /* A presized table. */
+   oSymTable = SymTable_newWithCapacity(KEY_COUNT);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apvValues[i]);
+   SymTable_free(oSymTable);
+
+   /* A zero capacity is allowed. */
+   oSymTable = SymTable_newWithCapacity(0);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   /* Reserve room in a table that already has bindings, and
+      shrinking requests, which leave the table as it is. */
+   for (i = 0; i < KEY_COUNT / 2; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_reserve(oSymTable, KEY_COUNT * 4);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_reserve(oSymTable, 1);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT / 2);
+   for (i = 0; i < KEY_COUNT / 2; i++)
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apvValues[i]);
+
+   /* Bulk load the rest, overlapping the keys already present. */
+   uAdded = SymTable_putMany(oSymTable, apcKeys, apvValues, KEY_COUNT);
+   ASSURE(uAdded == KEY_COUNT - KEY_COUNT / 2);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apvValues[i]);
+
+   /* A key repeated within a batch is put once, with its first
+      value. */
+   apcRepeated[0] = "Jeter";
+   apcRepeated[1] = "Mantle";
+   apcRepeated[2] = "Jeter";
+   apcRepeated[3] = "Ruth";
+   apvRepeated[0] = apcKeys[0];
+   apvRepeated[1] = apcKeys[1];
+   apvRepeated[2] = apcKeys[2];
+   apvRepeated[3] = apcKeys[3];
+   uAdded = SymTable_putMany(oSymTable, apcRepeated, apvRepeated, 4);
+   ASSURE(uAdded == 3);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == apcKeys[0]);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT + 3);
+
+   uAdded = SymTable_putMany(oSymTable, apcRepeated, apvRepeated, 0);
+   ASSURE(uAdded == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a SymTable object keeps working as it fills, drains, and
+   fills again, so that it grows and shrinks several times. */
+
+static void testShrink(void)
+{
+   enum {KEY_COUNT = 5000, KEPT_COUNT = 10, MAX_KEY_LENGTH = 10};
+
+   static char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   SymTable_T oSymTable;
+   char *pcValue;
+   int iSuccessful;
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table that grows and shrinks.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+      sprintf(aacKeys[i], "%d", i);
+
+   oSymTable = SymTable_newArena();
+   ASSURE(oSymTable != NULL);
+
+   for (iRound = 0; iRound < 3; iRound++)
+   {
+      for (i = KEPT_COUNT * (iRound != 0); i < KEY_COUNT; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+         ASSURE(iSuccessful);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+      /* Remove all but the first few bindings, checking the rest of
+         the table now and then as it shrinks. */
+      for (i = KEY_COUNT - 1; i >= KEPT_COUNT; i--)
+      {
+         pcValue = (char*)SymTable_remove(oSymTable, aacKeys[i]);
+         ASSURE(pcValue == aacKeys[i]);
+         if (i % 500 == 0)
+         {
+            pcValue = (char*)SymTable_get(oSymTable, aacKeys[i / 2]);
+            ASSURE(pcValue == aacKeys[i / 2]);
+            pcValue = (char*)SymTable_get(oSymTable, aacKeys[i]);
+            ASSURE(pcValue == NULL);
+         }
+      }
+      ASSURE(SymTable_getLength(oSymTable) == KEPT_COUNT);
+      for (i = 0; i < KEPT_COUNT; i++)
+      {
+         pcValue = (char*)SymTable_get(oSymTable, aacKeys[i]);
+         ASSURE(pcValue == aacKeys[i]);
+      }
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {CONC_THREAD_COUNT = 8, CONC_KEYS_PER_THREAD = 2000};
+
+/* The work of one thread of testConcurrent. */
+struct ConcWork
+{
+   /* The table shared by every thread. */
+   ConcSymTable_T oConcSymTable;
+   /* The thread's number, which determines its keys. */
+   int iThread;
+};
+
+/* Put, check, replace, and remove the keys of the thread described by
+   pvWork, a struct ConcWork, in its shared table. Leave the keys with
+   even numbers bound to themselves. Return NULL. */
+
+static void *concWorker(void *pvWork)
+{
+   struct ConcWork *psWork = (struct ConcWork*)pvWork;
+   ConcSymTable_T oConcSymTable = psWork->oConcSymTable;
+   char acKey[32];
+   char acShared[] = "Shared";
+   int iSuccessful;
+   int i;
+
+   for (i = 0; i < CONC_KEYS_PER_THREAD; i++)
+   {
+      sprintf(acKey, "%d.%d", psWork->iThread, i);
+      iSuccessful = ConcSymTable_put(oConcSymTable, acKey, psWork);
+      ASSURE(iSuccessful);
+
+      /* Every thread races to put the same key; one of them wins. */
+      (void)ConcSymTable_put(oConcSymTable, "Shared", acShared);
+      ASSURE(ConcSymTable_contains(oConcSymTable, "Shared"));
+   }
+
+   for (i = 0; i < CONC_KEYS_PER_THREAD; i++)
+   {
+      sprintf(acKey, "%d.%d", psWork->iThread, i);
+      ASSURE(ConcSymTable_get(oConcSymTable, acKey) == psWork);
+      if (i % 2 == 0)
+         ASSURE(ConcSymTable_replace(oConcSymTable, acKey, NULL)
+            == psWork);
+      else
+         ASSURE(ConcSymTable_remove(oConcSymTable, acKey) == psWork);
+   }
+   return NULL;
+}
+
+/* Add 1 to *pvExtra, a size_t, if pvValue is NULL. */
+
+static void countNullValues(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   if (pvValue == NULL)
+      (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a ConcSymTable object used by several threads at once. */
+
+static void testConcurrent(void)
+{
+   ConcSymTable_T oConcSymTable;
+   pthread_t aThreads[CONC_THREAD_COUNT];
+   struct ConcWork asWork[CONC_THREAD_COUNT];
+   char acKey[32];
+   size_t uNullCount = 0;
+   int iResult;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table shared by several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oConcSymTable = ConcSymTable_new(0);
+   ASSURE(oConcSymTable != NULL);
+
+   for (i = 0; i < CONC_THREAD_COUNT; i++)
+   {
+      asWork[i].oConcSymTable = oConcSymTable;
+      asWork[i].iThread = i;
+      iResult = pthread_create(&aThreads[i], NULL, concWorker,
+         &asWork[i]);
+      ASSURE(iResult == 0);
+   }
+   for (i = 0; i < CONC_THREAD_COUNT; i++)
+   {
+      iResult = pthread_join(aThreads[i], NULL);
+      ASSURE(iResult == 0);
+   }
+
+   /* Half of each thread's keys remain, plus the shared key. */
+   ASSURE(ConcSymTable_getLength(oConcSymTable) ==
+      CONC_THREAD_COUNT * CONC_KEYS_PER_THREAD / 2 + 1);
+   ConcSymTable_map(oConcSymTable, countNullValues, &uNullCount);
+   ASSURE(uNullCount == CONC_THREAD_COUNT * CONC_KEYS_PER_THREAD / 2);
+   for (i = 0; i < CONC_THREAD_COUNT; i++)
+   {
+      sprintf(acKey, "%d.%d", i, 0);
+      ASSURE(ConcSymTable_contains(oConcSymTable, acKey));
+      sprintf(acKey, "%d.%d", i, 1);
+      ASSURE(! ConcSymTable_contains(oConcSymTable, acKey));
+   }
+
+   /* A table with a single shard works too. */
+   ConcSymTable_free(oConcSymTable);
+   oConcSymTable = ConcSymTable_new(1);
+   ASSURE(oConcSymTable != NULL);
+   ASSURE(ConcSymTable_put(oConcSymTable, "Ruth", acKey));
+   ASSURE(ConcSymTable_get(oConcSymTable, "Ruth") == acKey);
+   ConcSymTable_free(oConcSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {RCU_READER_COUNT = 4, RCU_STABLE_COUNT = 100,
+   RCU_CHURN_COUNT = 5000, RCU_LOOKUP_COUNT = 200000};
+
+/* The values that testReadMostly binds. */
+static char acRcuStable[] = "Stable";
+static char acRcuStable2[] = "Stable again";
+static char acRcuChurn[] = "Churn";
+
+/* Look up keys of the RcuSymTable pvTable, an RcuSymTable_T, while a
+   writer changes it. A stable key must always be bound to one of its
+   two values; a churn key may be bound or not. Return NULL. */
+
+static void *rcuReader(void *pvTable)
+{
+   RcuSymTableReader_T oReader;
+   char acKey[32];
+   void *pvValue;
+   int i;
+
+   oReader = RcuSymTable_newReader((RcuSymTable_T)pvTable);
+   ASSURE(oReader != NULL);
+
+   for (i = 0; i < RCU_LOOKUP_COUNT; i++)
+   {
+      sprintf(acKey, "s%d", i % RCU_STABLE_COUNT);
+      pvValue = RcuSymTable_get(oReader, acKey);
+      ASSURE(pvValue == acRcuStable || pvValue == acRcuStable2);
+
+      sprintf(acKey, "c%d", i % RCU_CHURN_COUNT);
+      pvValue = RcuSymTable_get(oReader, acKey);
+      ASSURE(pvValue == NULL || pvValue == acRcuChurn);
+   }
+
+   RcuSymTable_freeReader(oReader);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test an RcuSymTable object read by several threads while another
+   thread puts, replaces, and removes bindings. */
+
+static void testReadMostly(void)
+{
+   RcuSymTable_T oRcuSymTable;
+   RcuSymTableReader_T oReader;
+   pthread_t aThreads[RCU_READER_COUNT];
+   char acKey[32];
+   size_t uCount = 0;
+   int iResult;
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a read-mostly table with lock-free readers.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oRcuSymTable = RcuSymTable_new();
+   ASSURE(oRcuSymTable != NULL);
+   for (i = 0; i < RCU_STABLE_COUNT; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(RcuSymTable_put(oRcuSymTable, acKey, acRcuStable));
+   }
+
+   for (i = 0; i < RCU_READER_COUNT; i++)
+   {
+      iResult = pthread_create(&aThreads[i], NULL, rcuReader,
+         oRcuSymTable);
+      ASSURE(iResult == 0);
+   }
+
+   /* Grow the table through several expansions and shrink it back,
+      replacing the stable values along the way. */
+   for (iRound = 0; iRound < 3; iRound++)
+   {
+      for (i = 0; i < RCU_CHURN_COUNT; i++)
+      {
+         sprintf(acKey, "c%d", i);
+         ASSURE(RcuSymTable_put(oRcuSymTable, acKey, acRcuChurn));
+         ASSURE(! RcuSymTable_put(oRcuSymTable, acKey, acRcuChurn));
+         sprintf(acKey, "s%d", i % RCU_STABLE_COUNT);
+         (void)RcuSymTable_replace(oRcuSymTable, acKey,
+            i % 2 == 0 ? acRcuStable2 : acRcuStable);
+      }
+      for (i = 0; i < RCU_CHURN_COUNT; i++)
+      {
+         sprintf(acKey, "c%d", i);
+         ASSURE(RcuSymTable_remove(oRcuSymTable, acKey) == acRcuChurn);
+      }
+   }
+
+   for (i = 0; i < RCU_READER_COUNT; i++)
+   {
+      iResult = pthread_join(aThreads[i], NULL);
+      ASSURE(iResult == 0);
+   }
+
+   ASSURE(RcuSymTable_getLength(oRcuSymTable) == RCU_STABLE_COUNT);
+   RcuSymTable_map(oRcuSymTable, countNullValues, &uCount);
+   ASSURE(uCount == 0);
+
+   /* Readers are reused once given back. */
+   oReader = RcuSymTable_newReader(oRcuSymTable);
+   ASSURE(oReader != NULL);
+   ASSURE(RcuSymTable_contains(oReader, "s0"));
+   ASSURE(! RcuSymTable_contains(oReader, "c0"));
+   ASSURE(RcuSymTable_remove(oRcuSymTable, "s0") != NULL);
+   ASSURE(RcuSymTable_get(oReader, "s0") == NULL);
+   RcuSymTable_freeReader(oReader);
+
+   RcuSymTable_free(oRcuSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* One worker's totals in testMapParallel. */
+struct MapTotals
+{
+   /* Number of bindings the worker visited. */
+   size_t uCount;
+   /* Sum of the numbers the worker's bindings are bound to. */
+   size_t uSum;
+};
+
+/* Add the binding whose value is pvValue, an int, to *pvExtra, a
+   struct MapTotals. */
+
+static void addToTotals(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct MapTotals *psTotals = (struct MapTotals*)pvExtra;
+
+   assert(pcKey != NULL);
+   (void)pcKey;
+   psTotals->uCount++;
+   psTotals->uSum += (size_t)*(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapParallel with several numbers of workers, each
+   reducing into its own slot. */
+
+static void testMapParallel(void)
+{
+   enum {KEY_COUNT = 20000, MAX_WORKER_COUNT = 8, MAX_KEY_LENGTH = 10};
+
+   static int aiNumbers[KEY_COUNT];
+   SymTable_T oSymTable;
+   struct MapTotals asTotals[MAX_WORKER_COUNT];
+   void *apvExtras[MAX_WORKER_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   size_t uWorkerCount;
+   size_t uCount;
+   size_t uSum;
+   size_t uExpectedSum = 0;
+   size_t u;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapParallel.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiNumbers[i] = i;
+      uExpectedSum += (size_t)i;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+   }
+
+   for (uWorkerCount = 1; uWorkerCount <= MAX_WORKER_COUNT;
+      uWorkerCount *= 2)
+   {
+      for (u = 0; u < uWorkerCount; u++)
+      {
+         asTotals[u].uCount = 0;
+         asTotals[u].uSum = 0;
+         apvExtras[u] = &asTotals[u];
+      }
+      SymTable_mapParallel(oSymTable, addToTotals, apvExtras,
+         uWorkerCount);
+
+      uCount = 0;
+      uSum = 0;
+      for (u = 0; u < uWorkerCount; u++)
+      {
+         uCount += asTotals[u].uCount;
+         uSum += asTotals[u].uSum;
+      }
+      ASSURE(uCount == KEY_COUNT);
+      ASSURE(uSum == uExpectedSum);
+   }
+
+   /* An empty table visits nothing. */
+   SymTable_free(oSymTable);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   asTotals[0].uCount = 0;
+   SymTable_mapParallel(oSymTable, addToTotals, apvExtras, 4);
+   ASSURE(asTotals[0].uCount == 0);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Walk the rest of the bindings of oIter, adding one to
+   aiSeen[i] for each binding whose value is &aiNumbers[i]. */
+
+static void finishWalk(SymTableIter_T oIter, int aiSeen[],
+   int aiNumbers[])
+{
+   const char *pcKey;
+   void *pvValue;
+
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(pcKey != NULL);
+      aiSeen[(int*)pvValue - aiNumbers]++;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_iterBegin, SymTable_iterNext, and SymTable_iterEnd,
+   including walks that the table grows and shrinks under. */
+
+static void testIterator(void)
+{
+   enum {KEY_COUNT = 5000, FIRST_COUNT = 500, STEPS_PER_PUT = 50,
+      KEEP_EVERY = 10, MAX_KEY_LENGTH = 12};
+
+   static int aiNumbers[KEY_COUNT];
+   static int aiSeen[KEY_COUNT];
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   SymTableIter_T oOtherIter;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   int iSuccessful;
+   int iIndex;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable iterators.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+      aiNumbers[i] = i;
+
+   /* An empty table has nothing to walk. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+
+   /* The empty key is walked like any other. */
+   iSuccessful = SymTable_put(oSymTable, "", &aiNumbers[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "1", &aiNumbers[1]);
+   ASSURE(iSuccessful);
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   memset(aiSeen, 0, sizeof(aiSeen));
+   finishWalk(oIter, aiSeen, aiNumbers);
+   ASSURE(aiSeen[0] == 1);
+   ASSURE(aiSeen[1] == 1);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+   SymTable_free(oSymTable);
+
+   /* Every binding of a table of any size is walked once. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FIRST_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+      memset(aiSeen, 0, sizeof(aiSeen));
+      oIter = SymTable_iterBegin(oSymTable);
+      ASSURE(oIter != NULL);
+      finishWalk(oIter, aiSeen, aiNumbers);
+      SymTable_iterEnd(oIter);
+      for (iIndex = 0; iIndex <= i; iIndex++)
+         ASSURE(aiSeen[iIndex] == 1);
+   }
+   SymTable_free(oSymTable);
+
+   /* A walk that the table grows under, several resizes over,
+      returns each of the first bindings once and no binding twice. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FIRST_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+   }
+   memset(aiSeen, 0, sizeof(aiSeen));
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   for (i = FIRST_COUNT; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+      if (i % STEPS_PER_PUT == 0
+         && SymTable_iterNext(oIter, &pcKey, &pvValue))
+      {
+         aiSeen[(int*)pvValue - aiNumbers]++;
+      }
+   }
+   finishWalk(oIter, aiSeen, aiNumbers);
+   SymTable_iterEnd(oIter);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      ASSURE(aiSeen[i] <= 1);
+      if (i < FIRST_COUNT)
+         ASSURE(aiSeen[i] == 1);
+   }
+
+   /* A walk that the table shrinks under returns each binding that
+      stays once, even when each binding returned is removed. */
+   memset(aiSeen, 0, sizeof(aiSeen));
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   i = KEY_COUNT - 1;
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      iIndex = (int)((int*)pvValue - aiNumbers);
+      aiSeen[iIndex]++;
+      if (iIndex % KEEP_EVERY != 0)
+      {
+         sprintf(acKey, "%d", iIndex);
+         ASSURE(SymTable_remove(oSymTable, acKey) == pvValue);
+      }
+      for (; i >= 0 && i % KEEP_EVERY == 0; i--)
+      {
+      }
+      if (i >= 0)
+      {
+         sprintf(acKey, "%d", i);
+         (void)SymTable_remove(oSymTable, acKey);
+         i--;
+      }
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT / KEEP_EVERY);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      ASSURE(aiSeen[i] <= 1);
+      if (i % KEEP_EVERY == 0)
+         ASSURE(aiSeen[i] == 1);
+   }
+
+   /* A walk may stop early. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterNext(oIter, &pcKey, &pvValue));
+   ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   SymTable_iterEnd(oIter);
+
+   /* Lookups that would reorder the table do not disturb a walk,
+      even one of several open at once. */
+   SymTable_setOrder(oSymTable, SYMTABLE_ORDER_MOVE_TO_FRONT);
+   memset(aiSeen, 0, sizeof(aiSeen));
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   oOtherIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oOtherIter != NULL);
+   i = 0;
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      aiSeen[(int*)pvValue - aiNumbers]++;
+      sprintf(acKey, "%d", i);
+      (void)SymTable_get(oSymTable, acKey);
+      i = (i + 7 * KEEP_EVERY) % KEY_COUNT;
+   }
+   SymTable_iterEnd(oOtherIter);
+   SymTable_iterEnd(oIter);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(aiSeen[i] == (i % KEEP_EVERY == 0));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The keys seen by appendKey, in the order seen. */
+struct KeyList
+{
+   /* The keys, each followed by a space. */
+   char acKeys[256];
+   /* Number of keys seen. */
+   size_t uCount;
+};
+
+/* Append pcKey and a space to *pvExtra, a struct KeyList. */
+
+static void appendKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct KeyList *psList = (struct KeyList*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psList != NULL);
+   (void)pvValue;
+
+   if (strlen(psList->acKeys) + strlen(pcKey) + 2
+      <= sizeof(psList->acKeys))
+   {
+      strcat(psList->acKeys, pcKey);
+      strcat(psList->acKeys, " ");
+   }
+   psList->uCount++;
+}
+
+/* Check that the key whose value is pvValue, an int, comes after the
+   last one seen by *pvExtra, an int holding the last value seen. */
+
+static void checkAscending(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   int *piLast = (int*)pvExtra;
+
+   assert(pcKey != NULL);
+   (void)pcKey;
+   ASSURE(*(int*)pvValue == *piLast + 1);
+   *piLast = *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_range and SymTable_prefix. */
+
+static void testRange(void)
+{
+   enum {KEY_COUNT = 3000, MAX_KEY_LENGTH = 10};
+
+   static const char *apcKeys[] = {"net.tcp", "net", "net.", "netx",
+      "ne", "net.ipv4.tcp", "a", "net.udp", "z", ""};
+   static int aiNumbers[KEY_COUNT];
+   SymTable_T oSymTable;
+   struct KeyList sList;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int iLast;
+   size_t u;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_range and SymTable_prefix.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing in any range. */
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_prefix(oSymTable, "", appendKey, &sList);
+   ASSURE(iSuccessful);
+   ASSURE(sList.uCount == 0);
+
+   for (u = 0; u < sizeof(apcKeys) / sizeof(apcKeys[0]); u++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[u], NULL);
+      ASSURE(iSuccessful);
+   }
+
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_prefix(oSymTable, "net.", appendKey, &sList);
+   ASSURE(iSuccessful);
+   ASSURE(strcmp(sList.acKeys,
+      "net. net.ipv4.tcp net.tcp net.udp ") == 0);
+
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_prefix(oSymTable, "", appendKey, &sList);
+   ASSURE(iSuccessful);
+   ASSURE(sList.uCount == sizeof(apcKeys) / sizeof(apcKeys[0]));
+   ASSURE(strcmp(sList.acKeys, " a ne net net. net.ipv4.tcp net.tcp "
+      "net.udp netx z ") == 0);
+
+   /* The low key is included and the high key is not. */
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_range(oSymTable, "net", "net.udp",
+      appendKey, &sList);
+   ASSURE(iSuccessful);
+   ASSURE(strcmp(sList.acKeys,
+      "net net. net.ipv4.tcp net.tcp ") == 0);
+
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_range(oSymTable, "nf", "a", appendKey,
+      &sList);
+   ASSURE(iSuccessful);
+   ASSURE(sList.uCount == 0);
+   iSuccessful = SymTable_prefix(oSymTable, "net.ipv6", appendKey,
+      &sList);
+   ASSURE(iSuccessful);
+   ASSURE(sList.uCount == 0);
+   SymTable_free(oSymTable);
+
+   /* A large range comes back in order, across many nodes of an
+      ordered implementation. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiNumbers[i] = i;
+      sprintf(acKey, "%05d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+   }
+   iLast = 99;
+   iSuccessful = SymTable_range(oSymTable, "00100", "02900",
+      checkAscending, &iLast);
+   ASSURE(iSuccessful);
+   ASSURE(iLast == 2899);
+   iLast = 1999;
+   iSuccessful = SymTable_prefix(oSymTable, "02", checkAscending,
+      &iLast);
+   ASSURE(iSuccessful);
+   ASSURE(iLast == 2999);
+
+   /* Removing most of the keys leaves the rest in order. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      if (i % 100 != 0)
+      {
+         sprintf(acKey, "%05d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiNumbers[i]);
+      }
+   }
+   sList.acKeys[0] = '\0';
+   sList.uCount = 0;
+   iSuccessful = SymTable_range(oSymTable, "00500", "01000",
+      appendKey, &sList);
+   ASSURE(iSuccessful);
+   ASSURE(strcmp(sList.acKeys,
+      "00500 00600 00700 00800 00900 ") == 0);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_intern and the functions that take interned keys,
+on both an ordinary table and an arena table. */
+
+static void testIntern(void)
+{
+   enum {KEY_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   static const char *apcInterned[KEY_COUNT];
+   static int aiNumbers[KEY_COUNT];
+   SymTable_T oSymTable;
+   const char *pcKey;
+   const char *pcEmpty;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int iArena;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_intern and the interned-key functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iArena = 0; iArena <= 1; iArena++)
+   {
+      oSymTable = iArena ? SymTable_newArena() : SymTable_new();
+      ASSURE(oSymTable != NULL);
+
+      /* Interning an absent key binds it to NULL. */
+      strcpy(acKey, "Ruth");
+      pcKey = SymTable_intern(oSymTable, acKey);
+      ASSURE(pcKey != NULL);
+      ASSURE(pcKey != acKey);
+      ASSURE(strcmp(pcKey, "Ruth") == 0);
+      ASSURE(SymTable_getLength(oSymTable) == 1);
+      ASSURE(SymTable_contains(oSymTable, "Ruth"));
+      ASSURE(SymTable_get(oSymTable, "Ruth") == NULL);
+
+      /* Interning it again, or an equal string, gives the same
+      pointer and does not add a binding. */
+      ASSURE(SymTable_intern(oSymTable, "Ruth") == pcKey);
+      ASSURE(SymTable_intern(oSymTable, pcKey) == pcKey);
+      ASSURE(SymTable_getLength(oSymTable) == 1);
+
+      /* Interning a key that is already bound keeps its value. */
+      iSuccessful = SymTable_put(oSymTable, "Gehrig", &aiNumbers[1]);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_getInterned(oSymTable,
+         SymTable_intern(oSymTable, "Gehrig")) == &aiNumbers[1]);
+      ASSURE(SymTable_getLength(oSymTable) == 2);
+
+      pcEmpty = SymTable_intern(oSymTable, "");
+      ASSURE(pcEmpty != NULL);
+      ASSURE(*pcEmpty == '\0');
+      ASSURE(SymTable_getLength(oSymTable) == 3);
+
+      ASSURE(SymTable_replaceInterned(oSymTable, pcKey, &aiNumbers[0])
+         == NULL);
+      ASSURE(SymTable_getInterned(oSymTable, pcKey) == &aiNumbers[0]);
+      ASSURE(SymTable_get(oSymTable, "Ruth") == &aiNumbers[0]);
+      ASSURE(SymTable_replaceInterned(oSymTable, pcEmpty,
+         &aiNumbers[2]) == NULL);
+      ASSURE(SymTable_get(oSymTable, "") == &aiNumbers[2]);
+
+      ASSURE(SymTable_removeInterned(oSymTable, pcKey)
+         == &aiNumbers[0]);
+      ASSURE(SymTable_getLength(oSymTable) == 2);
+      ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+      ASSURE(SymTable_removeInterned(oSymTable, pcEmpty)
+         == &aiNumbers[2]);
+      ASSURE(SymTable_getLength(oSymTable) == 1);
+
+      /* Interned keys stay put while the table grows. */
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         apcInterned[i] = SymTable_intern(oSymTable, acKey);
+         ASSURE(apcInterned[i] != NULL);
+         SymTable_replaceInterned(oSymTable, apcInterned[i],
+            &aiNumbers[i]);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT + 1);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_intern(oSymTable, acKey) == apcInterned[i]);
+         ASSURE(SymTable_getInterned(oSymTable, apcInterned[i])
+            == &aiNumbers[i]);
+      }
+
+      /* ... and while it shrinks. */
+      for (i = 0; i < KEY_COUNT; i += 2)
+      {
+         ASSURE(SymTable_removeInterned(oSymTable, apcInterned[i])
+            == &aiNumbers[i]);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT / 2 + 1);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         if (i % 2 == 0)
+            ASSURE(! SymTable_contains(oSymTable, acKey));
+         else
+         {
+            ASSURE(SymTable_intern(oSymTable, acKey)
+               == apcInterned[i]);
+            ASSURE(SymTable_getInterned(oSymTable, apcInterned[i])
+               == &aiNumbers[i]);
+         }
+      }
+      for (i = 1; i < KEY_COUNT; i += 2)
+      {
+         ASSURE(SymTable_removeInterned(oSymTable, apcInterned[i])
+            == &aiNumbers[i]);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == 1);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size of pvValue, an int or, if pcKey is "name", a
+   string. Suitable for SymTableImage_save. */
+
+static size_t valueSize(const char *pcKey, const void *pvValue,
+   void *pvExtra)
+{
+   (void)pvExtra;
+   if (strcmp(pcKey, "name") == 0)
+      return strlen((const char*)pvValue) + 1;
+   return sizeof(int);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check the binding of pcKey and pvValue, of uSize bytes, read from
+   an image of the table that testImage builds, and count it in
+   *pvExtra, a size_t. */
+
+static void checkImageBinding(const char *pcKey, const void *pvValue,
+   size_t uSize, void *pvExtra)
+{
+   if (strcmp(pcKey, "name") == 0)
+      ASSURE(strcmp((const char*)pvValue, "Ruth") == 0);
+   else if (strcmp(pcKey, "none") == 0)
+      ASSURE(pvValue == NULL && uSize == 0);
+   else
+   {
+      ASSURE(uSize == sizeof(int));
+      ASSURE(*(const int*)pvValue == atoi(pcKey));
+   }
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableImage_save and the SymTableImage_T object that
+   SymTableImage_open returns. */
+
+static void testImage(void)
+{
+   enum {KEY_COUNT = 3000, MAX_KEY_LENGTH = 10};
+
+   static const char *pcPath = "testsymtable.img";
+   static int aiNumbers[KEY_COUNT];
+   SymTable_T oSymTable;
+   SymTableImage_T oSymTableImage;
+   const void *pvValue;
+   char acKey[MAX_KEY_LENGTH];
+   FILE *psFile;
+   size_t uSize;
+   size_t uCount;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableImage_save and SymTableImage_open.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty table. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTableImage_save(oSymTable, pcPath, valueSize,
+      NULL);
+   ASSURE(iSuccessful);
+   oSymTableImage = SymTableImage_open(pcPath);
+   ASSURE(oSymTableImage != NULL);
+   ASSURE(SymTableImage_getLength(oSymTableImage) == 0);
+   ASSURE(! SymTableImage_contains(oSymTableImage, ""));
+   ASSURE(SymTableImage_get(oSymTableImage, "0", NULL) == NULL);
+   SymTableImage_close(oSymTableImage);
+
+   /* Integers, a string, a NULL value, and the empty key. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiNumbers[i] = i;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "name", "Ruth");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "none", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "", &aiNumbers[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableImage_save(oSymTable, pcPath, valueSize,
+      NULL);
+   ASSURE(iSuccessful);
+
+   /* The image does not depend on the table, which may go away. */
+   SymTable_free(oSymTable);
+   oSymTableImage = SymTableImage_open(pcPath);
+   ASSURE(oSymTableImage != NULL);
+   ASSURE(SymTableImage_getLength(oSymTableImage) == KEY_COUNT + 3);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableImage_contains(oSymTableImage, acKey));
+      pvValue = SymTableImage_get(oSymTableImage, acKey, &uSize);
+      ASSURE(pvValue != NULL);
+      ASSURE(pvValue != (void*)&aiNumbers[i]);
+      ASSURE(uSize == sizeof(int));
+      ASSURE(*(const int*)pvValue == i);
+      ASSURE((size_t)pvValue % sizeof(double) == 0);
+   }
+   for (i = KEY_COUNT; i < 2 * KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(! SymTableImage_contains(oSymTableImage, acKey));
+      ASSURE(SymTableImage_get(oSymTableImage, acKey, &uSize)
+         == NULL);
+   }
+   pvValue = SymTableImage_get(oSymTableImage, "name", &uSize);
+   ASSURE(pvValue != NULL);
+   ASSURE(uSize == 5);
+   ASSURE(strcmp((const char*)pvValue, "Ruth") == 0);
+   ASSURE(SymTableImage_contains(oSymTableImage, "none"));
+   ASSURE(SymTableImage_get(oSymTableImage, "none", &uSize) == NULL);
+   ASSURE(uSize == 0);
+   pvValue = SymTableImage_get(oSymTableImage, "", NULL);
+   ASSURE(pvValue != NULL);
+   ASSURE(*(const int*)pvValue == 0);
+
+   uCount = 0;
+   SymTableImage_map(oSymTableImage, checkImageBinding, &uCount);
+   ASSURE(uCount == KEY_COUNT + 3);
+   SymTableImage_close(oSymTableImage);
+
+   /* A file that is not an image, and no file at all. */
+   psFile = fopen(pcPath, "w");
+   ASSURE(psFile != NULL);
+   fputs("This is not a symbol table image.\n", psFile);
+   fclose(psFile);
+   ASSURE(SymTableImage_open(pcPath) == NULL);
+   remove(pcPath);
+   ASSURE(SymTableImage_open(pcPath) == NULL);
+
+   /* A file that cannot be created. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(! SymTableImage_save(oSymTable,
+      "no-such-directory/testsymtable.img", valueSize, NULL));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that *psStats describes a table of uLength bindings
+   consistently. */
+
+static void checkStats(const struct SymTableStats *psStats,
+   size_t uLength)
+{
+   size_t uBuckets = 0;
+   size_t uBindings = 0;
+   size_t u;
+
+   ASSURE(psStats->uLength == uLength);
+   for (u = 0; u < SYMTABLE_HISTOGRAM_SIZE; u++)
+   {
+      uBuckets += psStats->auChainLengths[u];
+      uBindings += u * psStats->auChainLengths[u];
+      if (psStats->auChainLengths[u] > 0)
+         ASSURE(u <= psStats->uMaxChainLength);
+   }
+   ASSURE(uBuckets == psStats->uBucketCount);
+   /* A tree has no buckets to hold its bindings. */
+   if (psStats->uBucketCount > 0 &&
+      psStats->uMaxChainLength < SYMTABLE_HISTOGRAM_SIZE - 1)
+      ASSURE(uBindings == uLength);
+   if (psStats->uBucketCount > 0)
+      ASSURE(psStats->dLoadFactor ==
+         (double)uLength / (double)psStats->uBucketCount);
+   else
+      ASSURE(psStats->dLoadFactor == 0.0);
+   ASSURE(psStats->uHits + psStats->uMisses == psStats->uGets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getStats. */
+
+static void testStats(void)
+{
+   enum {KEY_COUNT = 1000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uKeyBytes = 0;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getStats.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, 0);
+   ASSURE(sStats.uMaxChainLength == 0);
+   ASSURE(sStats.uKeyBytes == 0);
+   ASSURE(sStats.uPuts == 0);
+   ASSURE(sStats.uGets == 0);
+   ASSURE(sStats.uExpansions == 0);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+      uKeyBytes += strlen(acKey) + 1;
+   }
+   /* A duplicate put is counted, though it adds nothing. */
+   iSuccessful = SymTable_put(oSymTable, "0", NULL);
+   ASSURE(! iSuccessful);
+   for (i = 0; i < KEY_COUNT + KEY_COUNT / 2; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i < KEY_COUNT));
+   }
+
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, KEY_COUNT);
+   ASSURE(sStats.uMaxChainLength > 0 || sStats.uBucketCount == 0);
+   ASSURE(sStats.uKeyBytes >= uKeyBytes);
+   ASSURE(sStats.uNodeBytes + sStats.uBucketBytes > 0);
+#ifdef SYMTABLE_STATS
+   ASSURE(sStats.uPuts == KEY_COUNT + 1);
+   ASSURE(sStats.uGets == KEY_COUNT + KEY_COUNT / 2);
+   ASSURE(sStats.uHits == KEY_COUNT);
+   ASSURE(sStats.uMisses == KEY_COUNT / 2);
+   ASSURE(sStats.dProbesPerLookup > 0.0);
+   /* A list is one bucket, which never grows. */
+   ASSURE(sStats.uExpansions > 0 || sStats.uBucketCount == 1);
+#else
+   ASSURE(sStats.uPuts == 0);
+   ASSURE(sStats.uGets == 0);
+   ASSURE(sStats.uHits == 0);
+   ASSURE(sStats.uMisses == 0);
+   ASSURE(sStats.uExpansions == 0);
+   ASSURE(sStats.dProbesPerLookup == 0.0);
+#endif
+
+   /* Removing half the bindings leaves the layout consistent. */
+   for (i = 0; i < KEY_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      SymTable_remove(oSymTable, acKey);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, KEY_COUNT / 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The events that recordTraceEvent has received. */
+
+struct TraceEvents
+{
+   size_t uCount;
+   size_t uResizes;
+   SymTable_T oSymTable;
+};
+
+/* Count *psEvent in the TraceEvents object pvExtra, checking that it
+   describes an operation on that object's table. */
+
+static void recordTraceEvent(const struct SymTableTraceEvent *psEvent,
+   void *pvExtra)
+{
+   struct TraceEvents *psEvents = (struct TraceEvents*)pvExtra;
+
+   ASSURE(psEvent->oSymTable == psEvents->oSymTable);
+   ASSURE(psEvent->eOp < SYMTABLE_TRACE_OP_COUNT);
+   ASSURE(psEvent->pcKey != NULL ||
+      psEvent->eOp == SYMTABLE_TRACE_RESERVE ||
+      psEvent->eOp == SYMTABLE_TRACE_PUT_MANY);
+#if defined(__GNUC__)
+   ASSURE(psEvent->pvCaller != NULL);
+#endif
+   psEvents->uCount++;
+   if (psEvent->eCause == SYMTABLE_TRACE_EXPAND ||
+      psEvent->eCause == SYMTABLE_TRACE_SHRINK)
+      psEvents->uResizes++;
+}
+
+/* Return the number of operations of kind eOp in its histogram. */
+
+static size_t countTraced(enum SymTableTraceOp eOp)
+{
+   size_t auCounts[SYMTABLE_TRACE_BUCKET_COUNT];
+   size_t uTotal = 0;
+   size_t u;
+
+   SymTableTrace_getHistogram(eOp, auCounts);
+   for (u = 0; u < SYMTABLE_TRACE_BUCKET_COUNT; u++)
+      uTotal += auCounts[u];
+   return uTotal;
+}
+
+/* Check that *pvExtra, a SymTable, binds pcKey to pvValue. */
+
+static void getAgain(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   ASSURE(SymTable_get((SymTable_T)pvExtra, pcKey) == pvValue);
+}
+
+/* Test the SymTableTrace functions, and that a SymTable object
+   compiled with SYMTABLE_TRACE reports its operations to them. */
+
+static void testTrace(void)
+{
+   enum {KEY_COUNT = 1000, MAX_KEY_LENGTH = 10};
+
+   static char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   static const char *apcKeys[KEY_COUNT];
+   static const void *apvValues[KEY_COUNT];
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   struct TraceEvents sEvents;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   size_t u;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTableTrace functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Bucket limits rise, so that each time falls in one bucket. */
+   ASSURE(SymTableTrace_bucketLimit(0) == 1);
+   for (u = 1; u < SYMTABLE_TRACE_BUCKET_COUNT; u++)
+      ASSURE(SymTableTrace_bucketLimit(u) >
+         SymTableTrace_bucketLimit(u - 1));
+   ASSURE(SymTableTrace_bucketLimit(SYMTABLE_TRACE_BUCKET_COUNT - 1)
+      == (size_t)-1);
+
+   SymTableTrace_reset();
+   ASSURE(countTraced(SYMTABLE_TRACE_PUT) == 0);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == 0);
+   ASSURE(SymTableTrace_percentile(SYMTABLE_TRACE_GET, 0.99) == 0);
+
+   /* Time every operation, so that the histograms count them all. */
+   SymTableTrace_setSamplePeriod(1);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* A threshold no operation reaches reports only resizes. */
+   sEvents.uCount = 0;
+   sEvents.uResizes = 0;
+   sEvents.oSymTable = oSymTable;
+   SymTableTrace_setSink(recordTraceEvent, (size_t)-1, &sEvents);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < KEY_COUNT + KEY_COUNT / 2; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i < KEY_COUNT));
+   }
+   ASSURE(sEvents.uCount == sEvents.uResizes);
+
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_TRACE
+   ASSURE(countTraced(SYMTABLE_TRACE_PUT) == KEY_COUNT);
+   ASSURE(countTraced(SYMTABLE_TRACE_CONTAINS) ==
+      KEY_COUNT + KEY_COUNT / 2);
+   ASSURE(countTraced(SYMTABLE_TRACE_GET) == 0);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == KEY_COUNT);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_GET_STATS) == 1);
+   ASSURE(SymTableTrace_percentile(SYMTABLE_TRACE_PUT, 0.5) <=
+      SymTableTrace_percentile(SYMTABLE_TRACE_PUT, 1.0));
+   /* A list is one bucket, which never grows. */
+   ASSURE(sEvents.uResizes > 0 || sStats.uBucketCount == 1);
+#else
+   ASSURE(countTraced(SYMTABLE_TRACE_PUT) == 0);
+   ASSURE(countTraced(SYMTABLE_TRACE_CONTAINS) == 0);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == 0);
+   ASSURE(sEvents.uCount == 0);
+   (void)sStats;
+#endif
+
+   /* Calls that a mapped function makes back into the table are part
+      of the map. */
+   SymTable_map(oSymTable, getAgain, oSymTable);
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   u = 0;
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+      u++;
+   ASSURE(u == KEY_COUNT);
+   SymTable_iterEnd(oIter);
+#ifdef SYMTABLE_TRACE
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_MAP) == 1);
+   ASSURE(countTraced(SYMTABLE_TRACE_MAP) == 1);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_GET) == 0);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_ITER_BEGIN) == 1);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_ITER_NEXT) ==
+      KEY_COUNT + 1);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_ITER_END) == 1);
+#else
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_MAP) == 0);
+#endif
+
+   /* A threshold of 0 reports every operation. */
+   sEvents.uCount = 0;
+   SymTableTrace_setSink(recordTraceEvent, 0, &sEvents);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+      SymTable_remove(oSymTable, acKey);
+   }
+   ASSURE(SymTable_upsert(oSymTable, "0", NULL, NULL));
+   ASSURE(SymTable_getOrInsert(oSymTable, "0", NULL) != NULL);
+#ifdef SYMTABLE_TRACE
+   ASSURE(sEvents.uCount == 2 * KEY_COUNT + 2);
+   ASSURE(countTraced(SYMTABLE_TRACE_REMOVE) == KEY_COUNT);
+   ASSURE(countTraced(SYMTABLE_TRACE_UPSERT) == 1);
+   ASSURE(countTraced(SYMTABLE_TRACE_GET_OR_INSERT) == 1);
+#else
+   ASSURE(sEvents.uCount == 0);
+#endif
+   SymTable_free(oSymTable);
+
+   /* Timing one put in KEY_COUNT / 4 times four of them, but still
+      counts them all and reports every resize. */
+   SymTableTrace_reset();
+   SymTableTrace_setSamplePeriod(KEY_COUNT / 4);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   sEvents.uCount = 0;
+   sEvents.uResizes = 0;
+   sEvents.oSymTable = oSymTable;
+   SymTableTrace_setSink(recordTraceEvent, (size_t)-1, &sEvents);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(sEvents.uCount == sEvents.uResizes);
+   SymTable_getStats(oSymTable, &sStats);
+   SymTable_free(oSymTable);
+#ifdef SYMTABLE_TRACE
+   ASSURE(countTraced(SYMTABLE_TRACE_PUT) == 4);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == KEY_COUNT);
+   ASSURE(sEvents.uResizes > 0 || sStats.uBucketCount == 1);
+#else
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == 0);
+#endif
+
+   /* Resizes by SymTable_putMany and SymTable_reserve are reported,
+      though each finishes by rehashing. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      apcKeys[i] = aacKeys[i];
+   }
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   sEvents.uCount = 0;
+   sEvents.uResizes = 0;
+   sEvents.oSymTable = oSymTable;
+   SymTableTrace_setSink(recordTraceEvent, (size_t)-1, &sEvents);
+   ASSURE(SymTable_putMany(oSymTable, apcKeys, apvValues, KEY_COUNT)
+      == KEY_COUNT);
+   ASSURE(sEvents.uCount == sEvents.uResizes);
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_TRACE
+   ASSURE(sEvents.uResizes > 0 || sStats.uBucketCount == 1);
+#endif
+   u = sStats.uBucketCount;
+   sEvents.uCount = 0;
+   sEvents.uResizes = 0;
+   iSuccessful = SymTable_reserve(oSymTable, KEY_COUNT * 4);
+   ASSURE(iSuccessful);
+   ASSURE(sEvents.uCount == sEvents.uResizes);
+   SymTable_getStats(oSymTable, &sStats);
+#ifdef SYMTABLE_TRACE
+   ASSURE(sEvents.uResizes > 0 || sStats.uBucketCount == u);
+#endif
+   SymTable_free(oSymTable);
+
+   SymTableTrace_setSink(NULL, 0, NULL);
+   SymTableTrace_setSamplePeriod(SYMTABLE_TRACE_DEFAULT_PERIOD);
+   SymTableTrace_reset();
+   ASSURE(countTraced(SYMTABLE_TRACE_REMOVE) == 0);
+   ASSURE(SymTableTrace_getCount(SYMTABLE_TRACE_PUT) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If *pvExtra, a const char*, is NULL, set it to pcKey. */
+
+static void recordFirstKey(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   const char **ppcFirstKey = (const char**)pvExtra;
+
+   (void)pvValue;
+   if (*ppcFirstKey == NULL)
+      *ppcFirstKey = pcKey;
+}
+
+/* Test SymTable_setOrder: lookups under each order find the same
+   bindings, however they rearrange them. */
+
+static void testOrder(void)
+{
+   enum {KEY_COUNT = 2000, LOOKUP_COUNT = 20000, MAX_KEY_LENGTH = 10};
+   static const enum SymTableOrder aeOrders[] = {
+      SYMTABLE_ORDER_FIXED, SYMTABLE_ORDER_MOVE_TO_FRONT,
+      SYMTABLE_ORDER_TRANSPOSE
+   };
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcFirstKey;
+   size_t uOrder;
+   int iSuccessful;
+   int i;
+   int iKey;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_setOrder.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (uOrder = 0; uOrder < sizeof(aeOrders) / sizeof(aeOrders[0]);
+      uOrder++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setOrder(oSymTable, aeOrders[uOrder]);
+
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, (void*)(size_t)i);
+         ASSURE(iSuccessful);
+      }
+
+      /* Skewed lookups: most go to the first few keys, which are the
+         deepest in a list. */
+      for (i = 0; i < LOOKUP_COUNT; i++)
+      {
+         iKey = (i % 10 != 0) ? i % 4 : (i * 7919) % (KEY_COUNT + 100);
+         sprintf(acKey, "%d", iKey);
+         if (iKey >= KEY_COUNT)
+         {
+            ASSURE(! SymTable_contains(oSymTable, acKey));
+            ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+            continue;
+         }
+         if (i % 3 == 0)
+            ASSURE(SymTable_get(oSymTable, acKey) ==
+               (void*)(size_t)iKey);
+         else if (i % 3 == 1)
+            ASSURE(SymTable_contains(oSymTable, acKey));
+         else
+            ASSURE(SymTable_replace(oSymTable, acKey,
+               (void*)(size_t)iKey) == (void*)(size_t)iKey);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+      /* A list is one chain, which SymTable_map walks in order. */
+      SymTable_getStats(oSymTable, &sStats);
+      if (sStats.uBucketCount == 1)
+      {
+         ASSURE(SymTable_get(oSymTable, "5") == (void*)5);
+         pcFirstKey = NULL;
+         SymTable_map(oSymTable, recordFirstKey, &pcFirstKey);
+         ASSURE(pcFirstKey != NULL);
+         if (aeOrders[uOrder] == SYMTABLE_ORDER_MOVE_TO_FRONT)
+            ASSURE(strcmp(pcFirstKey, "5") == 0);
+         if (aeOrders[uOrder] == SYMTABLE_ORDER_FIXED)
+            ASSURE(strcmp(pcFirstKey, "1999") == 0);
+      }
+
+      /* Every binding is still found, and can be removed. */
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == (void*)(size_t)i);
+      }
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) ==
+            (void*)(size_t)i);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test many small SymTable objects, and small objects that grow into
+   large ones while being walked. */
+
+static void testSmallTables(void)
+{
+   enum {TABLE_COUNT = 1000, SMALL_COUNT = 3, KEY_COUNT = 100,
+      MAX_KEY_LENGTH = 10};
+
+   SymTable_T aoSymTables[TABLE_COUNT];
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   size_t uSeen;
+   int iSuccessful;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing small SymTable objects.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      aoSymTables[i] = (i % 2 == 0) ? SymTable_new() :
+         SymTable_newArena();
+      ASSURE(aoSymTables[i] != NULL);
+      for (j = 0; j < SMALL_COUNT; j++)
+      {
+         sprintf(acKey, "%d", j);
+         iSuccessful = SymTable_put(aoSymTables[i], acKey,
+            (void*)(size_t)(i + j));
+         ASSURE(iSuccessful);
+      }
+   }
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      ASSURE(SymTable_getLength(aoSymTables[i]) == SMALL_COUNT);
+      for (j = 0; j < SMALL_COUNT; j++)
+      {
+         sprintf(acKey, "%d", j);
+         ASSURE(SymTable_get(aoSymTables[i], acKey) ==
+            (void*)(size_t)(i + j));
+      }
+      ASSURE(! SymTable_contains(aoSymTables[i], "x"));
+      SymTable_free(aoSymTables[i]);
+   }
+
+   /* A walk started while the table is small sees every binding
+      exactly once as the table grows, and removals shrink it back. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "a", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "b", NULL);
+   ASSURE(iSuccessful);
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterNext(oIter, &pcKey, &pvValue));
+   uSeen = 1;
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+      uSeen++;
+   SymTable_iterEnd(oIter);
+   /* Bindings put before the walk's position are not seen. */
+   ASSURE(uSeen <= KEY_COUNT + 2);
+   ASSURE(uSeen >= 2);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(SymTable_contains(oSymTable, "a"));
+   ASSURE(SymTable_contains(oSymTable, "b"));
+   SymTable_free(oSymTable);
+
+   /* Reserving room in a small table keeps its bindings. */
+   oSymTable = SymTable_newWithCapacity(2);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "a", "A");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_reserve(oSymTable, 4));
+   ASSURE(SymTable_reserve(oSymTable, 2 * KEY_COUNT));
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "a"), "A") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_upsert and SymTable_getOrInsert. */
+
+static void testUpsert(void)
+{
+   enum {KEY_COUNT = 2000, ROUND_COUNT = 3, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   void **ppvValue;
+   void *pvOldValue;
+   int iSuccessful;
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_upsert and SymTable_getOrInsert.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* The first upsert of a key adds it; later ones replace it. */
+   iSuccessful = SymTable_upsert(oSymTable, "Ruth", "Right Field",
+      &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(pvOldValue == NULL);
+   iSuccessful = SymTable_upsert(oSymTable, "Ruth", "Pitcher",
+      &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(strcmp((char*)pvOldValue, "Right Field") == 0);
+   iSuccessful = SymTable_upsert(oSymTable, "Ruth", NULL, NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(SymTable_get(oSymTable, "Ruth") == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   /* getOrInsert leaves an existing value alone. */
+   ppvValue = SymTable_getOrInsert(oSymTable, "Ruth", "Outfield");
+   ASSURE(ppvValue != NULL);
+   ASSURE(*ppvValue == NULL);
+   *ppvValue = "Outfield";
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "Ruth"),
+      "Outfield") == 0);
+   SymTable_remove(oSymTable, "Ruth");
+
+   /* Count occurrences in place, through enough growth to move
+      every binding a few times. */
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+   {
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ppvValue = SymTable_getOrInsert(oSymTable, acKey, NULL);
+         ASSURE(ppvValue != NULL);
+         ASSURE(*ppvValue == (void*)(size_t)iRound);
+         *ppvValue = (void*)((size_t)*ppvValue + 1);
+      }
+   }
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) ==
+         (void*)(size_t)ROUND_COUNT);
+      iSuccessful = SymTable_upsert(oSymTable, acKey,
+         (void*)(size_t)i, &pvOldValue);
+      ASSURE(iSuccessful);
+      ASSURE(pvOldValue == (void*)(size_t)ROUND_COUNT);
+   }
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == (void*)(size_t)i);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The calls that testRemoveIf's functions have seen. */
+
+struct RemoveIfCalls
+{
+   size_t uPredicateCalls;
+   size_t uRemovedCalls;
+   size_t uDivisor;
+};
+
+/* Return 1 (TRUE) if pvValue, a number, is a multiple of the divisor
+   in the RemoveIfCalls object pvExtra, counting the call there. */
+
+static int isMultiple(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct RemoveIfCalls *psCalls = (struct RemoveIfCalls*)pvExtra;
+
+   ASSURE(pcKey != NULL);
+   psCalls->uPredicateCalls++;
+   return (size_t)pvValue % psCalls->uDivisor == 0;
+}
+
+/* Check that pcKey and pvValue are a binding that isMultiple chose,
+   counting the call in the RemoveIfCalls object pvExtra. */
+
+static void checkRemoved(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct RemoveIfCalls *psCalls = (struct RemoveIfCalls*)pvExtra;
+
+   ASSURE((size_t)pvValue % psCalls->uDivisor == 0);
+   ASSURE((size_t)atoi(pcKey) == (size_t)pvValue);
+   psCalls->uRemovedCalls++;
+}
+
+/* Test SymTable_removeIf. */
+
+static void testRemoveIf(void)
+{
+   enum {KEY_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct RemoveIfCalls sCalls;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uRemoved;
+   size_t uLength;
+   int iSuccessful;
+   int iArena;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_removeIf.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iArena = 0; iArena < 2; iArena++)
+   {
+      oSymTable = iArena ? SymTable_newArena() : SymTable_new();
+      ASSURE(oSymTable != NULL);
+
+      sCalls.uPredicateCalls = 0;
+      sCalls.uRemovedCalls = 0;
+      sCalls.uDivisor = 1;
+      ASSURE(SymTable_removeIf(oSymTable, isMultiple, checkRemoved,
+         &sCalls) == 0);
+      ASSURE(sCalls.uPredicateCalls == 0);
+
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey,
+            (void*)(size_t)i);
+         ASSURE(iSuccessful);
+      }
+
+      /* Remove every third binding, then every other one of the
+         rest, then all of them. */
+      sCalls.uPredicateCalls = 0;
+      sCalls.uDivisor = 3;
+      uRemoved = SymTable_removeIf(oSymTable, isMultiple,
+         checkRemoved, &sCalls);
+      ASSURE(uRemoved == (KEY_COUNT + 2) / 3);
+      ASSURE(sCalls.uPredicateCalls == KEY_COUNT);
+      ASSURE(sCalls.uRemovedCalls == uRemoved);
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT - uRemoved);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey) == (i % 3 != 0));
+         if (i % 3 != 0)
+            ASSURE(SymTable_get(oSymTable, acKey) ==
+               (void*)(size_t)i);
+      }
+
+      uLength = SymTable_getLength(oSymTable);
+      sCalls.uPredicateCalls = 0;
+      sCalls.uRemovedCalls = 0;
+      sCalls.uDivisor = 2;
+      uRemoved = SymTable_removeIf(oSymTable, isMultiple, NULL,
+         &sCalls);
+      ASSURE(sCalls.uPredicateCalls == uLength);
+      ASSURE(sCalls.uRemovedCalls == 0);
+      ASSURE(SymTable_getLength(oSymTable) == uLength - uRemoved);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey) ==
+            (i % 3 != 0 && i % 2 != 0));
+      }
+
+      /* The table is still usable once emptied. */
+      sCalls.uDivisor = 1;
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(SymTable_removeIf(oSymTable, isMultiple, checkRemoved,
+         &sCalls) == uLength);
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+      iSuccessful = SymTable_put(oSymTable, "0", NULL);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_contains(oSymTable, "0"));
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -960,6 +3309,26 @@ int main(int argc, char *argv[])
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testArena();
+   testNewWithHash();
+   testLengthKeys();
+   testHashedKeys();
+   testGetMany();
+   testCapacity();
+   testShrink();
+   testConcurrent();
+   testReadMostly();
+   testMapParallel();
+   testIterator();
+   testRange();
+   testIntern();
+   testImage();
+   testStats();
+   testTrace();
+   testOrder();
+   testSmallTables();
+   testUpsert();
+   testRemoveIf();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");